@@ -2,51 +2,138 @@
 #define AUDIO_PLAYER_H
 
 #include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 #include "Audio.h"
+#include "jitter_buffer.h"
+#include "stream_source.h"
+#include "standby_manager.h"
+#include "stream_session.h"
 
 // Forward declaration
 class FMTransmitter;
 
+// Streaming runs in two pinned FreeRTOS tasks:
+//   network task - StreamSession reads the socket (or HLS segments) into the ring
+//   decoder task - Audio decodes from the ring and drives I2S
+// The public methods only post requests to those tasks, so a slow UI pass
+// or a blocking HTTP call in the main loop can no longer starve playback.
 class AudioPlayer {
 public:
     AudioPlayer();
     ~AudioPlayer();
-    
+
+    // Jitter buffer length; call before begin()
+    void setJitterBufferSeconds(uint8_t seconds);
+
     bool begin();
-    
+
     // Link to FM transmitter for RDS updates
     void setFMTransmitter(FMTransmitter* fm);
-    
-    // Playback control
+
+    // Playback control (asynchronous; errors are reported by getLastError)
     bool play(const String& url);
     void stop();
     void pause();
     void resume();
-    
+
     // Volume control (0-21)
     void setVolume(uint8_t volume);
     uint8_t getVolume();
-    
-    // Status
+
+    // Status; a stream paused at the low watermark is still playing, and
+    // isBuffering() tells the two apart
     bool isPlaying();
+    // A stream is open, playing or filling the buffer: from play() until
+    // stop() or a failed open
+    bool isStreamActive();
     String getCurrentTitle();
     String getCurrentArtist();
+    String getLastError();
+
+    // Jitter buffer status
+    uint8_t getBufferFill();        // Percent of capacity
+    size_t getBufferedBytes();
+    uint32_t getBufferedMs();       // Estimated from AUDIO_JITTER_KBPS
+    bool isBuffering();             // Waiting for the high watermark
+    uint32_t getUnderrunCount();
     
-    // Metadata updates (called by audio callbacks)
+    // The network task reads in bursts: once the buffer is full it stops
+    // until the fill drops to the burst low mark, and the radio may sleep
+    bool isRadioResting();
+
+    // HLS segment download times in ms (0 for plain streams)
+    uint32_t getLastSegmentMs();
+    uint32_t getAverageSegmentMs();
+
+    // Streams to keep connected for instant switching, most important first
+    void setStandbyUrls(const std::vector<String>& urls);
+    size_t getWarmStreamCount();
+
+    // Time from play() to the decoder starting on the new stream
+    uint32_t getLastZapLatencyMs();
+    bool wasLastZapWarm();
+
+    // Metadata updates (called by audio callbacks, from any task)
     void updateMetadata(const String& title, const String& artist);
     void updateStationName(const String& station);
-    
-    // Update loop
+
+    // Update loop (main task): forwards metadata to the FM transmitter
     void loop();
-    
+
 private:
     Audio audio;
-    bool playing;
+    std::atomic<bool> playing;     // Cleared by the network task when opening fails
     uint8_t currentVolume;
     String currentTitle;
     String currentArtist;
     String currentStation;
     FMTransmitter* fmTransmitter;  // Pointer to FM transmitter for RDS
+
+    // Network -> decoder pipeline
+    JitterBuffer jitter;
+    uint8_t* ringStorage;
+    uint8_t jitterSeconds;
+    std::shared_ptr<RingStreamFS> ringFsImpl;
+    fs::FS ringFs;
+    StreamSession* session;
+    StandbyManager standby;
+    String activeUrl;
+
+    SemaphoreHandle_t audioLock;   // Guards audio and the decoder state
+    SemaphoreHandle_t stateLock;   // Guards requests and strings shared with the main task
+    TaskHandle_t decoderTask;
+    TaskHandle_t networkTask;
+
+    String pendingUrl;
+    bool pendingPlay;
+    bool pendingStop;
+    std::vector<String> pendingStandby;
+    bool standbyDirty;
+    uint32_t zapStartMs;
+    uint32_t lastZapMs;
+    bool lastZapWarm;
+    bool decoderArmed;
+    bool decoderStarted;
+    std::atomic<bool> bufferPaused;  // Decoder held at the low watermark
+    std::atomic<bool> radioResting;
+    const char* decoderPath;
+    bool metadataDirty;
+    bool stationDirty;
+    String lastError;
+
+    static void decoderTaskEntry(void* arg);
+    static void networkTaskEntry(void* arg);
+    void decoderLoop();
+    void networkLoop();
+    void startStream(const String& url);
+    void stopStream();
+    void haltDecoder();
+    void attachSession();
+    void updateRadioRest();
+    void setError(const String& error);
 };
 
 // Global instance for callbacks
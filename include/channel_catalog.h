@@ -0,0 +1,49 @@
+#ifndef CHANNEL_CATALOG_H
+#define CHANNEL_CATALOG_H
+
+#include <Arduino.h>
+#include "channel_store.h"
+
+// Channel line-up cached on LittleFS so boot can draw the main screen and
+// start the last channel before the network is up.
+//
+// File layout (little-endian), read and written on the host by
+// tools/catalog_tool.py:
+//
+//   char[4]  magic "SXMC"
+//   uint16   version (CATALOG_VERSION)
+//   uint16   reserved, 0
+//   uint32   channel count
+//   uint32   CRC-32 of everything after the header
+//   strings  ETag and Last-Modified of the fetch it came from (version 2+)
+//   records  per channel: id, name, number, genre, logoUrl, streamUrl
+//
+// Every string is a uint8 length followed by that many bytes.
+class ChannelCatalog {
+public:
+    ChannelCatalog();
+
+    // Mount LittleFS, formatting it if it has never been used
+    bool begin();
+
+    // Replaces channels only if a complete, valid catalog was read
+    bool load(ChannelStore& channels);
+    bool save(const ChannelStore& channels, const String& etag, const String& lastModified);
+    void clear();
+
+    // HTTP validators of the loaded catalog, for a conditional refresh
+    String getETag();
+    String getLastModified();
+
+    uint32_t getLoadMs();
+    String getLastError();
+
+private:
+    bool mounted;
+    String etag;
+    String lastModified;
+    uint32_t loadMs;
+    String lastError;
+};
+
+#endif // CHANNEL_CATALOG_H
@@ -0,0 +1,58 @@
+#ifndef CHANNEL_SEARCH_H
+#define CHANNEL_SEARCH_H
+
+#include <Arduino.h>
+#include <vector>
+#include "channel_store.h"
+
+// Prefix search over channel names, numbers and genres.
+//
+// Every word of every name and genre, plus each channel number, becomes a
+// token pointing back at its channel. Tokens reference the text where it
+// already lives (the ChannelStore arena, or flash for the internet radio
+// stations) and are kept sorted case-insensitively, so a query word is a
+// binary search plus a scan over the tokens it prefixes. A multi-word
+// query keeps the channels that match every word.
+//
+// Items 0..getChannelCount()-1 are SXM channels in store order; the
+// internet radio stations follow. Rebuild whenever the store changes or is
+// swapped for another: tokens point into the arena it had when built.
+class ChannelSearchIndex {
+public:
+    ChannelSearchIndex();
+
+    void build(const ChannelStore& channels);
+    void clear();
+
+    // Matching items in order, at most maxResults; returns the total count
+    size_t search(const String& query, std::vector<uint16_t>& results, size_t maxResults);
+
+    bool isStation(uint16_t item) const { return item >= channelCount; }
+    uint16_t stationIndex(uint16_t item) const { return item - channelCount; }
+    size_t getChannelCount() const { return channelCount; }
+
+    size_t getTokenCount() const { return tokens.size(); }
+    size_t getMemoryUsage() const;
+    uint32_t getLastQueryMicros() const { return lastQueryMicros; }
+
+private:
+    struct Token {
+        const char* text;  // Not NUL-terminated at len
+        uint8_t len;
+        uint16_t item;
+    };
+
+    std::vector<Token> tokens;
+    std::vector<char> numberText;  // Decimal channel numbers, NUL-separated
+    std::vector<uint32_t> matches;  // Bitmap per item, reused between queries
+    std::vector<uint32_t> wordMatches;
+    size_t channelCount;
+    size_t itemCount;
+    uint32_t lastQueryMicros;
+
+    void addTokens(const char* text, uint16_t item);
+    void matchPrefix(const char* word, size_t len, std::vector<uint32_t>& bitmap);
+    static int compare(const char* a, size_t aLen, const char* b, size_t bLen);
+};
+
+#endif // CHANNEL_SEARCH_H
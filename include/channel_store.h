@@ -0,0 +1,127 @@
+#ifndef CHANNEL_STORE_H
+#define CHANNEL_STORE_H
+
+#include <Arduino.h>
+
+// One channel as parsed from the server or the catalog, before it is added
+// to a ChannelStore
+struct SXMChannel {
+    String id;
+    String name;
+    String number;
+    String genre;
+    String logoUrl;
+    String streamUrl;
+};
+
+// Compact storage for the channel line-up.
+//
+// All strings live in one growable arena (PSRAM when available) and every
+// channel is a fixed-size record of arena offsets, a uint16 channel number
+// and an index into a table of interned genres. A line-up is a handful of
+// allocations instead of six heap Strings per channel. Channels are read
+// through Channel views that point into the store, so nothing is copied.
+//
+// Lookups by id and by channel number go through open-addressing hash
+// tables that are kept up to date as channels are added, so they cost the
+// same for ten channels as for ten thousand.
+class ChannelStore {
+private:
+    struct Record;
+
+public:
+    // Read-only view of one channel; valid until the store changes
+    class Channel {
+    public:
+        Channel() : store(nullptr), index(0) {}
+        Channel(const ChannelStore* store, size_t index) : store(store), index(index) {}
+
+        explicit operator bool() const { return store && index < store->count; }
+        size_t getIndex() const { return index; }
+
+        const char* id() const { return store->str(record().id); }
+        const char* name() const { return store->str(record().name); }
+        uint16_t number() const { return record().number; }
+        const char* genre() const { return store->genreName(record().genre); }
+        const char* logoUrl() const { return store->str(record().logoUrl); }
+        const char* streamUrl() const { return store->str(record().streamUrl); }
+
+    private:
+        const ChannelStore* store;
+        size_t index;
+
+        const Record& record() const { return store->records[index]; }
+    };
+
+    ChannelStore();
+    ~ChannelStore();
+    ChannelStore(const ChannelStore&) = delete;
+    ChannelStore& operator=(const ChannelStore&) = delete;
+
+    void clear();
+    void reserve(size_t channels, size_t arenaBytes);
+    // Give back what growing by doubling left unused, once loading is done
+    void shrinkToFit();
+    void swap(ChannelStore& other);
+    // Swap in other only if it differs, so views and search tokens into an
+    // unchanged line-up stay valid; returns whether it was swapped
+    bool replace(ChannelStore& other);
+
+    // Returns false if out of memory
+    bool add(const SXMChannel& channel);
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    Channel operator[](size_t index) const { return Channel(this, index); }
+
+    // Hashed lookups; the returned view is false if there is no match
+    Channel findById(const char* id) const;
+    Channel findByNumber(uint16_t number) const;
+
+    // Same channels with the same fields, in the same order
+    bool equals(const ChannelStore& other) const;
+
+    // Heap used by the store, for comparing against per-channel Strings
+    size_t getMemoryUsage() const;
+    size_t getGenreCount() const { return genreCount; }
+
+private:
+    struct Record {
+        uint32_t id;         // Arena offsets
+        uint32_t name;
+        uint32_t logoUrl;
+        uint32_t streamUrl;
+        uint16_t number;
+        uint16_t genre;      // Index into genres
+    };
+
+    Record* records;
+    size_t count;
+    size_t recordCapacity;
+
+    char* arena;
+    size_t arenaSize;
+    size_t arenaCapacity;
+
+    uint32_t* genres;        // Arena offsets of the interned genre names
+    size_t genreCount;
+    size_t genreCapacity;
+
+    uint16_t* idIndex;       // Slots hold record index + 1, 0 is empty
+    uint16_t* numberIndex;
+    size_t indexCapacity;    // Power of two, at least twice count
+
+    const char* str(uint32_t offset) const { return arena + offset; }
+    const char* genreName(uint16_t genre) const { return genre < genreCount ? str(genres[genre]) : ""; }
+
+    bool intern(const String& value, uint32_t& offset);
+    bool internGenre(const String& genre, uint16_t& index);
+    bool reindex(size_t needed);
+    void indexRecord(size_t index);
+    static uint32_t hashString(const char* s);
+    static uint32_t hashNumber(uint16_t number);
+    static bool grow(void** buffer, size_t& capacity, size_t needed, size_t elementSize);
+    static void shrink(void** buffer, size_t& capacity, size_t needed, size_t elementSize);
+};
+
+#endif // CHANNEL_STORE_H
@@ -9,6 +9,7 @@
 #define TFT_DC   2
 #define TFT_RST  4
 #define TOUCH_CS 21
+#define TOUCH_IRQ -1  // XPT2046 T_IRQ (e.g. 34); -1 samples the panel instead
 
 // Pin Definitions for I2C (FM Transmitter)
 #define I2C_SDA 21
@@ -22,6 +23,35 @@
 // Display Settings
 #define SCREEN_WIDTH  320
 #define SCREEN_HEIGHT 240
+#define UI_USE_SPRITE       true  // Compose in a PSRAM sprite when PSRAM is present
+#define UI_FLUSH_BAND_LINES 16    // Rows per DMA flush band (10 KB bounce buffers)
+#define UI_TEXT_CACHE_BYTES (256 * 1024)  // Rasterized strings kept in PSRAM
+#define UI_TEXT_MAX_HEIGHT  32    // Tallest text line, large font included
+#define UI_FONT_SMALL_PATH  "/fonts/small.vlw"   // Text size 1; built-in font if missing
+#define UI_FONT_MEDIUM_PATH "/fonts/medium.vlw"  // Text size 2
+#define UI_FONT_LARGE_PATH  "/fonts/large.vlw"   // Text size 3
+#define UI_TOAST_W          260   // Non-blocking notice, centered on the screen
+#define UI_TOAST_H          40
+#define UI_TOAST_X          ((SCREEN_WIDTH - UI_TOAST_W) / 2)
+#define UI_TOAST_Y          ((SCREEN_HEIGHT - UI_TOAST_H) / 2)
+
+// Touch gestures
+#define TOUCH_QUEUE_SIZE     16    // Events held until a handler takes them
+#define TOUCH_SAMPLE_MS      20    // Idle sampling interval without TOUCH_IRQ
+#define TOUCH_RELEASE_MS     40    // No contact for this long...
+#define TOUCH_RELEASE_SAMPLES 2    // ...and for this many samples in a row is a release
+#define TOUCH_REPRESS_MS     80    // A press this soon after a release is bounce
+#define TOUCH_TAP_SLOP_PX    12    // Movement still counted as a tap
+#define TOUCH_DRAG_STEP_PX   8     // Movement per DRAG event
+#define TOUCH_SWIPE_MIN_PX   60    // A swipe travels at least this far...
+#define TOUCH_SWIPE_MAX_MS   400   // ...within this time
+
+// List scrolling
+#define UI_FRAME_MS             25     // Loop period while a list moves (40 fps)
+#define UI_LIST_FLING_TAU_MS    325.0  // A fling loses 63% of its speed in this time
+#define UI_LIST_MIN_VELOCITY    0.02   // px/ms; slower than this the fling stops
+#define UI_LIST_MAX_VELOCITY    4.0    // px/ms a fling can start with
+#define UI_LIST_FLING_IDLE_MS   100    // Held still this long before lifting: no fling
 
 // FM Transmitter Settings
 #define FM_MIN_FREQ 87.5
@@ -32,10 +62,85 @@
 #define AUDIO_BUFFER_SIZE 1024
 #define AUDIO_SAMPLE_RATE 44100
 
+// Audio Pipeline (network task -> ring buffer -> decoder task)
+#define AUDIO_RING_SIZE       (64 * 1024)  // Fallback ring when PSRAM is missing
+#define AUDIO_JITTER_SECONDS  8            // PSRAM jitter buffer length
+#define AUDIO_JITTER_KBPS     256          // Stream bitrate used to size the buffer
+#define AUDIO_JITTER_LOW_PCT  10           // Pause decoding below this fill
+#define AUDIO_JITTER_HIGH_PCT 50           // Start/resume decoding at this fill
+#define AUDIO_TASK_CORE       1            // Decoder task, off the WiFi core
+#define AUDIO_TASK_PRIORITY   10
+#define AUDIO_TASK_STACK      8192
+#define NET_TASK_CORE         0            // Network task, next to the WiFi stack
+#define NET_TASK_PRIORITY     5
+#define NET_TASK_STACK        8192
+#define NET_TASK_IDLE_MS      5            // Sleep when the socket has nothing
+#define NET_TASK_REST_MS      50           // Sleep between fill checks while the radio rests
+#define AUDIO_BURST_RECEIVE   true         // Read in bursts so the WiFi modem can sleep
+#define AUDIO_BURST_HIGH_PCT  90           // Stop reading at this fill...
+#define AUDIO_BURST_LOW_PCT   40           // ...and burst again at this one
+#define STREAM_CHUNK_SIZE     1460         // One TCP segment per socket read
+#define STREAM_VIRTUAL_SIZE   0x7FFFFFFFUL // Size the decoder sees for a live stream
+
+// HLS
+#define HLS_PREFETCH_SEGMENTS   3             // Segment downloads kept in flight
+#define HLS_SEGMENT_BUFFER_SIZE (128 * 1024)  // PSRAM prefetch buffer per download
+#define HLS_LIVE_START_SEGMENTS 3             // Start this many segments from the live edge
+#define HLS_KEY_CACHE_MAX       4             // AES-128 keys kept per stream, by key URI
+
+// Warm standby streams for instant channel changes
+#define STANDBY_PSRAM_BUDGET     (256 * 1024)  // PSRAM shared by all standby streams
+#define STANDBY_BUFFER_SIZE      (64 * 1024)   // Rolling buffer per standby stream
+#define STANDBY_MAX_STREAMS      4             // Upper bound regardless of budget
+#define STANDBY_OPEN_INTERVAL_MS 2000          // At most one new connection per interval
+#define STANDBY_RETRY_MS         30000         // Back-off after a standby stream fails
+#define STANDBY_RECENT_CHANNELS  2             // Recently played channels kept warm
+#define STANDBY_TASK_CORE        0             // Opens standby streams off the audio network task
+#define STANDBY_TASK_PRIORITY    4             // Below the network task, above SXM requests
+#define STANDBY_TASK_STACK       8192
+
 // Network Settings
 #define WIFI_TIMEOUT_MS 20000
 #define HTTP_TIMEOUT_MS 10000
 
+// WiFi scan
+#define WIFI_SCAN_CHANNELS       13   // 2.4 GHz channels swept, one at a time
+#define WIFI_SCAN_MS_PER_CHANNEL 120  // Active scan dwell per channel
+
+// WiFi modem sleep, following the audio bursts. The mA figures are typical
+// values for the ESP32 radio, not measurements of this board; the power
+// report weights them by time in each mode
+#define WIFI_RADIO_ACTIVE_MA  100     // Typical radio draw awake
+#define WIFI_RADIO_SLEEP_MA   20      // Typical average in max modem sleep
+#define WIFI_RADIO_IDLE_MA    40      // Typical average in min modem sleep (Arduino default)
+#define POWER_REPORT_MS       60000   // Power and underrun report interval
+
+// WiFi roaming between saved networks
+#define WIFI_MAX_NETWORKS            5       // Saved networks, lowest priority dropped beyond this
+#define WIFI_ROAM_SAMPLE_MS          1000    // RSSI sampling interval
+#define WIFI_ROAM_SAMPLES            8       // RSSI samples the trend is taken over
+#define WIFI_ROAM_RSSI_DBM           -72     // Look for a better AP below this while falling
+#define WIFI_ROAM_TREND_DB           4       // Fall over the sample window that counts as falling
+#define WIFI_ROAM_CRITICAL_DBM       -80     // Look for a better AP below this regardless of trend
+#define WIFI_ROAM_USABLE_DBM         -70     // Candidates must be at least this strong
+#define WIFI_ROAM_HYSTERESIS_DB      8       // ... and this much stronger than the current link
+#define WIFI_ROAM_SCAN_INTERVAL_MS   30000   // Between roaming scans
+#define WIFI_ROAM_MIN_BUFFER_MS      4000    // Buffered audio needed before a handoff
+#define WIFI_ROAM_BUFFER_WAIT_MS     15000   // Give up on a candidate if the buffer never gets there
+#define WIFI_ROAM_HANDOFF_TIMEOUT_MS 8000    // Handoff not done by then: go back
+
+// WiFi fast reconnect
+#define WIFI_FAST_CONNECT_MS 3000    // Give the stored BSSID/channel this long before scanning
+#define WIFI_REUSE_IP        false   // Also reuse the last IP configuration, skipping DHCP
+#define WIFI_HINT_NAMESPACE  "wifi_hint"
+#define KEY_WIFI_HINT_SSID    "ssid"
+#define KEY_WIFI_HINT_BSSID   "bssid"
+#define KEY_WIFI_HINT_CHANNEL "channel"
+#define KEY_WIFI_HINT_IP      "ip"
+#define KEY_WIFI_HINT_GATEWAY "gateway"
+#define KEY_WIFI_HINT_SUBNET  "subnet"
+#define KEY_WIFI_HINT_DNS     "dns"
+
 // SiriusXM Mode
 // Set to true to use local m3u8XM server (Raspberry Pi/home server)
 // Set to false to call SiriusXM API directly from ESP32 (not fully implemented)
@@ -46,11 +151,17 @@
 #define PREF_NAMESPACE "sxm_radio"
 #define KEY_WIFI_SSID "wifi_ssid"
 #define KEY_WIFI_PASS "wifi_pass"
+#define KEY_WIFI_COUNT "wifi_n"         // Saved network list: count, then
+#define KEY_WIFI_SSID_N "wifi_s"        // per-entry keys with the index appended
+#define KEY_WIFI_PASS_N "wifi_p"
+#define KEY_WIFI_PRIO_N "wifi_r"
 #define KEY_SXM_EMAIL "sxm_email"
 #define KEY_SXM_PASS "sxm_pass"
 #define KEY_SXM_SERVER "sxm_server"
 #define KEY_FM_FREQ "fm_freq"
 #define KEY_LAST_CHANNEL "last_ch"
+#define KEY_LAST_STREAM_ID "last_sid"
+#define KEY_LAST_STREAM_URL "last_surl"
 
 // UI Colors (RGB565)
 #define COLOR_BLACK       0x0000
@@ -77,5 +188,37 @@
 #define SXM_SERVER_LOGIN "/api/login"
 #define SXM_SERVER_CHANNELS "/api/channels"
 #define SXM_SERVER_STREAM "/api/stream"
+#define SXM_CHANNEL_JSON_SIZE 512  // Per-channel document for the streaming channel list parser
+
+// Stream URL cache (server mode)
+#define SXM_STREAM_URL_TTL_MS        (30UL * 60 * 1000)  // Used when the server gives no expiry
+#define SXM_STREAM_URL_REFRESH_PCT   80                  // Refresh in the background after this much of the TTL
+#define SXM_STREAM_URL_REFRESH_MS    5000                // At most one background refresh per interval
+#define SXM_STREAM_URL_CACHE_MAX     16                  // Entries kept, least recently used evicted
+
+// SXM requests off the UI task
+#define SXM_ASYNC_WORKERS            2                   // Requests in flight at once, one HTTPClient each
+#define SXM_ASYNC_QUEUE              8                   // Requests waiting for a worker
+#define SXM_TASK_CORE                0                   // Next to the WiFi stack
+#define SXM_TASK_PRIORITY            3                   // Below the audio network task
+#define SXM_TASK_STACK               8192
+
+// Channel catalog cache (LittleFS)
+#define CATALOG_PATH                 "/catalog.bin"
+#define CATALOG_TMP_PATH             "/catalog.tmp"      // Written first, then renamed over CATALOG_PATH
+#define CATALOG_VERSION              2                   // 2 added HTTP validators
+#define CATALOG_MAX_CHANNELS         2000                // Sanity limit when loading
+
+// Channel search
+#define SEARCH_MAX_TOKENS            8192                // Index entries (8 bytes each)
+#define SEARCH_VISIBLE_RESULTS       3                   // Result rows above the keyboard
+
+// TLS session resumption (SXM API and HTTPS streams)
+#define TLS_SESSION_CACHE_MAX        8                   // Hosts whose sessions are kept
+#define TLS_SESSION_TTL_MS           (60UL * 60 * 1000)  // Sessions older than this are not offered
+
+// SXM API connection reuse
+#define HTTP_POOL_MAX_CONNECTIONS    4                   // Keep-alive connections held open (one per host)
+#define HTTP_POOL_IDLE_MS            15000               // Close pooled connections idle this long
 
 #endif // CONFIG_H
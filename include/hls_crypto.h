@@ -0,0 +1,82 @@
+#ifndef HLS_CRYPTO_H
+#define HLS_CRYPTO_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <mbedtls/aes.h>
+#include <vector>
+
+// Streaming AES-128-CBC decryption for HLS segments (EXT-X-KEY
+// METHOD=AES-128).
+//
+// Ciphertext is decrypted in place as it comes off the socket, in runs of
+// whole blocks. The last block is held back until the segment ends so its
+// PKCS#7 padding can be stripped. mbedtls runs on the ESP32 AES peripheral
+// when the IDF is built with hardware AES (the default), and in software
+// otherwise, so the same code runs on a host.
+class SegmentDecryptor {
+public:
+    // Room the caller leaves in front of the ciphertext for update()
+    static const size_t HEADROOM = 32;
+
+    SegmentDecryptor();
+    ~SegmentDecryptor();
+    SegmentDecryptor(const SegmentDecryptor&) = delete;
+    SegmentDecryptor& operator=(const SegmentDecryptor&) = delete;
+
+    void begin(const uint8_t key[16], const uint8_t iv[16]);
+
+    // Decrypts the len ciphertext bytes at buf + HEADROOM and writes the
+    // plaintext from buf. Returns the plaintext bytes written, at most
+    // len + 15 (a block held from an earlier call).
+    size_t update(uint8_t* buf, size_t len);
+
+    // End of the segment: the held-back block with its padding removed.
+    // Returns its length (0-16), or -1 if the segment was truncated or the
+    // padding is bad (wrong key or IV).
+    int finish(uint8_t out[16]);
+
+    // Decrypt throughput over the life of this object
+    uint32_t getBytes();
+    uint32_t getMicros();
+
+private:
+    mbedtls_aes_context aes;
+    uint8_t iv[16];
+    uint8_t partial[16];  // Ciphertext of an unfinished block
+    size_t partialLen;
+    uint8_t held[16];     // Plaintext of the last whole block
+    bool haveHeld;
+    uint32_t bytes;
+    uint32_t micros;
+};
+
+// AES-128 keys by key URI, fetched on first use.
+//
+// Segments of a stream share one key URI for long stretches, so each key
+// is downloaded once instead of once per segment. Runs on the network
+// task; the least recently used key is dropped when the cache is full.
+class HlsKeyCache {
+public:
+    HlsKeyCache();
+
+    // The 16-byte key for uri, or nullptr if it cannot be loaded
+    const uint8_t* get(const String& uri);
+    void clear();
+    String getLastError();
+
+private:
+    struct Entry {
+        String uri;
+        uint8_t key[16];
+        uint32_t lastUsed;
+    };
+
+    std::vector<Entry> entries;
+    HTTPClient http;
+    String lastError;
+
+    bool fetch(const String& uri, uint8_t key[16]);
+};
+
+#endif // HLS_CRYPTO_H
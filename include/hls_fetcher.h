@@ -0,0 +1,90 @@
+#ifndef HLS_FETCHER_H
+#define HLS_FETCHER_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include "config.h"
+#include "hls_crypto.h"
+#include "http_body_stream.h"
+#include "hls_playlist.h"
+#include "ring_buffer.h"
+
+// Native HLS engine for the network task.
+//
+// Keeps HLS_PREFETCH_SEGMENTS segment downloads in flight at once. The
+// oldest segment streams straight into the ring; the ones behind it are
+// buffered in PSRAM until they reach the head, so a segment boundary never
+// waits on a fresh request. The playlist is refreshed on its own
+// connection while segments download, and every connection is kept alive
+// and reused for the next segment. AES-128 segments are decrypted as they
+// are read, before they reach the ring or a prefetch buffer.
+class HlsFetcher {
+public:
+    HlsFetcher();
+    ~HlsFetcher();
+
+    // Start from the response to the initial playlist GET
+    bool begin(const String& playlistUrl, HTTPClient& response);
+    void close();
+    bool isOpen();
+
+    // Returns audio bytes delivered, or -1 once an ended playlist is done
+    int pump(RingBuffer& ring);
+
+    // Segment downloads kept in flight (1 disables prefetch buffers)
+    void setMaxInFlight(uint8_t count);
+
+    // URL of the first segment, used to pick the decoder
+    String getFirstSegmentUrl();
+    String getLastError();
+
+    // Per-segment download statistics
+    uint32_t getLastSegmentMs();
+    uint32_t getAverageSegmentMs();
+    uint32_t getSegmentCount();
+
+private:
+    struct Slot {
+        HTTPClient http;
+        HttpBodyStream body;  // Segment bytes with chunked encoding undone
+        HlsSegment segment;
+        uint32_t order;       // Playback order; sequence numbers can restart
+        bool active;
+        bool complete;
+        uint8_t* buffer;      // PSRAM prefetch buffer
+        size_t bufferLen;
+        size_t bufferPos;
+        uint32_t startMs;
+        bool encrypted;
+        SegmentDecryptor decryptor;
+        uint8_t tail[16];     // Last plaintext block, delivered after the body
+        uint8_t tailLen;
+        uint8_t tailPos;
+    };
+
+    HlsPlaylist playlist;
+    String playlistUrl;
+    HTTPClient playlistHttp;
+    HlsKeyCache keys;
+    Slot slots[HLS_PREFETCH_SEGMENTS];
+    uint8_t maxInFlight;
+    bool open;
+    uint32_t lastRefreshMs;
+    uint32_t nextOrder;
+    String firstSegmentUrl;
+    String lastError;
+
+    uint32_t lastSegmentMs;
+    uint32_t averageSegmentMs;
+    uint32_t segmentCount;
+
+    bool loadPlaylist(HTTPClient& response);
+    bool refreshPlaylist();
+    void startSlots();
+    bool startSlot(Slot& slot, const HlsSegment& segment);
+    void finishSlot(Slot& slot);
+    Slot* headSlot();
+    int readSegment(Slot& slot, uint8_t* dst, size_t max);
+};
+
+#endif // HLS_FETCHER_H
@@ -0,0 +1,77 @@
+#ifndef HLS_PLAYLIST_H
+#define HLS_PLAYLIST_H
+
+#include <Arduino.h>
+#include <deque>
+
+struct HlsSegment {
+    uint32_t sequence;
+    float duration;
+    String uri;        // Absolute URL
+    String keyUri;     // AES-128 key URL, empty for a clear segment
+    uint8_t iv[16];    // CBC IV: explicit, or the media sequence number
+};
+
+// Incremental HLS playlist parser.
+//
+// Each refresh is fed in arbitrary chunks as it comes off the socket.
+// Segments are numbered by media sequence and only segments newer than
+// the last one seen are queued, so a refresh costs one pass over the new
+// lines and never re-queues what is already playing or in flight. A
+// refresh whose numbering starts more than a window below the last queued
+// segment (an encoder restart) is joined afresh at its live edge.
+// Master playlists are recognised and the highest bandwidth variant kept.
+// EXT-X-KEY tags are tracked so each segment carries its key URL and IV.
+class HlsPlaylist {
+public:
+    HlsPlaylist();
+
+    void reset();
+
+    // One refresh: begin, feed the body, end
+    void begin(const String& playlistUrl);
+    void feed(const char* data, size_t len);
+    void end();
+
+    // Take the oldest queued segment
+    bool nextSegment(HlsSegment& segment);
+    size_t queuedCount();
+
+    bool isMaster();
+    String getVariantUrl();
+    bool isEndList();
+    uint32_t getTargetDuration();  // Seconds
+
+private:
+    String baseUrl;
+    String origin;            // scheme://host[:port]
+    String lineBuffer;
+    std::deque<HlsSegment> queue;
+
+    bool firstLoad;
+    bool haveQueued;
+    uint32_t lastQueued;
+    uint32_t currentSequence;
+    uint32_t loadSegments;    // Segments seen in this refresh
+    uint32_t window;          // Segments in the last refresh
+    float pendingDuration;
+    uint32_t targetDuration;
+    bool endList;
+
+    String keyUri;            // Current EXT-X-KEY, empty for METHOD=NONE
+    bool keyHasIv;
+    uint8_t keyIv[16];
+
+    bool master;
+    bool expectVariant;
+    uint32_t pendingBandwidth;
+    uint32_t bestBandwidth;
+    String variantUrl;
+
+    void parseLine(const String& line);
+    void parseKey(const String& line);
+    static String attribute(const String& line, const char* name);
+    String resolve(const String& uri);
+};
+
+#endif // HLS_PLAYLIST_H
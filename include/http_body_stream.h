@@ -0,0 +1,60 @@
+#ifndef HTTP_BODY_STREAM_H
+#define HTTP_BODY_STREAM_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+// Pull-style view of an HTTP response body.
+//
+// Reads straight from the connection, undoing chunked transfer encoding
+// and stopping at Content-Length, so a parser can consume the body as it
+// arrives instead of buffering it with HTTPClient::getString(). read() and
+// available() never block; Stream::readBytes() and friends wait up to the
+// stream timeout as usual.
+//
+// The channel list parser and the HLS segment downloads both read
+// through it, so there is one chunked decoder in the firmware.
+class HttpBodyStream : public Stream {
+public:
+    HttpBodyStream();
+
+    // contentLength is -1 when the server did not send one
+    void begin(WiFiClient* client, int contentLength, bool chunked);
+
+    // Non-blocking bulk read, returns bytes copied
+    int readAvailable(uint8_t* dst, size_t max);
+
+    // Consume the rest of the body so the connection can be reused
+    void drain();
+    bool isComplete();
+    size_t getBytesRead();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t) override { return 0; }
+    void flush() override {}
+
+private:
+    enum ChunkState {
+        CHUNK_SIZE,     // Reading the hex size line
+        CHUNK_DATA,     // Inside chunk data
+        CHUNK_CRLF,     // CRLF after chunk data
+        CHUNK_TRAILER   // After the last chunk, until the empty line
+    };
+
+    WiFiClient* client;
+    int32_t remaining;  // Body bytes left, -1 if unknown, 0 once complete
+    bool chunked;
+    ChunkState chunkState;
+    uint32_t chunkLeft;
+    bool chunkExt;
+    uint16_t lineLen;
+    int peeked;
+    size_t bytesRead;
+
+    bool skipFraming();
+    void consumed(size_t n);
+};
+
+#endif // HTTP_BODY_STREAM_H
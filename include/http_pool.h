@@ -0,0 +1,52 @@
+#ifndef HTTP_POOL_H
+#define HTTP_POOL_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <vector>
+
+// Keep-alive connections shared by SXMClient requests, keyed by
+// scheme://host:port.
+//
+// HTTPClient reuses a client that is still connected, so lending the same
+// WiFiClient for every request to a host skips DNS, TCP and TLS setup.
+// Connections are health-checked before they are lent out and closed once
+// they sit idle longer than HTTP_POOL_IDLE_MS. Declare the pool before the
+// HTTPClient that uses it so the clients outlive it.
+class HttpConnectionPool {
+public:
+    HttpConnectionPool();
+    ~HttpConnectionPool();
+
+    // Client for url's host; pass it to HTTPClient::begin(client, url)
+    WiFiClient* acquire(const String& url);
+    // Hand the client back after HTTPClient::end()
+    void release(WiFiClient* client);
+
+    void closeIdle();
+    // Clients lent out are closed when they are released, not under the
+    // task reading from them
+    void closeAll();
+
+    // Counters for checking reuse against a test server
+    uint32_t getConnectionsOpened();
+    uint32_t getRequestCount();
+
+private:
+    struct Connection {
+        String key;
+        WiFiClient* client;
+        bool inUse;
+        bool closeOnRelease;  // closeAll() ran while it was lent out
+        uint32_t lastUsed;
+    };
+
+    std::vector<Connection> connections;
+    uint32_t connectionsOpened;
+    uint32_t requestCount;
+
+    static String keyFor(const String& url, bool& secure);
+    void close(Connection& connection);
+};
+
+#endif // HTTP_POOL_H
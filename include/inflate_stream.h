@@ -0,0 +1,61 @@
+#ifndef INFLATE_STREAM_H
+#define INFLATE_STREAM_H
+
+#include <Arduino.h>
+#include "http_body_stream.h"
+
+struct tinfl_decompressor_tag;
+
+// Streaming gzip/deflate decoder on top of an HTTP response body.
+//
+// Uses the miniz inflater in the ESP32 ROM with a 32 KB circular
+// dictionary (in PSRAM when available), so a compressed response can be
+// parsed as it arrives without ever holding the whole body. Like
+// HttpBodyStream, read() and available() never block.
+class InflateStream : public Stream {
+public:
+    enum Format {
+        GZIP,     // Content-Encoding: gzip
+        DEFLATE   // Content-Encoding: deflate (zlib-wrapped or raw)
+    };
+
+    InflateStream();
+    ~InflateStream();
+
+    // Allocates the decoder and reads the gzip/zlib header (waits up to
+    // the source's timeout for it)
+    bool begin(HttpBodyStream& source, Format format);
+
+    // True once the compressed stream has ended and everything was read
+    bool isComplete();
+    bool hasError();
+    size_t getBytesOut();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override { return 0; }
+    void flush() override {}
+
+private:
+    HttpBodyStream* source;
+    tinfl_decompressor_tag* decompressor;
+    uint8_t* dict;
+    size_t dictPos;      // Where the decoder writes next
+    size_t outPos;       // Start of decoded bytes not yet read
+    size_t outLen;
+    uint8_t input[512];
+    size_t inputPos;
+    size_t inputLen;
+    uint32_t flags;
+    bool done;
+    bool error;
+    size_t bytesOut;
+
+    bool fill();
+    bool skipGzipHeader();
+    bool readSourceByte(uint8_t& c);
+    void release();
+};
+
+#endif // INFLATE_STREAM_H
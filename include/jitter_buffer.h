@@ -0,0 +1,123 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "ring_buffer.h"
+
+// Watermark-gated playback on top of the network -> decoder ring.
+//
+// Decoding starts once the fill reaches the high mark, pauses when it falls
+// below the low mark (before the decoder is starved mid-frame) and resumes
+// at the high mark again. Only the decoder task calls update(); the state
+// and counters can be read from any task.
+//
+// Like RingBuffer this has no Arduino dependencies.
+class JitterBuffer {
+public:
+    enum State {
+        FILLING,      // New stream, waiting for the high mark
+        PLAYING,      // Decoder may consume
+        REBUFFERING   // Dropped below the low mark, waiting for the high mark
+    };
+
+    JitterBuffer()
+        : lowMark(0), highMark(0), state(FILLING), underruns(0), endOfStream(false), fastStart(false) {}
+
+    // Attach storage and set watermarks as a percentage of capacity
+    void attach(uint8_t* storage, size_t capacity, uint8_t lowPercent, uint8_t highPercent) {
+        buffer.attach(storage, capacity);
+        lowMark = buffer.capacity() * lowPercent / 100;
+        highMark = buffer.capacity() * highPercent / 100;
+        reset();
+    }
+
+    RingBuffer& ring() {
+        return buffer;
+    }
+
+    // Decoder side: re-evaluate the state. Returns true while decoding may run.
+    bool update() {
+        size_t fill = buffer.available();
+        State current = state.load(std::memory_order_relaxed);
+
+        switch (current) {
+            case FILLING:
+            case REBUFFERING: {
+                // A primed buffer may start early; a rebuffer always waits for the high mark
+                size_t startMark = (current == FILLING && fastStart.load(std::memory_order_acquire))
+                                       ? lowMark * 2 : highMark;
+                // A finished stream will never reach the high mark; play out the tail
+                if (fill >= startMark || (endOfStream.load(std::memory_order_acquire) && fill > 0)) {
+                    current = PLAYING;
+                }
+                break;
+            }
+
+            case PLAYING:
+                if (fill < lowMark && !endOfStream.load(std::memory_order_acquire)) {
+                    current = REBUFFERING;
+                    underruns.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+        }
+
+        state.store(current, std::memory_order_release);
+        return current == PLAYING;
+    }
+
+    // Start over for a new stream. Only while the decoder is not consuming.
+    void reset() {
+        buffer.clear();
+        state.store(FILLING, std::memory_order_release);
+        endOfStream.store(false, std::memory_order_release);
+        fastStart.store(false, std::memory_order_release);
+    }
+
+    // Producer side: the buffer was primed from a warm stream, so start
+    // at twice the low mark instead of waiting for the high mark
+    void setFastStart() {
+        fastStart.store(true, std::memory_order_release);
+    }
+
+    // Producer side: no more data will arrive for this stream
+    void setEndOfStream() {
+        endOfStream.store(true, std::memory_order_release);
+    }
+
+    State getState() const {
+        return state.load(std::memory_order_acquire);
+    }
+
+    size_t getFill() const {
+        return buffer.available();
+    }
+
+    uint8_t getFillPercent() const {
+        return buffer.capacity() ? buffer.available() * 100 / buffer.capacity() : 0;
+    }
+
+    size_t getLowMark() const {
+        return lowMark;
+    }
+
+    size_t getHighMark() const {
+        return highMark;
+    }
+
+    uint32_t getUnderruns() const {
+        return underruns.load(std::memory_order_relaxed);
+    }
+
+private:
+    RingBuffer buffer;
+    size_t lowMark;
+    size_t highMark;
+    std::atomic<State> state;
+    std::atomic<uint32_t> underruns;
+    std::atomic<bool> endOfStream;
+    std::atomic<bool> fastStart;
+};
+
+#endif // JITTER_BUFFER_H
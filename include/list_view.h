@@ -0,0 +1,114 @@
+#ifndef LIST_VIEW_H
+#define LIST_VIEW_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <functional>
+#include <vector>
+#include "config.h"
+#include "text_cache.h"
+#include "touch_input.h"
+
+// A scrolling list that only draws the rows on screen.
+//
+// Items are fetched by index when a row comes into view, so a line-up of
+// thousands of channels costs no more than one of ten. The list scrolls by
+// the pixel: dragging moves it with the finger, and lifting the finger
+// while it moves leaves it coasting with decaying velocity (a fling) until
+// it stops or hits an end.
+//
+// When the screen is composed in a sprite, each visible row is rendered
+// once into a row buffer in PSRAM and copied into place on every frame
+// after that; a row that scrolls off has its buffer handed to the next
+// row scrolling on. Scrolling then costs a few memcpy per frame instead of
+// redrawing text. Without the sprite, rows are drawn straight to the panel
+// through a clipping viewport.
+class ListView {
+public:
+    typedef std::function<String(size_t index)> ItemText;
+
+    struct Stats {
+        uint32_t frames;          // Frames drawn while the list moved
+        uint32_t lastFrameMs;     // Time between the last two of them
+        uint32_t maxFrameMs;
+        uint32_t lastDrawUs;      // Composing the rows of the last frame
+        uint32_t rowsRendered;    // Rows drawn from their text
+        uint32_t rowsReused;      // Rows copied from a row buffer
+    };
+
+    ListView(int16_t x, int16_t y, int16_t w, int16_t h, int16_t rowHeight);
+    ~ListView();
+    ListView(const ListView&) = delete;
+    ListView& operator=(const ListView&) = delete;
+
+    // Row buffers are only worth it with a sprite to copy them into
+    void begin(TFT_eSPI* display, bool rowBuffers, TextCache* textCache);
+
+    // Keeps the scroll position where it still fits
+    void setItems(size_t count, const ItemText& text);
+    void setSelected(int index);
+    // Scrolls just far enough to show index, without animation
+    void scrollToItem(int index);
+
+    // Gestures that start inside the list scroll it. Returns the item
+    // tapped, or -1; a tap that stops a fling selects nothing.
+    int handleTouch(const TouchEvent& event);
+    // Once per frame: advances a fling
+    void update();
+    // Held by a finger or coasting
+    bool isMoving();
+
+    // Paints the visible rows; target is the sprite when canvas is set
+    void draw(TFT_eSPI* target, TFT_eSprite* canvas);
+    // Changes whenever draw() would paint something different
+    uint32_t getState();
+
+    int32_t getScroll();
+    int32_t getContentHeight();
+    Stats getStats();
+
+private:
+    struct RowBuffer {
+        TFT_eSprite* sprite;
+        int32_t item;       // -1 when free
+        uint16_t color;
+        uint32_t lastUsed;  // Frame it was last shown in
+    };
+
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+    int16_t rowHeight;
+
+    size_t count;
+    ItemText text;
+    TextCache* textCache;
+    uint32_t revision;      // Bumped by setItems()
+    int selected;
+
+    float scroll;           // Pixels from the top of the first row
+    float velocity;         // Pixels per ms, positive scrolls down the list
+    bool tracking;          // A gesture that started inside the list
+    bool held;
+    bool moving;            // As of the last update(), for the rest report
+    bool catchTap;          // The press stopped a fling
+    uint32_t lastDragMs;
+    uint32_t lastUpdateMs;
+
+    std::vector<RowBuffer> rows;
+    uint32_t frame;
+    uint32_t lastFrameAt;
+    Stats stats;
+
+    bool contains(uint16_t px, uint16_t py);
+    void scrollBy(float pixels);
+    int32_t maxScroll();
+    void invalidateRows();
+    RowBuffer* rowFor(int32_t item, uint16_t color);
+    void renderRow(TFT_eSPI* target, TFT_eSprite* sprite, int16_t left, int16_t top, int32_t item, uint16_t color);
+    void blitRow(TFT_eSprite* canvas, const RowBuffer& row, int16_t top);
+    uint16_t rowColor(int32_t item);
+};
+
+#endif // LIST_VIEW_H
@@ -0,0 +1,123 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Single-producer / single-consumer lock-free byte ring.
+//
+// The network task is the only writer and the decoder task is the only
+// reader, so head and tail each have exactly one owner and no mutex is
+// needed. Storage is supplied by the caller (internal RAM or PSRAM) and the
+// capacity is rounded down to a power of two so the free-running indices
+// can be masked instead of divided.
+//
+// This header has no Arduino dependencies so it can be built and tested on
+// a Linux host.
+class RingBuffer {
+public:
+    RingBuffer() : buffer(nullptr), cap(0), mask(0), head(0), tail(0) {}
+
+    // Attach backing storage. Not thread-safe: call before either side runs.
+    void attach(uint8_t* storage, size_t capacity) {
+        size_t pow2 = 1;
+        while (pow2 * 2 <= capacity) {
+            pow2 *= 2;
+        }
+        buffer = storage;
+        cap = storage ? pow2 : 0;
+        mask = cap ? cap - 1 : 0;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    // Producer side: copy up to len bytes in, returns bytes written
+    size_t write(const uint8_t* data, size_t len) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        size_t free = cap - (h - t);
+        if (len > free) {
+            len = free;
+        }
+        if (len == 0) {
+            return 0;
+        }
+
+        size_t offset = h & mask;
+        size_t first = cap - offset;
+        if (first > len) {
+            first = len;
+        }
+        memcpy(buffer + offset, data, first);
+        memcpy(buffer, data + first, len - first);
+
+        head.store(h + len, std::memory_order_release);
+        return len;
+    }
+
+    // Consumer side: copy up to len bytes out, returns bytes read
+    size_t read(uint8_t* data, size_t len) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        size_t used = h - t;
+        if (len > used) {
+            len = used;
+        }
+        if (len == 0) {
+            return 0;
+        }
+
+        size_t offset = t & mask;
+        size_t first = cap - offset;
+        if (first > len) {
+            first = len;
+        }
+        memcpy(data, buffer + offset, first);
+        memcpy(data + first, buffer, len - first);
+
+        tail.store(t + len, std::memory_order_release);
+        return len;
+    }
+
+    // Consumer side: drop up to len bytes without copying them
+    size_t discard(size_t len) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        size_t used = h - t;
+        if (len > used) {
+            len = used;
+        }
+        tail.store(t + len, std::memory_order_release);
+        return len;
+    }
+
+    // Bytes waiting to be read (exact for the consumer, a lower bound for the producer)
+    size_t available() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    // Bytes that can be written (exact for the producer, a lower bound for the consumer)
+    size_t space() const {
+        return cap - available();
+    }
+
+    size_t capacity() const {
+        return cap;
+    }
+
+    // Drop all contents. Only safe while neither side is running.
+    void clear() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    uint8_t* buffer;
+    size_t cap;
+    size_t mask;
+    std::atomic<size_t> head;  // Next write index (producer owned)
+    std::atomic<size_t> tail;  // Next read index (consumer owned)
+};
+
+#endif // RING_BUFFER_H
@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include <vector>
+#include "wifi_manager.h"
 
 class Settings {
 public:
@@ -18,6 +20,12 @@ public:
     String getWiFiPassword();
     void setWiFiCredentials(const String& ssid, const String& password);
     
+    // Every saved network, highest priority first. The network entered
+    // last is added above the others.
+    std::vector<SavedNetwork> getWiFiNetworks();
+    void addWiFiNetwork(const String& ssid, const String& password, uint8_t priority);
+    void removeWiFiNetwork(const String& ssid);
+    
     // SiriusXM Settings
     bool hasSXMCredentials();
     String getSXMEmail();
@@ -37,12 +45,20 @@ public:
     int getLastChannel();
     void setLastChannel(int channel);
     
+    // Stream URL of the last channel played, so boot can resume it before
+    // logging in. It may have expired; callers fall back to a fresh lookup.
+    String getLastStreamChannel();
+    String getLastStreamUrl();
+    void setLastStream(const String& channelId, const String& url);
+    
     // First run flag
     bool isFirstRun();
     void setFirstRunComplete();
     
 private:
     Preferences preferences;
+    
+    void saveWiFiNetworks(const std::vector<SavedNetwork>& networks);
 };
 
 #endif // SETTINGS_H
@@ -0,0 +1,92 @@
+#ifndef STANDBY_MANAGER_H
+#define STANDBY_MANAGER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <vector>
+#include "ring_buffer.h"
+#include "stream_session.h"
+
+// Warm standby streams for instant channel changes.
+//
+// Keeps a few streams (neighbouring and recently played channels) connected
+// and buffering into small PSRAM rings that always hold the most recent
+// audio. Zapping to one of them swaps its session in as the active one and
+// copies its buffered audio into the jitter buffer, so there is no URL
+// lookup, no connect and no prebuffer wait. The stream being left is kept
+// warm in its place.
+//
+// Opening a stream blocks for the connect and the response headers, and
+// for HLS also the playlist, key and first segment. That happens on a task
+// of its own so the network task keeps feeding the playing stream; a slot
+// being opened belongs to that task until it is done. Everything else
+// runs on the audio network task, except getWarmCount() which any task
+// may call.
+class StandbyManager {
+public:
+    StandbyManager();
+    ~StandbyManager();
+
+    // Allocate as many standby buffers as fit in the PSRAM budget
+    bool begin(size_t budgetBytes);
+
+    // Streams to keep warm, most important first. Others are closed.
+    void setWanted(const std::vector<String>& urls);
+
+    // Pump every warm stream; start opening at most one missing stream if
+    // allowed
+    void pump(bool allowOpen);
+
+    // Make wantUrl the active stream. The previous active session (if open)
+    // is kept warm under activeUrl. Returns true if wantUrl was already warm,
+    // in which case its buffered audio has been written to dest and the
+    // returned session is already streaming; otherwise active is closed.
+    bool exchange(const String& wantUrl, StreamSession*& active, const String& activeUrl, RingBuffer& dest);
+
+    bool isWarm(const String& url);
+    size_t getWarmCount();
+    size_t getCapacity();
+
+private:
+    enum SlotState : uint8_t {
+        IDLE,       // Owned by the network task, open or not
+        OPENING,    // Owned by the open task
+        OPENED,     // Handed back, not yet seen by the network task
+        FAILED
+    };
+
+    struct Slot {
+        String url;
+        StreamSession* session;
+        RingBuffer ring;
+        uint8_t* storage;
+        uint32_t lastUsed;
+        uint32_t retryAt;
+        std::atomic<uint8_t> state;
+    };
+
+    std::vector<Slot*> slots;
+    std::vector<String> wanted;
+    uint32_t lastOpenMs;
+    std::atomic<size_t> warmCount;
+
+    QueueHandle_t openQueue;
+    TaskHandle_t openTask;
+    TaskHandle_t owner;  // Notified when an open finishes
+
+    static void openTaskEntry(void* arg);
+    void openLoop();
+    void finishOpen(Slot& slot, bool ok);
+
+    bool isReady(Slot* slot);
+    void countWarm();
+    Slot* find(const String& url);
+    Slot* victim();
+    bool isWanted(const String& url);
+    void park(Slot& slot);
+};
+
+#endif // STANDBY_MANAGER_H
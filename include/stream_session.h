@@ -0,0 +1,71 @@
+#ifndef STREAM_SESSION_H
+#define STREAM_SESSION_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <functional>
+#include "hls_fetcher.h"
+#include "ring_buffer.h"
+#include "tls_session.h"
+
+// One HTTP audio stream feeding a RingBuffer.
+//
+// Runs on the network task: open() connects and reads the response headers,
+// pump() moves whatever the socket has into the ring without blocking.
+// Shoutcast/Icecast metadata is stripped from the audio bytes and reported
+// through the title callback. HLS playlists are handed to HlsFetcher, which
+// delivers the segments into the same ring.
+class StreamSession {
+public:
+    StreamSession();
+    ~StreamSession();
+
+    // Connect and read response headers (blocking)
+    bool open(const String& url);
+    void close();
+    bool isOpen();
+
+    // Move available socket bytes into ring. Returns audio bytes delivered,
+    // or -1 once the stream has ended or failed.
+    int pump(RingBuffer& ring);
+
+    // Called with the raw ICY StreamTitle whenever it changes
+    void setTitleCallback(std::function<void(const String&)> callback);
+
+    String getUrl();
+    String getContentType();
+    bool isPlaylist();
+    String getLastError();
+
+    // HLS segment downloads kept in flight
+    void setPrefetchLimit(uint8_t segments);
+
+    // Decoder file name for this stream (see codecPathForContentType)
+    const char* getCodecPath();
+
+    // HLS segment download times (0 for plain streams)
+    uint32_t getLastSegmentMs();
+    uint32_t getAverageSegmentMs();
+
+private:
+    HTTPClient http;
+    TlsResumingClient tlsClient;  // HTTPS streams, so zaps resume the session
+    WiFiClient* stream;
+    String url;
+    String contentType;
+    String lastError;
+    std::function<void(const String&)> titleCallback;
+    HlsFetcher hls;
+    bool hlsMode;
+
+    // ICY metadata state
+    uint32_t metaInterval;
+    uint32_t audioUntilMeta;
+    uint16_t metaRemaining;
+    String metaBuffer;
+    String lastTitle;
+
+    void handleMetadata();
+};
+
+#endif // STREAM_SESSION_H
@@ -0,0 +1,42 @@
+#ifndef STREAM_SOURCE_H
+#define STREAM_SOURCE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <FSImpl.h>
+#include "ring_buffer.h"
+
+// Exposes a RingBuffer to the ESP32-audioI2S decoder as a read-only file.
+//
+// The decoder only knows how to pull from a host it connects to itself or
+// from an fs::FS. Presenting the ring as an endless file lets the decoder
+// task consume bytes that our own network task produced, so network stalls
+// and decoder stalls no longer depend on each other.
+//
+// The file name only selects the codec ("/stream.mp3", "/stream.aac", ...).
+class RingStreamFS : public fs::FSImpl {
+public:
+    RingStreamFS();
+
+    // Point the decoder at a different ring. Call with the audio lock held.
+    void setRing(RingBuffer* ring);
+    RingBuffer* getRing();
+
+    fs::FileImplPtr open(const char* path, const char* mode, const bool create) override;
+    bool exists(const char* path) override;
+    bool rename(const char* pathFrom, const char* pathTo) override;
+    bool remove(const char* path) override;
+    bool mkdir(const char* path) override;
+    bool rmdir(const char* path) override;
+
+private:
+    RingBuffer* ring;
+};
+
+// Pick the decoder file name for a stream from its Content-Type
+const char* codecPathForContentType(const String& contentType, const String& url);
+
+// Returns true if the Content-Type/URL is an HLS playlist rather than audio
+bool isPlaylistContentType(const String& contentType, const String& url);
+
+#endif // STREAM_SOURCE_H
@@ -4,17 +4,15 @@
 #include <Arduino.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include "channel_store.h"
+#include "http_pool.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <functional>
+#include <map>
 #include <vector>
 
-struct SXMChannel {
-    String id;
-    String name;
-    String number;
-    String genre;
-    String logoUrl;
-    String streamUrl;
-};
-
 class SXMClient {
 public:
     SXMClient();
@@ -31,31 +29,144 @@ public:
     
     // Channel management
     bool fetchChannelList();
-    std::vector<SXMChannel> getChannels();
-    SXMChannel* getChannelById(const String& id);
-    SXMChannel* getChannelByNumber(const String& number);
+    const ChannelStore& getChannels();  // Read-only, valid until the next fetch
+    ChannelStore::Channel getChannelById(const String& id);
+    ChannelStore::Channel getChannelByNumber(uint16_t number);
     
-    // Streaming
+    // Conditional refresh: seed from a cached list (taken over, cached is
+    // left empty) and its HTTP validators. fetchChannelList() then succeeds
+    // without a download on 304.
+    void setCachedChannelList(ChannelStore& cached, const String& etag, const String& lastModified);
+    bool wasChannelListModified();  // Last successful fetch changed the line-up
+    String getChannelListETag();
+    String getChannelListLastModified();
+    
+    // Streaming (server mode URLs are cached until they expire)
     String getStreamUrl(const String& channelId);
+    void invalidateStreamUrl(const String& channelId);
+
+    // Asynchronous versions of the requests above. They run on worker
+    // tasks, several at a time, and their completions are called from
+    // loop() with the result (the stream URL) or the error. Each returns a
+    // request id for cancel(), or 0 if the request could not be queued.
+    typedef std::function<void(bool ok, const String& result)> Completion;
+    uint32_t loginAsync(const String& email, const String& password, const Completion& done);
+    uint32_t fetchChannelListAsync(const Completion& done);
+    uint32_t getStreamUrlAsync(const String& channelId, const Completion& done);
+    void cancel(uint32_t requestId);  // The completion will not be called
+    size_t getPendingRequests();
+
+    // Background work: delivers completions and refreshes cached stream
+    // URLs before they expire
+    void loop();
     
     // Error handling
     String getLastError();
+
+    // Connection reuse counters
+    uint32_t getConnectionsOpened();
+    uint32_t getRequestCount();
     
 private:
-    HTTPClient http;
+    struct StreamUrlEntry {
+        String url;
+        uint32_t fetchedAt;
+        uint32_t ttlMs;
+        uint32_t lastUsed;
+    };
+
+    enum RequestType {
+        REQUEST_LOGIN,
+        REQUEST_CHANNELS,
+        REQUEST_STREAM_URL
+    };
+
+    // Everything a request needs is copied in when it is queued, so a
+    // worker never touches client state; apply() folds the result back in
+    // on the caller's task.
+    struct Request {
+        uint32_t id;
+        RequestType type;
+        String url;
+        String authToken;     // Sent, or received by a login
+        String payload;       // Login body
+        String channelId;
+        String etag;          // Validators: sent, then received
+        String lastModified;
+        bool conditional;
+        bool refresh;         // Background refresh of a cached stream URL
+        bool ready;           // Answered without the network
+        volatile bool cancelled;
+        bool ok;
+        bool notModified;
+        String result;
+        String error;
+        uint32_t ttlMs;
+        ChannelStore channels;
+        Completion done;
+
+        Request()
+            : id(0), type(REQUEST_LOGIN), conditional(false), refresh(false), ready(false), cancelled(false),
+              ok(false), notModified(false), ttlMs(0) {}
+    };
+
+    // One HTTP exchange at a time: the caller's task has one, each worker
+    // task another
+    struct Connection {
+        HTTPClient http;     // Reused for every request, on pooled clients
+        WiFiClient* client;  // Pooled client of the request in progress
+
+        Connection() : client(nullptr) {}
+    };
+
+    HttpConnectionPool pool;
+    Connection conn;
+    SemaphoreHandle_t poolLock;
+    QueueHandle_t workQueue;
+    QueueHandle_t doneQueue;
+    std::vector<Request*> pending;    // Queued or running, owned by the caller's task
+    std::vector<Request*> completed;  // Answered without a worker
+    uint32_t nextRequestId;
+    uint32_t refreshRequest;          // Background stream URL refresh in flight
     String authToken;
     String sessionId;
     String sxmServer;  // Server URL for m3u8XM mode
-    std::vector<SXMChannel> channels;
+    ChannelStore channels;
+    String channelListETag;
+    String channelListLastModified;
+    bool channelListModified;
     String lastError;
+    std::map<String, StreamUrlEntry> streamUrlCache;
+    uint32_t lastUrlRefresh;
     
-    bool makeRequest(const String& url, const String& method, const String& payload, String& response);
-    bool parseChannelList(const String& jsonResponse);
-    
-    // Server mode methods
-    bool loginToServer(const String& email, const String& password);
-    bool fetchChannelListFromServer();
-    String getStreamUrlFromServer(const String& channelId);
+    bool beginRequest(Connection& connection, const String& url, String& error);
+    void endRequest(Connection& connection);
+    void lockPool();
+    void unlockPool();
+    void cancelAll();
+
+    // Requests are prepared on the caller's task, performed on any task
+    // and applied on the caller's task
+    void prepareLogin(Request& request, const String& email, const String& password);
+    void prepareChannelList(Request& request);
+    void prepareStreamUrl(Request& request, const String& channelId);
+    void perform(Connection& connection, Request& request);
+    bool apply(Request& request);
+    uint32_t submit(Request* request, const Completion& done);
+    bool startWorkers();
+    static void workerTaskEntry(void* param);
+    void workerTask();
+
+    // HTTP exchanges; they only touch the request and the connection
+    void performLogin(Connection& connection, Request& request);
+    void performChannelList(Connection& connection, Request& request);
+    void performStreamUrl(Connection& connection, Request& request);
+
+    // Streaming channel list parser: emits channels one at a time
+    typedef std::function<void(const SXMChannel&)> ChannelCallback;
+    static int parseChannelStream(Stream& body, const ChannelCallback& onChannel, String& error);
+    static int nextToken(Stream& body);
+    void cacheStreamUrl(const String& channelId, const String& url, uint32_t ttlMs);
 };
 
 #endif // SXM_CLIENT_H
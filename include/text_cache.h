@@ -0,0 +1,80 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <list>
+#include <unordered_map>
+#include "config.h"
+
+// Strings kept in PSRAM as ready-to-copy RGB565.
+//
+// The UI draws the same few hundred strings (titles, buttons, keys,
+// channel names) over and over. Each one is rasterized once per text size
+// and color pair; after that, drawing it is one pushImage, which for the
+// screen sprite is a memcpy per line. The least recently used strings are
+// dropped once the cache holds UI_TEXT_CACHE_BYTES.
+//
+// Text sizes 1-3 use anti-aliased fonts (TFT_eSPI .vlw files) from
+// LittleFS when they are there. Each file is read into PSRAM once, so
+// rasterizing reads glyphs from memory instead of the filesystem. A size
+// without its file uses the built-in font scaled as before. Without PSRAM
+// there is no cache and text is drawn directly, as it always was.
+class TextCache {
+public:
+    struct Stats {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t evictions;
+        uint32_t bytes;      // Pixels held now
+        uint32_t renderUs;   // Total time spent rasterizing misses
+        uint32_t hitUs;      // Total time spent drawing hits
+    };
+
+    TextCache();
+    ~TextCache();
+    TextCache(const TextCache&) = delete;
+    TextCache& operator=(const TextCache&) = delete;
+
+    void begin(TFT_eSPI* display);
+
+    // Draws text placed by datum (TL_DATUM, MC_DATUM, ...) on a background
+    // of bg, which anti-aliased edges are blended into. With sprite set the
+    // text goes into the sprite, clipped to its viewport; otherwise to
+    // target.
+    void draw(TFT_eSPI* target, TFT_eSprite* sprite, const String& text, int16_t x, int16_t y, uint8_t size,
+              uint8_t datum, uint16_t fg, uint16_t bg);
+
+    bool hasSmoothFont(uint8_t size);
+    Stats getStats();
+    void clear();
+
+private:
+    static const uint8_t SIZES = 3;
+
+    struct Entry {
+        uint32_t key;
+        String text;
+        uint8_t size;
+        uint16_t fg;
+        uint16_t bg;
+        int16_t w;
+        int16_t h;
+        uint16_t* pixels;
+    };
+
+    std::list<Entry> entries;  // Most recently used first
+    std::unordered_map<uint32_t, std::list<Entry>::iterator> index;
+    TFT_eSprite* renderers[SIZES];  // Scratch per size, with its font loaded
+    uint8_t* fonts[SIZES];          // .vlw files read into PSRAM
+    bool ready;
+    Stats stats;
+
+    const Entry* get(const String& text, uint8_t size, uint16_t fg, uint16_t bg);
+    const Entry* render(uint32_t key, const String& text, uint8_t size, uint16_t fg, uint16_t bg);
+    void evict(std::list<Entry>::iterator it);
+    bool loadFont(uint8_t slot, const char* path);
+    static uint32_t keyFor(const String& text, uint8_t size, uint16_t fg, uint16_t bg);
+};
+
+#endif // TEXT_CACHE_H
@@ -0,0 +1,102 @@
+#ifndef TLS_SESSION_H
+#define TLS_SESSION_H
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#if __has_include(<esp_arduino_version.h>)
+#include <esp_arduino_version.h>
+#endif
+
+// Resumption reaches into the 2.x core's WiFiClientSecure (sslclient and
+// the setup fields) and mbedtls 2.28's session struct. platformio.ini pins
+// that core; any other one builds TlsResumingClient as a plain
+// WiFiClientSecure that does a full handshake every time.
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR == 2
+#define TLS_SESSION_RESUME 1
+#else
+#define TLS_SESSION_RESUME 0
+#endif
+
+#if TLS_SESSION_RESUME
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <mbedtls/ssl.h>
+#include <vector>
+
+// TLS sessions kept per host:port so reconnects resume instead of doing a
+// full handshake.
+//
+// A resumed handshake (session ID or ticket) skips the certificate chain
+// and the key exchange, which is most of the few hundred milliseconds of
+// CPU a full handshake costs on the ESP32. One cache is shared by every
+// task; sessions expire after TLS_SESSION_TTL_MS and the least recently
+// used host is dropped when the cache is full.
+class TlsSessionCache {
+public:
+    struct Stats {
+        uint32_t fullHandshakes;
+        uint32_t resumedHandshakes;
+        uint32_t fullMs;     // Total time spent in each kind
+        uint32_t resumedMs;
+    };
+
+    TlsSessionCache();
+    ~TlsSessionCache();
+
+    // Offer the session cached for key on ssl, between mbedtls_ssl_setup()
+    // and the handshake. Returns false if there is none.
+    bool restore(const String& key, mbedtls_ssl_context* ssl);
+    // Remember the session ssl negotiated
+    void save(const String& key, const mbedtls_ssl_context* ssl);
+    void forget(const String& key);
+    // The handshake on ssl reused the session cached for key
+    bool wasResumed(const String& key, const mbedtls_ssl_context* ssl);
+
+    void recordHandshake(bool resumed, uint32_t ms);
+    Stats getStats();
+    void clear();
+
+private:
+    struct Entry {
+        String key;
+        mbedtls_ssl_session* session;
+        uint32_t savedAt;
+        uint32_t lastUsed;
+    };
+
+    std::vector<Entry> entries;
+    Stats stats;
+    SemaphoreHandle_t lock;
+
+    // Caller holds the lock; expired entries are dropped on the way
+    Entry* find(const String& key);
+    static void release(Entry& entry);
+};
+
+extern TlsSessionCache tlsSessionCache;
+
+// WiFiClientSecure that resumes sessions from tlsSessionCache.
+//
+// The core's connect() has no hook between setting up the TLS context and
+// the handshake, so this does the TCP connect and the handshake itself, on
+// the same sslclient_context the core reads, writes and stops. Setups it
+// does not cover (client certificates, PSK, the CA bundle, ALPN) fall back
+// to the core's connect without resumption.
+class TlsResumingClient : public WiFiClientSecure {
+public:
+    using WiFiClientSecure::connect;
+    int connect(const char* host, uint16_t port) override;
+    int connect(const char* host, uint16_t port, int32_t timeout) override;
+
+private:
+    bool canResume();
+    int startSession(const IPAddress& address, uint16_t port, const char* host, int32_t timeout);
+};
+
+#else
+
+class TlsResumingClient : public WiFiClientSecure {};
+
+#endif // TLS_SESSION_RESUME
+
+#endif // TLS_SESSION_H
@@ -0,0 +1,92 @@
+#ifndef TOUCH_INPUT_H
+#define TOUCH_INPUT_H
+
+#include <Arduino.h>
+#include "config.h"
+
+class UIManager;
+
+struct TouchEvent {
+    enum Type {
+        PRESS,    // Finger down
+        DRAG,     // Moved TOUCH_DRAG_STEP_PX since the last press/drag event
+        RELEASE,  // Finger up after moving: no tap
+        TAP,      // Finger up near where it went down
+        SWIPE     // Finger up after a fast, long move; see dx/dy
+    };
+    
+    Type type;
+    uint16_t x;          // Where it is now
+    uint16_t y;
+    uint16_t startX;     // Where it went down
+    uint16_t startY;
+    int16_t dx;          // Since the last event (DRAG) or since going down
+    int16_t dy;
+    uint32_t timeMs;     // When it happened; PRESS uses the interrupt time
+};
+
+// Touch gestures as a queue of time-stamped events.
+//
+// The XPT2046 pulls T_IRQ low on contact. The interrupt only records the
+// time; the panel is read on the main task (the touch controller shares
+// the display's SPI bus) and only while a finger is down, so an idle
+// screen costs no SPI traffic. Without TOUCH_IRQ wired the panel is
+// sampled every poll() instead.
+//
+// Debouncing is by time, not delay(): contact has to be gone for
+// TOUCH_RELEASE_MS and TOUCH_RELEASE_SAMPLES samples in a row before it
+// counts as released, and a new press within TOUCH_REPRESS_MS of a
+// release is taken as bounce. poll() runs once per loop pass, so the
+// sample count keeps one lost sample from releasing when passes are
+// slower than TOUCH_RELEASE_MS, and the bounce window stretches to two
+// sample periods.
+class TouchInput {
+public:
+    TouchInput();
+    
+    void begin(UIManager* ui);
+    
+    // Once per loop pass: sample if needed and queue what happened
+    void poll();
+    
+    // Oldest queued event; false if there is none
+    bool next(TouchEvent& event);
+    // Oldest tap, dropping anything queued before it
+    bool nextTap(uint16_t& x, uint16_t& y);
+    // Drop everything queued, e.g. when the screen changes under a finger
+    void clear();
+    
+    bool isDown();
+    uint32_t getDroppedCount();
+    
+private:
+    UIManager* ui;
+    TouchEvent queue[TOUCH_QUEUE_SIZE];
+    uint8_t head;
+    uint8_t count;
+    uint32_t dropped;
+    
+    bool down;
+    uint16_t startX;
+    uint16_t startY;
+    uint16_t lastX;
+    uint16_t lastY;
+    uint16_t dragX;      // Position of the last DRAG event
+    uint16_t dragY;
+    bool moved;          // Left the tap slop at some point
+    uint32_t downMs;
+    uint32_t lastContactMs;
+    uint32_t releaseMs;
+    uint32_t lastSampleMs;
+    uint32_t samplePeriodMs;  // Between the last two samples while down
+    uint32_t repressMs;      // Bounce window after the last release
+    uint8_t misses;          // Samples without contact since the last one with
+    
+    static volatile bool irqPending;
+    static volatile uint32_t irqMs;
+    static void IRAM_ATTR onIrq();
+    
+    void push(TouchEvent::Type type, uint16_t x, uint16_t y, int16_t dx, int16_t dy, uint32_t timeMs);
+};
+
+#endif // TOUCH_INPUT_H
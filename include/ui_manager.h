@@ -3,7 +3,10 @@
 
 #include <Arduino.h>
 #include <TFT_eSPI.h>
+#include <vector>
 #include "config.h"
+#include "list_view.h"
+#include "text_cache.h"
 
 enum Screen {
     SCREEN_NONE,
@@ -15,14 +18,48 @@ enum Screen {
     SCREEN_MAIN,
     SCREEN_CHANNEL_LIST,
     SCREEN_SETTINGS,
+    SCREEN_SEARCH,
     SCREEN_LOADING
 };
 
+// Retained-mode drawing on the TFT.
+//
+// Every widget (button, field, row, header) is identified by its rectangle
+// and remembers a hash of what it last showed. The draw methods can be
+// called on every loop pass: a widget is only repainted when its content
+// changed or something drew over it, so typing one character repaints one
+// field. The whole panel is cleared only when the screen changes or after
+// an overlay such as showMessage(). Bytes pushed to the panel are counted
+// per frame.
+//
+// Text is drawn through a TextCache: strings are rasterized once, in an
+// anti-aliased font where one is installed, and copied after that.
+//
+// With PSRAM the screen is composed in a full-screen sprite and endFrame()
+// sends the 16-line bands that changed to the panel by DMA. SPI DMA cannot
+// read PSRAM, so each band goes through one of two internal bounce
+// buffers: the next band is copied while the previous one is on the wire,
+// and the last transfer finishes while the loop gets on with other work.
+// Without PSRAM everything is drawn straight to the panel as before.
 class UIManager {
 public:
+    struct DrawStats {
+        uint32_t frames;          // Loop passes that pushed anything
+        uint32_t bytes;           // RGB565 bytes of every region repainted
+        uint32_t lastFrameBytes;
+        uint32_t fullClears;
+        uint32_t lastComposeUs;   // Drawing into the sprite (or panel)
+        uint32_t lastFlushUs;     // CPU time queueing the bands
+        uint32_t textHits;        // Strings copied from the text cache
+        uint32_t textMisses;      // Strings rasterized
+        uint32_t textHitUs;       // Average per hit, lookup and copy
+        uint32_t textMissUs;      // Average per miss, rasterizing included
+    };
+    
     UIManager(TFT_eSPI* tft);
     
     void begin();
+    // Clears the panel only if the screen changes or it was drawn over
     void setScreen(Screen screen);
     Screen getCurrentScreen();
     
@@ -31,12 +68,19 @@ public:
     
     // Screen drawing
     void drawSplash();
-    void drawWiFiScan(const std::vector<String>& networks, int selected);
+    void drawWiFiScan(const std::vector<String>& networks, int selected, bool scanning = false);
     void drawPasswordInput(const String& ssid, const String& password);
     void drawSXMLogin(const String& email, const String& password, bool emailField);
     void drawFMConfig(float frequency);
     void drawMainScreen(const String& channelName, const String& artist);
-    void drawChannelList(const std::vector<String>& channels, int selected, int offset);
+    // The channel list names rows through text as they scroll into view;
+    // drawChannelList() is called every pass so a fling can animate
+    void setChannelList(size_t count, const ListView::ItemText& text, int selected);
+    void drawChannelList(int selected);
+    // Scrolls the list; returns the channel tapped, or -1
+    int channelListTouch(const TouchEvent& event);
+    void drawSearch();  // Static parts: header, buttons, keyboard
+    void drawSearchResults(const String& query, const std::vector<String>& results, size_t total);
     void drawSettings();
     void drawLoading(const String& message);
     
@@ -47,15 +91,69 @@ public:
     
     // Utility
     void showMessage(const String& title, const String& message, uint16_t duration = 2000);
+    // Non-blocking notice over whatever screen is up, for completions; it
+    // is drawn by endFrame() and, once it times out, the screen under it
+    // reads as damaged
+    void showToast(const String& message, uint16_t duration = 2000);
+    // Something was drawn over the screen: draw it again through setScreen()
+    bool isScreenDamaged();
     void drawProgress(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t percent);
     
+    // Once per loop pass: sends what changed to the panel and closes the
+    // frame for the statistics
+    void endFrame();
+    // Something is moving: the loop should run every UI_FRAME_MS
+    bool isAnimating();
+    DrawStats getDrawStats();
+    
 private:
-    TFT_eSPI* tft;
+    struct Widget {
+        int16_t x;
+        int16_t y;
+        int16_t w;
+        int16_t h;
+        uint32_t state;  // Hash of what it shows
+    };
+    
+    struct ComposeScope;
+    
+    TFT_eSPI* display;            // The panel (and its touch controller)
+    TFT_eSPI* tft;                // Drawing target: the sprite, or the panel
+    TFT_eSprite* canvas;
+    uint16_t* bounce[2];          // DMA-capable band buffers
+    bool dmaReady;
+    bool dmaPending;              // A band may still be on the wire
+    uint32_t dirtyBands;          // Bit per UI_FLUSH_BAND_LINES rows
+    uint8_t composeDepth;
+    uint32_t composeStart;
+    uint32_t composeUs;
     Screen currentScreen;
+    std::vector<Widget> widgets;  // Painted on the current screen
+    bool screenDamaged;           // Drawn over outside the widgets
+    DrawStats stats;
+    uint32_t frameBytes;
+    TextCache textCache;
+    ListView channelList;
+    String toastText;             // Empty when no toast is up
+    uint32_t toastUntil;
+    bool toastShown;              // Still on screen, nothing drew over it
     
     void clearScreen();
+    void markDirty(int16_t x, int16_t y, int16_t w, int16_t h);
+    void flush();
+    void finishFlush();
+    void drawToast();
     void drawHeader(const String& title);
     void drawScrollbar(uint16_t x, uint16_t y, uint16_t h, int total, int current, int visible);
+    void drawRow(int16_t x, int16_t y, int16_t w, int16_t h, const String& text, uint16_t color, int16_t textY);
+    // Text through the cache; bg is the color it is drawn on
+    void drawText(const String& text, int16_t x, int16_t y, uint8_t size, uint8_t datum, uint16_t fg, uint16_t bg);
+    
+    // True if the widget at this rectangle must be painted to show state;
+    // the caller then paints the whole rectangle
+    bool needsPaint(int16_t x, int16_t y, int16_t w, int16_t h, uint32_t state);
+    static uint32_t hashState(const String& text, uint32_t seed = 2166136261u);
+    static uint32_t hashState(uint32_t value, uint32_t seed = 2166136261u);
 };
 
 #endif // UI_MANAGER_H
@@ -2,25 +2,109 @@
 #define WIFI_MANAGER_H
 
 #include <Arduino.h>
+#include <Preferences.h>
 #include <WiFi.h>
+#include <unordered_map>
 #include <vector>
+#include "config.h"
 
 struct WiFiNetwork {
     String ssid;
     int rssi;
     bool encrypted;
+    uint32_t hash;  // Of the SSID, for the scan table
+    uint8_t bssid[6];  // Strongest AP seen for the SSID
+    int32_t channel;
 };
 
+struct SavedNetwork {
+    String ssid;
+    String password;
+    uint8_t priority;  // Higher is preferred
+};
+
+// Station mode WiFi with fast reconnects.
+//
+// The BSSID, RF channel and IP configuration of the last good connection
+// are kept in their own Preferences namespace. A reconnect to the same
+// SSID goes straight to that AP on that channel, skipping the scan, and
+// with WIFI_REUSE_IP also skips DHCP. If that does not associate within
+// WIFI_FAST_CONNECT_MS the hints are dropped and a normal scan and DHCP
+// connect takes over.
+//
+// With several saved networks, loop() watches the RSSI trend of the link.
+// When it weakens it scans in the background and, if a saved network is
+// clearly better, hands over once the audio buffer holds enough to play
+// through the gap. A lost link is recovered onto the best saved network
+// in range.
+//
+// setPowerMode() follows the audio pipeline: no power save while it bursts,
+// max modem sleep while it rests on a full buffer, and the Arduino default
+// otherwise. Time in each mode gives an estimate of the radio's draw.
 class WiFiMgr {
 public:
+    enum PowerMode {
+        POWER_IDLE,   // Nothing streaming: min modem sleep
+        POWER_BURST,  // Filling the buffer: radio fully awake
+        POWER_REST    // Buffer full: max modem sleep
+    };
+    
+    struct PowerStats {
+        uint32_t idleMs;
+        uint32_t burstMs;
+        uint32_t restMs;
+        uint32_t restPeriods;
+    };
+    
+    struct RoamStats {
+        uint32_t handoffs;    // Completed, planned or after a lost link, not
+                              // the way back after a failure
+        uint32_t failures;    // Handoffs that timed out
+        uint32_t lastGapMs;   // Disconnect to IP address
+        uint32_t maxGapMs;
+        uint32_t totalGapMs;
+    };
+    
     WiFiMgr();
     
-    // Scan for networks
+    // Scan for networks, blocking until every channel is done
     std::vector<WiFiNetwork> scanNetworks();
     
+    // Asynchronous scan, one channel at a time so an active connection
+    // keeps being served in between. pollScan() merges each finished
+    // channel into the table and returns true when the table changed.
+    bool startScan();
+    bool pollScan();
+    bool isScanning();
+    // One entry per SSID with its strongest AP, strongest first
+    const std::vector<WiFiNetwork>& getNetworks();
+    
     // Connect to network
     bool connect(const String& ssid, const String& password, uint32_t timeout = 20000);
     
+    // Start associating and return at once; the WiFi task connects in the
+    // background while the caller does other work
+    void begin(const String& ssid, const String& password);
+    bool waitForConnection(uint32_t timeout);
+    
+    // Saved networks to connect to and roam between, best first
+    void setNetworks(const std::vector<SavedNetwork>& networks);
+    // Start on the saved network last connected to, or the preferred one
+    void beginSaved();
+    // Blocking: scan and connect to the best saved network in range
+    bool connectBestSaved(uint32_t timeout);
+    
+    // Roaming and recovery; bufferedMs is the audio that can play without
+    // the network (UINT32_MAX when nothing is streaming)
+    void loop(uint32_t bufferedMs);
+    bool isRoaming();
+    RoamStats getRoamStats();
+    
+    void setPowerMode(PowerMode mode);
+    PowerStats getPowerStats();
+    // Time-weighted from the typical draw of each mode, not measured
+    uint32_t getEstimatedRadioMa();
+    
     // Check connection status
     bool isConnected();
     
@@ -28,11 +112,71 @@ public:
     String getIP();
     int getRSSI();
     
+    // Time from begin() to an IP address, and whether the stored hints did it
+    uint32_t getConnectMs();
+    bool wasFastConnect();
+    
     // Disconnect
     void disconnect();
     
 private:
-    bool waitForConnection(uint32_t timeout);
+    Preferences hints;
+    bool hintsOpen;
+    String ssid;
+    String password;
+    uint32_t beginMs;
+    uint32_t connectMs;
+    bool fastAttempt;
+    bool fastConnect;
+    
+    enum RoamState {
+        ROAM_IDLE,
+        ROAM_SCANNING,     // Background scan for a better network
+        ROAM_WAITING,      // Candidate found, waiting for the buffer
+        ROAM_HANDOFF,      // Associating with the candidate
+        ROAM_RECOVERING    // Link lost, scanning for any saved network
+    };
+    
+    std::vector<SavedNetwork> saved;
+    RoamState roamState;
+    RoamStats roamStats;
+    int8_t rssiSamples[WIFI_ROAM_SAMPLES];
+    uint8_t rssiCount;
+    uint8_t rssiPos;
+    uint32_t lastSampleMs;
+    uint32_t lastRoamScanMs;
+    uint32_t roamStateMs;      // When roamState was entered
+    uint32_t gapStartMs;       // Link went down, for the handoff gap
+    WiFiNetwork roamTarget;
+    String roamPassword;
+    String previousSsid;
+    String previousPassword;
+    bool fallback;             // Handoff is the way back after a failed one
+    
+    PowerMode powerMode;
+    wifi_ps_type_t powerSave;
+    PowerStats powerStats;
+    uint32_t powerModeMs;      // When powerMode was entered
+    
+    std::vector<WiFiNetwork> networks;
+    std::unordered_map<uint32_t, uint16_t> networkIndex;  // SSID hash -> networks[]
+    uint8_t scanChannel;  // Channel being scanned, 0 when idle
+    
+    void sampleRssi();
+    int averageRssi();
+    int rssiTrend();
+    const SavedNetwork* findSaved(const String& ssid);
+    bool pickCandidate(int minRssi);
+    void startHandoff(uint32_t gapStart);
+    void finishHandoff();
+    void setRoamState(RoamState state);
+    void accountPower();
+    bool scanChannelStart();
+    bool mergeScanResults(int count);
+    static uint32_t hashSsid(const String& ssid);
+    bool openHints();
+    void saveHints();
+    void forgetHints();
 };
 
 #endif // WIFI_MANAGER_H
@@ -1,11 +1,18 @@
 #include "audio_player.h"
 #include "fm_transmitter.h"
 #include "config.h"
+#include <esp_heap_caps.h>
 
 // Global pointer for audio callbacks
 AudioPlayer* g_audioPlayer = nullptr;
 
-AudioPlayer::AudioPlayer() : playing(false), currentVolume(12), fmTransmitter(nullptr) {
+AudioPlayer::AudioPlayer()
+    : playing(false), currentVolume(12), fmTransmitter(nullptr),
+      ringStorage(nullptr), jitterSeconds(AUDIO_JITTER_SECONDS), ringFsImpl(std::make_shared<RingStreamFS>()), ringFs(ringFsImpl),
+      session(nullptr), audioLock(nullptr), stateLock(nullptr), decoderTask(nullptr), networkTask(nullptr),
+      pendingPlay(false), pendingStop(false), standbyDirty(false), zapStartMs(0), lastZapMs(0),
+      lastZapWarm(false), decoderArmed(false), decoderStarted(false),
+      bufferPaused(false), radioResting(false), decoderPath(nullptr), metadataDirty(false), stationDirty(false) {
     g_audioPlayer = this;
 }
 
@@ -13,11 +20,64 @@ AudioPlayer::~AudioPlayer() {
     stop();
 }
 
+void AudioPlayer::setJitterBufferSeconds(uint8_t seconds) {
+    if (seconds > 0) {
+        jitterSeconds = seconds;
+    }
+}
+
 bool AudioPlayer::begin() {
     // Initialize I2S audio
     audio.setPinout(I2S_BCLK, I2S_LRC, I2S_DOUT);
     audio.setVolume(currentVolume); // 0...21
-    
+
+    // Size the jitter buffer in PSRAM; the ring wants a power of two
+    size_t wanted = (size_t)jitterSeconds * AUDIO_JITTER_KBPS * 125;  // kbit/s -> bytes/s
+    size_t ringSize = 1;
+    while (ringSize < wanted) {
+        ringSize <<= 1;
+    }
+
+    ringStorage = (uint8_t*)heap_caps_malloc(ringSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!ringStorage) {
+        Serial.println("No PSRAM for jitter buffer, using internal RAM");
+        ringSize = AUDIO_RING_SIZE;
+        ringStorage = (uint8_t*)malloc(ringSize);
+    }
+    if (!ringStorage) {
+        Serial.println("Failed to allocate audio ring buffer");
+        return false;
+    }
+    jitter.attach(ringStorage, ringSize, AUDIO_JITTER_LOW_PCT, AUDIO_JITTER_HIGH_PCT);
+    ringFsImpl->setRing(&jitter.ring());
+    Serial.printf("Jitter buffer: %u bytes (low %u, high %u)\n",
+                  jitter.ring().capacity(), jitter.getLowMark(), jitter.getHighMark());
+
+    audioLock = xSemaphoreCreateMutex();
+    stateLock = xSemaphoreCreateMutex();
+    if (!audioLock || !stateLock) {
+        Serial.println("Failed to create audio locks");
+        return false;
+    }
+
+    session = new StreamSession();
+    attachSession();
+
+    // Standby streams are optional; without PSRAM every zap is cold
+    if (!standby.begin(STANDBY_PSRAM_BUDGET)) {
+        Serial.println("Standby streams disabled (no PSRAM)");
+    }
+
+    xTaskCreatePinnedToCore(decoderTaskEntry, "audio_dec", AUDIO_TASK_STACK, this,
+                            AUDIO_TASK_PRIORITY, &decoderTask, AUDIO_TASK_CORE);
+    xTaskCreatePinnedToCore(networkTaskEntry, "audio_net", NET_TASK_STACK, this,
+                            NET_TASK_PRIORITY, &networkTask, NET_TASK_CORE);
+
+    if (!decoderTask || !networkTask) {
+        Serial.println("Failed to start audio tasks");
+        return false;
+    }
+
     Serial.println("Audio player initialized");
     return true;
 }
@@ -29,40 +89,52 @@ void AudioPlayer::setFMTransmitter(FMTransmitter* fm) {
 
 bool AudioPlayer::play(const String& url) {
     Serial.printf("Playing: %s\n", url.c_str());
-    
-    stop(); // Stop any current playback
-    
-    bool success = audio.connecttohost(url.c_str());
-    
-    if (success) {
-        playing = true;
-        Serial.println("Playback started");
-    } else {
+
+    if (!networkTask || url.length() == 0) {
         Serial.println("Failed to start playback");
-        playing = false;
+        return false;
     }
-    
-    return success;
+
+    xSemaphoreTake(stateLock, portMAX_DELAY);
+    pendingUrl = url;
+    pendingPlay = true;
+    pendingStop = false;
+    lastError = "";
+    zapStartMs = millis();
+    xSemaphoreGive(stateLock);
+
+    playing = true;
+    xTaskNotifyGive(networkTask);
+    return true;
 }
 
 void AudioPlayer::stop() {
-    if (playing) {
-        audio.stopSong();
+    if (playing && networkTask) {
+        xSemaphoreTake(stateLock, portMAX_DELAY);
+        pendingPlay = false;
+        pendingStop = true;
+        xSemaphoreGive(stateLock);
+
         playing = false;
+        xTaskNotifyGive(networkTask);
         Serial.println("Playback stopped");
     }
 }
 
 void AudioPlayer::pause() {
     if (playing) {
+        xSemaphoreTake(audioLock, portMAX_DELAY);
         audio.pauseResume();
+        xSemaphoreGive(audioLock);
         Serial.println("Playback paused");
     }
 }
 
 void AudioPlayer::resume() {
     if (!playing) {
+        xSemaphoreTake(audioLock, portMAX_DELAY);
         audio.pauseResume();
+        xSemaphoreGive(audioLock);
         Serial.println("Playback resumed");
     }
 }
@@ -72,7 +144,14 @@ void AudioPlayer::setVolume(uint8_t volume) {
         volume = 21;
     }
     currentVolume = volume;
-    audio.setVolume(volume);
+
+    if (audioLock) {
+        xSemaphoreTake(audioLock, portMAX_DELAY);
+        audio.setVolume(volume);
+        xSemaphoreGive(audioLock);
+    } else {
+        audio.setVolume(volume);
+    }
 }
 
 uint8_t AudioPlayer::getVolume() {
@@ -80,40 +159,320 @@ uint8_t AudioPlayer::getVolume() {
 }
 
 bool AudioPlayer::isPlaying() {
-    return playing && audio.isRunning();
+    // The watermark pause stops the decoder too; only the user's pause counts
+    return playing && (audio.isRunning() || bufferPaused);
+}
+
+bool AudioPlayer::isStreamActive() {
+    return playing;
 }
 
 String AudioPlayer::getCurrentTitle() {
-    return currentTitle;
+    xSemaphoreTake(stateLock, portMAX_DELAY);
+    String title = currentTitle;
+    xSemaphoreGive(stateLock);
+    return title;
 }
 
 String AudioPlayer::getCurrentArtist() {
-    return currentArtist;
+    xSemaphoreTake(stateLock, portMAX_DELAY);
+    String artist = currentArtist;
+    xSemaphoreGive(stateLock);
+    return artist;
+}
+
+String AudioPlayer::getLastError() {
+    xSemaphoreTake(stateLock, portMAX_DELAY);
+    String error = lastError;
+    xSemaphoreGive(stateLock);
+    return error;
+}
+
+uint8_t AudioPlayer::getBufferFill() {
+    return jitter.getFillPercent();
+}
+
+size_t AudioPlayer::getBufferedBytes() {
+    return jitter.getFill();
+}
+
+uint32_t AudioPlayer::getBufferedMs() {
+    return (uint32_t)((uint64_t)jitter.getFill() * 8 / AUDIO_JITTER_KBPS);
+}
+
+bool AudioPlayer::isBuffering() {
+    return playing && jitter.getState() != JitterBuffer::PLAYING;
+}
+
+uint32_t AudioPlayer::getUnderrunCount() {
+    return jitter.getUnderruns();
+}
+
+bool AudioPlayer::isRadioResting() {
+    return radioResting.load(std::memory_order_acquire);
+}
+
+uint32_t AudioPlayer::getLastSegmentMs() {
+    return session ? session->getLastSegmentMs() : 0;
+}
+
+uint32_t AudioPlayer::getAverageSegmentMs() {
+    return session ? session->getAverageSegmentMs() : 0;
+}
+
+void AudioPlayer::setStandbyUrls(const std::vector<String>& urls) {
+    if (!networkTask) {
+        return;
+    }
+
+    xSemaphoreTake(stateLock, portMAX_DELAY);
+    pendingStandby = urls;
+    standbyDirty = true;
+    xSemaphoreGive(stateLock);
+
+    xTaskNotifyGive(networkTask);
+}
+
+size_t AudioPlayer::getWarmStreamCount() {
+    return standby.getWarmCount();
+}
+
+uint32_t AudioPlayer::getLastZapLatencyMs() {
+    return lastZapMs;
+}
+
+bool AudioPlayer::wasLastZapWarm() {
+    return lastZapWarm;
 }
 
 void AudioPlayer::loop() {
-    audio.loop();
+    // Decoding happens on the audio tasks; the main task only forwards
+    // metadata so that all I2C traffic to the FM transmitter stays here.
+    if (!stateLock) {
+        return;
+    }
+
+    xSemaphoreTake(stateLock, portMAX_DELAY);
+    bool songChanged = metadataDirty;
+    bool stationChanged = stationDirty;
+    String title = currentTitle;
+    String artist = currentArtist;
+    String station = currentStation;
+    metadataDirty = false;
+    stationDirty = false;
+    xSemaphoreGive(stateLock);
+
+    if (fmTransmitter && songChanged) {
+        fmTransmitter->setSongInfo(artist, title);
+        Serial.printf("RDS Updated: %s - %s\n", artist.c_str(), title.c_str());
+    }
+
+    if (fmTransmitter && stationChanged) {
+        fmTransmitter->setStationName(station);
+        Serial.printf("RDS Station: %s\n", station.c_str());
+    }
 }
 
 void AudioPlayer::updateMetadata(const String& title, const String& artist) {
+    xSemaphoreTake(stateLock, portMAX_DELAY);
     currentTitle = title;
     currentArtist = artist;
-    
-    // Send to FM transmitter RDS if available
-    if (fmTransmitter) {
-        fmTransmitter->setSongInfo(artist, title);
-        Serial.printf("RDS Updated: %s - %s\n", artist.c_str(), title.c_str());
-    }
+    metadataDirty = true;
+    xSemaphoreGive(stateLock);
 }
 
 void AudioPlayer::updateStationName(const String& station) {
+    xSemaphoreTake(stateLock, portMAX_DELAY);
     currentStation = station;
-    
-    // Send to FM transmitter RDS if available
-    if (fmTransmitter) {
-        fmTransmitter->setStationName(station);
-        Serial.printf("RDS Station: %s\n", station.c_str());
+    stationDirty = true;
+    xSemaphoreGive(stateLock);
+}
+
+void AudioPlayer::setError(const String& error) {
+    Serial.println(error);
+    xSemaphoreTake(stateLock, portMAX_DELAY);
+    lastError = error;
+    xSemaphoreGive(stateLock);
+}
+
+// Audio tasks
+void AudioPlayer::decoderTaskEntry(void* arg) {
+    static_cast<AudioPlayer*>(arg)->decoderLoop();
+}
+
+void AudioPlayer::networkTaskEntry(void* arg) {
+    static_cast<AudioPlayer*>(arg)->networkLoop();
+}
+
+void AudioPlayer::decoderLoop() {
+    for (;;) {
+        xSemaphoreTake(audioLock, portMAX_DELAY);
+
+        if (decoderArmed) {
+            bool canDecode = jitter.update();
+
+            if (!decoderStarted) {
+                if (canDecode) {
+                    decoderStarted = audio.connecttoFS(ringFs, decoderPath);
+                    if (decoderStarted) {
+                        lastZapMs = millis() - zapStartMs;
+                        Serial.printf("Zap latency: %u ms (%s)\n", lastZapMs, lastZapWarm ? "warm" : "cold");
+                    } else {
+                        decoderArmed = false;
+                        setError("Decoder failed to start");
+                    }
+                }
+            } else if (!canDecode && !bufferPaused) {
+                // Stop cleanly at the low mark instead of starving mid-frame
+                audio.pauseResume();
+                bufferPaused = true;
+                Serial.printf("Buffering... (%u%%)\n", jitter.getFillPercent());
+            } else if (canDecode && bufferPaused) {
+                audio.pauseResume();
+                bufferPaused = false;
+                Serial.println("Buffer refilled, resuming");
+            }
+        }
+
+        audio.loop();
+        xSemaphoreGive(audioLock);
+
+        // I2S writes pace this loop; yield so lower priority work on this core runs
+        vTaskDelay(1);
+    }
+}
+
+void AudioPlayer::networkLoop() {
+    for (;;) {
+        String url;
+        bool doPlay = false;
+        bool doStop = false;
+        bool doStandby = false;
+        std::vector<String> standbyUrls;
+
+        xSemaphoreTake(stateLock, portMAX_DELAY);
+        if (pendingPlay) {
+            url = pendingUrl;
+            doPlay = true;
+            pendingPlay = false;
+        }
+        if (pendingStop) {
+            doStop = true;
+            pendingStop = false;
+        }
+        if (standbyDirty) {
+            standbyUrls = pendingStandby;
+            doStandby = true;
+            standbyDirty = false;
+        }
+        xSemaphoreGive(stateLock);
+
+        if (doStop) {
+            stopStream();
+        }
+        if (doPlay) {
+            startStream(url);
+        }
+        if (doStandby) {
+            standby.setWanted(standbyUrls);
+        }
+
+        int delivered = 0;
+        updateRadioRest();
+        if (session->isOpen() && !radioResting.load(std::memory_order_relaxed)) {
+            delivered = session->pump(jitter.ring());
+            if (delivered < 0) {
+                // Let the decoder drain what is already buffered
+                setError(session->getLastError());
+                session->close();
+                jitter.setEndOfStream();
+            }
+        }
+
+        // Only spend time connecting standby streams once playback is safe
+        // Standby streams rest with the active one, or the radio never sleeps
+        bool bufferHealthy = !session->isOpen() || jitter.getFill() >= jitter.getHighMark();
+        bool resting = radioResting.load(std::memory_order_relaxed);
+        if (!resting) {
+            standby.pump(bufferHealthy);
+        }
+
+        if (!session->isOpen() && standby.getWarmCount() == 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        } else if (resting) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NET_TASK_REST_MS));
+        } else if (delivered <= 0) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NET_TASK_IDLE_MS));
+        }
+    }
+}
+
+void AudioPlayer::updateRadioRest() {
+    // Only a stream that is playing can rest; filling and rebuffering read
+    // as fast as the network allows
+    size_t capacity = jitter.ring().capacity();
+    bool rest = radioResting.load(std::memory_order_relaxed);
+    if (!AUDIO_BURST_RECEIVE || !session->isOpen() || jitter.getState() != JitterBuffer::PLAYING) {
+        rest = false;
+    } else if (!rest && jitter.getFill() >= capacity * AUDIO_BURST_HIGH_PCT / 100) {
+        rest = true;
+    } else if (rest && jitter.getFill() <= capacity * AUDIO_BURST_LOW_PCT / 100) {
+        rest = false;
+    }
+    radioResting.store(rest, std::memory_order_release);
+}
+
+void AudioPlayer::attachSession() {
+    // ICY titles arrive on the network task; reuse the library callback path
+    session->setTitleCallback([](const String& title) {
+        audio_showstreamtitle(title.c_str());
+    });
+    session->setPrefetchLimit(HLS_PREFETCH_SEGMENTS);
+}
+
+void AudioPlayer::startStream(const String& url) {
+    haltDecoder();
+
+    // A warm standby stream becomes the active one and its buffered audio
+    // primes the jitter buffer; the stream we leave stays warm instead
+    lastZapWarm = standby.exchange(url, session, activeUrl, jitter.ring());
+    attachSession();
+    activeUrl = url;
+
+    if (lastZapWarm) {
+        jitter.setFastStart();
+    } else if (!session->open(url)) {
+        setError(session->getLastError());
+        activeUrl = "";
+        playing = false;
+        return;
     }
+
+    xSemaphoreTake(audioLock, portMAX_DELAY);
+    decoderPath = session->getCodecPath();
+    decoderArmed = true;
+    decoderStarted = false;
+    xSemaphoreGive(audioLock);
+
+    Serial.println("Playback started");
+}
+
+void AudioPlayer::stopStream() {
+    session->close();
+    activeUrl = "";
+    haltDecoder();
+}
+
+void AudioPlayer::haltDecoder() {
+    // Holding the audio lock keeps the decoder (the ring's consumer) out
+    // while the ring is reset.
+    xSemaphoreTake(audioLock, portMAX_DELAY);
+    audio.stopSong();
+    decoderArmed = false;
+    decoderStarted = false;
+    bufferPaused = false;
+    jitter.reset();
+    xSemaphoreGive(audioLock);
 }
 
 // Optional: Audio event callbacks
@@ -0,0 +1,232 @@
+#include "channel_catalog.h"
+#include "config.h"
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+
+namespace {
+
+const char CATALOG_MAGIC[4] = {'S', 'X', 'M', 'C'};
+const size_t HEADER_SIZE = 16;
+const size_t FIELD_COUNT = 6;
+
+void putU16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+void putU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (v >> (8 * i)) & 0xFF;
+    }
+}
+
+uint16_t getU16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+uint32_t getU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Length-prefixed string; false if it runs past the end of the payload
+bool readField(const uint8_t*& p, const uint8_t* end, String& out) {
+    if (p >= end || p + 1 + *p > end) {
+        return false;
+    }
+    size_t len = *p++;
+    out = "";
+    out.concat((const char*)p, len);
+    p += len;
+    return true;
+}
+
+size_t writeField(uint8_t* p, const char* value) {
+    size_t len = min(strlen(value), (size_t)255);
+    p[0] = len;
+    memcpy(p + 1, value, len);
+    return len + 1;
+}
+
+}  // namespace
+
+ChannelCatalog::ChannelCatalog() : mounted(false), loadMs(0) {}
+
+bool ChannelCatalog::begin() {
+    if (!LittleFS.begin(true)) {
+        lastError = "LittleFS mount failed";
+        Serial.println("Catalog: " + lastError);
+        return false;
+    }
+    mounted = true;
+    return true;
+}
+
+bool ChannelCatalog::load(ChannelStore& channels) {
+    uint32_t start = millis();
+
+    if (!mounted || !LittleFS.exists(CATALOG_PATH)) {
+        lastError = "No catalog";
+        return false;
+    }
+
+    File file = LittleFS.open(CATALOG_PATH, "r");
+    if (!file) {
+        lastError = "Cannot open catalog";
+        return false;
+    }
+
+    uint8_t header[HEADER_SIZE];
+    if (file.read(header, HEADER_SIZE) != HEADER_SIZE || memcmp(header, CATALOG_MAGIC, 4) != 0) {
+        lastError = "Not a catalog file";
+        file.close();
+        return false;
+    }
+
+    uint16_t version = getU16(header + 4);
+    uint32_t count = getU32(header + 8);
+    uint32_t crc = getU32(header + 12);
+    // Version 1 had no validators and is still readable
+    if (version < 1 || version > CATALOG_VERSION || count == 0 || count > CATALOG_MAX_CHANNELS) {
+        lastError = "Unsupported catalog version " + String(version);
+        file.close();
+        return false;
+    }
+
+    // Read the records in one go; PSRAM if there is any
+    size_t payloadSize = file.size() - HEADER_SIZE;
+    uint8_t* payload = (uint8_t*)heap_caps_malloc(payloadSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!payload) {
+        payload = (uint8_t*)malloc(payloadSize);
+    }
+    if (!payload) {
+        lastError = "Out of memory";
+        file.close();
+        return false;
+    }
+
+    bool ok = file.read(payload, payloadSize) == payloadSize;
+    file.close();
+
+    if (ok && esp_rom_crc32_le(0, payload, payloadSize) != crc) {
+        ok = false;
+    }
+
+    ChannelStore loaded;
+    String loadedETag;
+    String loadedLastModified;
+    if (ok) {
+        loaded.reserve(count, payloadSize);
+        const uint8_t* p = payload;
+        const uint8_t* end = payload + payloadSize;
+        if (version >= 2) {
+            ok = readField(p, end, loadedETag) && readField(p, end, loadedLastModified);
+        }
+        for (uint32_t i = 0; i < count && ok; i++) {
+            SXMChannel channel;
+            ok = readField(p, end, channel.id) && readField(p, end, channel.name) &&
+                 readField(p, end, channel.number) && readField(p, end, channel.genre) &&
+                 readField(p, end, channel.logoUrl) && readField(p, end, channel.streamUrl);
+            ok = ok && loaded.add(channel);
+        }
+    }
+    free(payload);
+
+    if (!ok) {
+        lastError = "Catalog corrupt";
+        Serial.println("Catalog: " + lastError);
+        return false;
+    }
+
+    loaded.shrinkToFit();  // Genres and numbers were reserved as text
+    channels.swap(loaded);
+    etag = loadedETag;
+    lastModified = loadedLastModified;
+    loadMs = millis() - start;
+    Serial.printf("Catalog: Loaded %u channels in %u ms\n", channels.size(), loadMs);
+    return true;
+}
+
+bool ChannelCatalog::save(const ChannelStore& channels, const String& etag, const String& lastModified) {
+    if (!mounted || channels.empty()) {
+        lastError = mounted ? "No channels to save" : "LittleFS not mounted";
+        return false;
+    }
+
+    File file = LittleFS.open(CATALOG_TMP_PATH, "w");
+    if (!file) {
+        lastError = "Cannot create catalog";
+        Serial.println("Catalog: " + lastError);
+        return false;
+    }
+
+    // Header is rewritten with the CRC once the records are out
+    uint8_t header[HEADER_SIZE] = {0};
+    file.write(header, HEADER_SIZE);
+
+    uint8_t record[FIELD_COUNT * 256];
+    size_t validatorLen = writeField(record, etag.c_str());
+    validatorLen += writeField(record + validatorLen, lastModified.c_str());
+    uint32_t crc = esp_rom_crc32_le(0, record, validatorLen);
+    bool ok = file.write(record, validatorLen) == validatorLen;
+    for (size_t i = 0; ok && i < channels.size(); i++) {
+        ChannelStore::Channel channel = channels[i];
+        char number[6] = "";
+        if (channel.number() > 0) {
+            snprintf(number, sizeof(number), "%u", channel.number());
+        }
+
+        size_t len = 0;
+        len += writeField(record + len, channel.id());
+        len += writeField(record + len, channel.name());
+        len += writeField(record + len, number);
+        len += writeField(record + len, channel.genre());
+        len += writeField(record + len, channel.logoUrl());
+        len += writeField(record + len, channel.streamUrl());
+
+        crc = esp_rom_crc32_le(crc, record, len);
+        ok = file.write(record, len) == len;
+    }
+
+    memcpy(header, CATALOG_MAGIC, 4);
+    putU16(header + 4, CATALOG_VERSION);
+    putU32(header + 8, channels.size());
+    putU32(header + 12, crc);
+    ok = ok && file.seek(0) && file.write(header, HEADER_SIZE) == HEADER_SIZE;
+    file.close();
+
+    // Replace the old catalog only once the new one is complete
+    if (!ok || !LittleFS.rename(CATALOG_TMP_PATH, CATALOG_PATH)) {
+        LittleFS.remove(CATALOG_TMP_PATH);
+        lastError = "Catalog write failed";
+        Serial.println("Catalog: " + lastError);
+        return false;
+    }
+
+    this->etag = etag;
+    this->lastModified = lastModified;
+    Serial.printf("Catalog: Saved %u channels\n", channels.size());
+    return true;
+}
+
+void ChannelCatalog::clear() {
+    if (mounted) {
+        LittleFS.remove(CATALOG_PATH);
+    }
+}
+
+String ChannelCatalog::getETag() {
+    return etag;
+}
+
+String ChannelCatalog::getLastModified() {
+    return lastModified;
+}
+
+uint32_t ChannelCatalog::getLoadMs() {
+    return loadMs;
+}
+
+String ChannelCatalog::getLastError() {
+    return lastError;
+}
@@ -0,0 +1,166 @@
+#include "channel_search.h"
+#include "config.h"
+#include "radio_stations.h"
+#include <algorithm>
+
+namespace {
+
+inline char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+inline bool isWordChar(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (uint8_t)c >= 0x80;
+}
+
+}  // namespace
+
+ChannelSearchIndex::ChannelSearchIndex() : channelCount(0), itemCount(0), lastQueryMicros(0) {}
+
+void ChannelSearchIndex::build(const ChannelStore& channels) {
+    uint32_t start = micros();
+    clear();
+
+    channelCount = channels.size();
+    itemCount = channelCount + INTERNET_RADIO_STATION_COUNT;
+    if (itemCount > 0xFFFF) {
+        channelCount = 0xFFFF - INTERNET_RADIO_STATION_COUNT;
+        itemCount = 0xFFFF;
+    }
+
+    // Sized up front: tokens point into it, so it must never reallocate
+    numberText.resize(channelCount * 6);
+    tokens.reserve(min((size_t)SEARCH_MAX_TOKENS, itemCount * 4));
+
+    for (size_t i = 0; i < channelCount; i++) {
+        ChannelStore::Channel channel = channels[i];
+        addTokens(channel.name(), i);
+        addTokens(channel.genre(), i);
+        if (channel.number() > 0) {
+            char* text = &numberText[i * 6];
+            snprintf(text, 6, "%u", channel.number());
+            addTokens(text, i);
+        }
+    }
+    for (int i = 0; i < INTERNET_RADIO_STATION_COUNT; i++) {
+        addTokens(INTERNET_RADIO_STATIONS[i].name, channelCount + i);
+        addTokens(INTERNET_RADIO_STATIONS[i].genre, channelCount + i);
+    }
+
+    std::sort(tokens.begin(), tokens.end(), [](const Token& a, const Token& b) {
+        int c = compare(a.text, a.len, b.text, b.len);
+        return c < 0 || (c == 0 && a.item < b.item);
+    });
+
+    matches.assign((itemCount + 31) / 32, 0);
+    wordMatches.assign(matches.size(), 0);
+
+    Serial.printf("Search: %u tokens for %u items (%u bytes) in %u us\n",
+                  tokens.size(), itemCount, getMemoryUsage(), micros() - start);
+}
+
+void ChannelSearchIndex::clear() {
+    tokens.clear();
+    numberText.clear();
+    matches.clear();
+    wordMatches.clear();
+    channelCount = 0;
+    itemCount = 0;
+}
+
+size_t ChannelSearchIndex::search(const String& query, std::vector<uint16_t>& results, size_t maxResults) {
+    uint32_t start = micros();
+    results.clear();
+
+    // Every word of the query must prefix some token of the item
+    const char* q = query.c_str();
+    bool anyWord = false;
+    while (*q) {
+        while (*q && !isWordChar(*q)) {
+            q++;
+        }
+        const char* word = q;
+        while (*q && isWordChar(*q)) {
+            q++;
+        }
+        if (q == word) {
+            break;
+        }
+
+        if (!anyWord) {
+            matchPrefix(word, q - word, matches);
+            anyWord = true;
+        } else {
+            matchPrefix(word, q - word, wordMatches);
+            for (size_t i = 0; i < matches.size(); i++) {
+                matches[i] &= wordMatches[i];
+            }
+        }
+    }
+
+    size_t total = 0;
+    if (anyWord) {
+        for (size_t i = 0; i < itemCount; i++) {
+            if (matches[i / 32] & (1u << (i % 32))) {
+                if (results.size() < maxResults) {
+                    results.push_back(i);
+                }
+                total++;
+            }
+        }
+    }
+
+    lastQueryMicros = micros() - start;
+    return total;
+}
+
+size_t ChannelSearchIndex::getMemoryUsage() const {
+    return tokens.capacity() * sizeof(Token) + numberText.capacity() +
+           (matches.capacity() + wordMatches.capacity()) * sizeof(uint32_t);
+}
+
+void ChannelSearchIndex::addTokens(const char* text, uint16_t item) {
+    const char* p = text;
+    while (*p) {
+        while (*p && !isWordChar(*p)) {
+            p++;
+        }
+        const char* word = p;
+        while (*p && isWordChar(*p)) {
+            p++;
+        }
+        if (p == word) {
+            break;
+        }
+
+        // Bounded: a huge line-up loses tokens rather than the heap
+        if (tokens.size() >= SEARCH_MAX_TOKENS) {
+            return;
+        }
+        tokens.push_back({word, (uint8_t)min((int)(p - word), 255), item});
+    }
+}
+
+void ChannelSearchIndex::matchPrefix(const char* word, size_t len, std::vector<uint32_t>& bitmap) {
+    std::fill(bitmap.begin(), bitmap.end(), 0);
+
+    // First token not less than the word; every token it prefixes follows
+    auto it = std::lower_bound(tokens.begin(), tokens.end(), 0, [&](const Token& token, int) {
+        return compare(token.text, token.len, word, len) < 0;
+    });
+    for (; it != tokens.end() && it->len >= len && compare(it->text, len, word, len) == 0; ++it) {
+        bitmap[it->item / 32] |= 1u << (it->item % 32);
+    }
+}
+
+int ChannelSearchIndex::compare(const char* a, size_t aLen, const char* b, size_t bLen) {
+    size_t n = min(aLen, bLen);
+    for (size_t i = 0; i < n; i++) {
+        char ca = lower(a[i]);
+        char cb = lower(b[i]);
+        if (ca != cb) {
+            return (uint8_t)ca < (uint8_t)cb ? -1 : 1;
+        }
+    }
+    return aLen < bLen ? -1 : (aLen > bLen ? 1 : 0);
+}
@@ -0,0 +1,290 @@
+#include "channel_store.h"
+#include <esp_heap_caps.h>
+
+ChannelStore::ChannelStore()
+    : records(nullptr), count(0), recordCapacity(0),
+      arena(nullptr), arenaSize(0), arenaCapacity(0),
+      genres(nullptr), genreCount(0), genreCapacity(0),
+      idIndex(nullptr), numberIndex(nullptr), indexCapacity(0) {}
+
+ChannelStore::~ChannelStore() {
+    clear();
+}
+
+void ChannelStore::clear() {
+    free(records);
+    free(arena);
+    free(genres);
+    free(idIndex);
+    free(numberIndex);
+    records = nullptr;
+    arena = nullptr;
+    genres = nullptr;
+    idIndex = nullptr;
+    numberIndex = nullptr;
+    indexCapacity = 0;
+    count = recordCapacity = 0;
+    arenaSize = arenaCapacity = 0;
+    genreCount = genreCapacity = 0;
+}
+
+void ChannelStore::reserve(size_t channels, size_t arenaBytes) {
+    grow((void**)&records, recordCapacity, channels, sizeof(Record));
+    grow((void**)&arena, arenaCapacity, arenaBytes, 1);
+    reindex(channels);
+}
+
+void ChannelStore::shrinkToFit() {
+    shrink((void**)&records, recordCapacity, count, sizeof(Record));
+    shrink((void**)&arena, arenaCapacity, arenaSize, 1);
+    shrink((void**)&genres, genreCapacity, genreCount, sizeof(uint32_t));
+}
+
+void ChannelStore::swap(ChannelStore& other) {
+    std::swap(records, other.records);
+    std::swap(count, other.count);
+    std::swap(recordCapacity, other.recordCapacity);
+    std::swap(arena, other.arena);
+    std::swap(arenaSize, other.arenaSize);
+    std::swap(arenaCapacity, other.arenaCapacity);
+    std::swap(genres, other.genres);
+    std::swap(genreCount, other.genreCount);
+    std::swap(genreCapacity, other.genreCapacity);
+    std::swap(idIndex, other.idIndex);
+    std::swap(numberIndex, other.numberIndex);
+    std::swap(indexCapacity, other.indexCapacity);
+}
+
+bool ChannelStore::replace(ChannelStore& other) {
+    if (equals(other)) {
+        return false;
+    }
+    swap(other);
+    return true;
+}
+
+bool ChannelStore::add(const SXMChannel& channel) {
+    if (arenaSize == 0) {
+        // Offset 0 is the empty string shared by every empty field
+        if (!grow((void**)&arena, arenaCapacity, 1, 1)) {
+            return false;
+        }
+        arena[0] = '\0';
+        arenaSize = 1;
+    }
+
+    if (count >= 0xFFFF || !grow((void**)&records, recordCapacity, count + 1, sizeof(Record)) ||
+        !reindex(count + 1)) {
+        return false;
+    }
+
+    Record record;
+    long number = channel.number.toInt();
+    record.number = number > 0 && number <= 0xFFFF ? number : 0;
+    if (!intern(channel.id, record.id) || !intern(channel.name, record.name) ||
+        !intern(channel.logoUrl, record.logoUrl) || !intern(channel.streamUrl, record.streamUrl) ||
+        !internGenre(channel.genre, record.genre)) {
+        return false;
+    }
+
+    records[count] = record;
+    indexRecord(count++);
+    return true;
+}
+
+ChannelStore::Channel ChannelStore::findById(const char* id) const {
+    if (indexCapacity == 0) {
+        return Channel();
+    }
+
+    size_t mask = indexCapacity - 1;
+    for (size_t slot = hashString(id) & mask; idIndex[slot] != 0; slot = (slot + 1) & mask) {
+        size_t index = idIndex[slot] - 1;
+        if (strcmp(str(records[index].id), id) == 0) {
+            return Channel(this, index);
+        }
+    }
+    return Channel();
+}
+
+ChannelStore::Channel ChannelStore::findByNumber(uint16_t number) const {
+    if (indexCapacity == 0 || number == 0) {
+        return Channel();
+    }
+
+    size_t mask = indexCapacity - 1;
+    for (size_t slot = hashNumber(number) & mask; numberIndex[slot] != 0; slot = (slot + 1) & mask) {
+        size_t index = numberIndex[slot] - 1;
+        if (records[index].number == number) {
+            return Channel(this, index);
+        }
+    }
+    return Channel();
+}
+
+bool ChannelStore::equals(const ChannelStore& other) const {
+    if (count != other.count) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        Channel a = (*this)[i];
+        Channel b = other[i];
+        if (a.number() != b.number() || strcmp(a.id(), b.id()) != 0 || strcmp(a.name(), b.name()) != 0 ||
+            strcmp(a.genre(), b.genre()) != 0 || strcmp(a.logoUrl(), b.logoUrl()) != 0 ||
+            strcmp(a.streamUrl(), b.streamUrl()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t ChannelStore::getMemoryUsage() const {
+    return sizeof(*this) + recordCapacity * sizeof(Record) + arenaCapacity + genreCapacity * sizeof(uint32_t) +
+           indexCapacity * 2 * sizeof(uint16_t);
+}
+
+bool ChannelStore::intern(const String& value, uint32_t& offset) {
+    if (value.length() == 0) {
+        offset = 0;
+        return true;
+    }
+
+    size_t len = value.length() + 1;
+    if (!grow((void**)&arena, arenaCapacity, arenaSize + len, 1)) {
+        return false;
+    }
+
+    memcpy(arena + arenaSize, value.c_str(), len);
+    offset = arenaSize;
+    arenaSize += len;
+    return true;
+}
+
+bool ChannelStore::internGenre(const String& genre, uint16_t& index) {
+    // A line-up has a few dozen genres shared by hundreds of channels
+    for (size_t i = 0; i < genreCount; i++) {
+        if (strcmp(str(genres[i]), genre.c_str()) == 0) {
+            index = i;
+            return true;
+        }
+    }
+
+    uint32_t offset;
+    if (genreCount >= 0xFFFF || !grow((void**)&genres, genreCapacity, genreCount + 1, sizeof(uint32_t)) ||
+        !intern(genre, offset)) {
+        return false;
+    }
+
+    genres[genreCount] = offset;
+    index = genreCount++;
+    return true;
+}
+
+bool ChannelStore::reindex(size_t needed) {
+    // Keep the load factor at or below one half
+    if (needed * 2 <= indexCapacity) {
+        return true;
+    }
+
+    size_t capacity = 64;
+    while (capacity < needed * 2) {
+        capacity *= 2;
+    }
+
+    uint16_t* ids = (uint16_t*)calloc(capacity, sizeof(uint16_t));
+    uint16_t* numbers = (uint16_t*)calloc(capacity, sizeof(uint16_t));
+    if (!ids || !numbers) {
+        free(ids);
+        free(numbers);
+        return false;
+    }
+
+    free(idIndex);
+    free(numberIndex);
+    idIndex = ids;
+    numberIndex = numbers;
+    indexCapacity = capacity;
+
+    for (size_t i = 0; i < count; i++) {
+        indexRecord(i);
+    }
+    return true;
+}
+
+void ChannelStore::indexRecord(size_t index) {
+    size_t mask = indexCapacity - 1;
+    const Record& record = records[index];
+
+    // First channel wins if an id or number repeats
+    size_t slot = hashString(str(record.id)) & mask;
+    while (idIndex[slot] != 0) {
+        if (strcmp(str(records[idIndex[slot] - 1].id), str(record.id)) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    if (idIndex[slot] == 0) {
+        idIndex[slot] = index + 1;
+    }
+
+    if (record.number == 0) {
+        return;
+    }
+    slot = hashNumber(record.number) & mask;
+    while (numberIndex[slot] != 0 && records[numberIndex[slot] - 1].number != record.number) {
+        slot = (slot + 1) & mask;
+    }
+    if (numberIndex[slot] == 0) {
+        numberIndex[slot] = index + 1;
+    }
+}
+
+uint32_t ChannelStore::hashString(const char* s) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*s) {
+        hash ^= (uint8_t)*s++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t ChannelStore::hashNumber(uint16_t number) {
+    // An odd multiplier permutes the low bits: a run of numbers never collides
+    return number * 2654435761u;
+}
+
+bool ChannelStore::grow(void** buffer, size_t& capacity, size_t needed, size_t elementSize) {
+    if (needed <= capacity) {
+        return true;
+    }
+
+    size_t newCapacity = max(needed, max(capacity * 2, (size_t)16));
+    void* p = heap_caps_realloc(*buffer, newCapacity * elementSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!p) {
+        p = realloc(*buffer, newCapacity * elementSize);
+    }
+    if (!p) {
+        return false;
+    }
+
+    *buffer = p;
+    capacity = newCapacity;
+    return true;
+}
+
+void ChannelStore::shrink(void** buffer, size_t& capacity, size_t needed, size_t elementSize) {
+    if (needed == 0 || needed >= capacity) {
+        return;
+    }
+
+    void* p = heap_caps_realloc(*buffer, needed * elementSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!p) {
+        p = realloc(*buffer, needed * elementSize);
+    }
+    if (p) {
+        *buffer = p;
+        capacity = needed;
+    }
+}
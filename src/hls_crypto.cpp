@@ -0,0 +1,161 @@
+#include "hls_crypto.h"
+#include "config.h"
+
+SegmentDecryptor::SegmentDecryptor() : partialLen(0), haveHeld(false), bytes(0), micros(0) {
+    mbedtls_aes_init(&aes);
+}
+
+SegmentDecryptor::~SegmentDecryptor() {
+    mbedtls_aes_free(&aes);
+}
+
+void SegmentDecryptor::begin(const uint8_t key[16], const uint8_t iv[16]) {
+    mbedtls_aes_setkey_dec(&aes, key, 128);
+    memcpy(this->iv, iv, sizeof(this->iv));
+    partialLen = 0;
+    haveHeld = false;
+}
+
+size_t SegmentDecryptor::update(uint8_t* buf, size_t len) {
+    uint32_t start = ::micros();
+
+    // Line the ciphertext up behind any partial block from the last call,
+    // so every whole block is one contiguous run starting at run
+    uint8_t* run = buf + HEADROOM - partialLen;
+    memcpy(run, partial, partialLen);
+    size_t total = partialLen + len;
+    size_t runLen = total & ~(size_t)15;
+
+    // The leftover bytes start the next partial block
+    partialLen = total - runLen;
+    memcpy(partial, run + runLen, partialLen);
+    if (runLen == 0) {
+        return 0;
+    }
+
+    // In place, one call for the whole run so the peripheral sees it at once
+    mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_DECRYPT, runLen, iv, run, run);
+
+    // Output is the block held from before, then every block of the run but
+    // the last, which is held in turn: only the final one carries padding
+    size_t out = 0;
+    if (haveHeld) {
+        memmove(buf + 16, run, runLen - 16);
+        memcpy(buf, held, 16);
+        out = runLen;
+    } else {
+        memmove(buf, run, runLen - 16);
+        out = runLen - 16;
+    }
+    memcpy(held, run + runLen - 16, 16);
+    haveHeld = true;
+
+    bytes += runLen;
+    micros += ::micros() - start;
+    return out;
+}
+
+int SegmentDecryptor::finish(uint8_t out[16]) {
+    if (partialLen != 0 || !haveHeld) {
+        return -1;
+    }
+
+    uint8_t pad = held[15];
+    if (pad == 0 || pad > 16) {
+        return -1;
+    }
+    for (size_t i = 16 - pad; i < 16; i++) {
+        if (held[i] != pad) {
+            return -1;
+        }
+    }
+
+    memcpy(out, held, 16 - pad);
+    haveHeld = false;
+    return 16 - pad;
+}
+
+uint32_t SegmentDecryptor::getBytes() {
+    return bytes;
+}
+
+uint32_t SegmentDecryptor::getMicros() {
+    return micros;
+}
+
+HlsKeyCache::HlsKeyCache() {}
+
+const uint8_t* HlsKeyCache::get(const String& uri) {
+    for (auto& entry : entries) {
+        if (entry.uri == uri) {
+            entry.lastUsed = millis();
+            return entry.key;
+        }
+    }
+
+    uint8_t key[16];
+    if (!fetch(uri, key)) {
+        return nullptr;
+    }
+
+    Entry* entry;
+    if (entries.size() >= HLS_KEY_CACHE_MAX) {
+        // Replace the least recently used key
+        entry = &entries[0];
+        for (auto& candidate : entries) {
+            if (candidate.lastUsed < entry->lastUsed) {
+                entry = &candidate;
+            }
+        }
+    } else {
+        entries.push_back(Entry());
+        entry = &entries.back();
+    }
+    entry->uri = uri;
+    memcpy(entry->key, key, sizeof(key));
+    entry->lastUsed = millis();
+    return entry->key;
+}
+
+void HlsKeyCache::clear() {
+    // Keys are secrets: do not leave them in freed memory
+    for (auto& entry : entries) {
+        memset(entry.key, 0, sizeof(entry.key));
+    }
+    entries.clear();
+    http.end();
+}
+
+String HlsKeyCache::getLastError() {
+    return lastError;
+}
+
+bool HlsKeyCache::fetch(const String& uri, uint8_t key[16]) {
+    http.setReuse(true);
+    http.setTimeout(HTTP_TIMEOUT_MS);
+
+    if (!http.begin(uri)) {
+        lastError = "HLS: Invalid key URL";
+        return false;
+    }
+
+    int httpCode = http.GET();
+    bool success = false;
+    if (httpCode == HTTP_CODE_OK && (http.getSize() == 16 || http.getSize() < 0)) {
+        WiFiClient* stream = http.getStreamPtr();
+        stream->setTimeout(HTTP_TIMEOUT_MS);
+        success = stream->readBytes(key, 16) == 16;
+        if (!success) {
+            lastError = "HLS: Key truncated";
+        }
+    } else {
+        lastError = "HLS: Key fetch failed: HTTP " + String(httpCode) + ", " + String(http.getSize()) + " bytes";
+    }
+
+    // end() keeps the connection open for the next key
+    http.end();
+    if (success) {
+        Serial.printf("HLS: Loaded key %s\n", uri.c_str());
+    }
+    return success;
+}
@@ -0,0 +1,362 @@
+#include "hls_fetcher.h"
+#include <esp_heap_caps.h>
+
+namespace {
+
+// Lets HTTPClient::writeToStream() hand the playlist body to the parser
+// chunk by chunk, with chunked transfer encoding already undone.
+class PlaylistSink : public Stream {
+public:
+    PlaylistSink(HlsPlaylist& playlist) : playlist(playlist) {}
+
+    size_t write(uint8_t c) override {
+        char ch = (char)c;
+        playlist.feed(&ch, 1);
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        playlist.feed((const char*)buffer, size);
+        return size;
+    }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+
+private:
+    HlsPlaylist& playlist;
+};
+
+} // namespace
+
+HlsFetcher::HlsFetcher()
+    : maxInFlight(HLS_PREFETCH_SEGMENTS), open(false), lastRefreshMs(0), nextOrder(0),
+      lastSegmentMs(0), averageSegmentMs(0), segmentCount(0) {
+    for (auto& slot : slots) {
+        slot.active = false;
+        slot.buffer = nullptr;
+    }
+}
+
+HlsFetcher::~HlsFetcher() {
+    close();
+    for (auto& slot : slots) {
+        free(slot.buffer);
+        slot.buffer = nullptr;
+    }
+}
+
+bool HlsFetcher::begin(const String& url, HTTPClient& response) {
+    close();
+    playlist.reset();
+    playlistUrl = url;
+    firstSegmentUrl = "";
+    lastError = "";
+    lastSegmentMs = 0;
+    averageSegmentMs = 0;
+    segmentCount = 0;
+
+    if (!loadPlaylist(response)) {
+        return false;
+    }
+
+    // A master playlist only names the variants; follow the best one
+    if (playlist.isMaster()) {
+        playlistUrl = playlist.getVariantUrl();
+        playlist.reset();
+        Serial.printf("HLS: Using variant %s\n", playlistUrl.c_str());
+        if (!refreshPlaylist()) {
+            return false;
+        }
+    }
+
+    open = true;
+    startSlots();
+    Serial.printf("HLS: Started with %u segments queued\n", playlist.queuedCount());
+    return true;
+}
+
+void HlsFetcher::close() {
+    for (auto& slot : slots) {
+        if (slot.active) {
+            slot.http.end();
+            slot.active = false;
+        }
+    }
+    playlistHttp.end();
+    keys.clear();
+    open = false;
+}
+
+bool HlsFetcher::isOpen() {
+    return open;
+}
+
+bool HlsFetcher::loadPlaylist(HTTPClient& response) {
+    PlaylistSink sink(playlist);
+    playlist.begin(playlistUrl);
+    int written = response.writeToStream(&sink);
+    playlist.end();
+    lastRefreshMs = millis();
+
+    if (written < 0) {
+        lastError = "HLS: Playlist read failed";
+        return false;
+    }
+    return true;
+}
+
+bool HlsFetcher::refreshPlaylist() {
+    playlistHttp.setReuse(true);
+    playlistHttp.setTimeout(HTTP_TIMEOUT_MS);
+
+    if (!playlistHttp.begin(playlistUrl)) {
+        lastError = "HLS: Invalid playlist URL";
+        return false;
+    }
+
+    int httpCode = playlistHttp.GET();
+    bool success = false;
+    if (httpCode == HTTP_CODE_OK) {
+        success = loadPlaylist(playlistHttp);
+    } else {
+        lastError = "HLS: Playlist refresh failed: HTTP " + String(httpCode);
+        lastRefreshMs = millis();
+    }
+
+    // end() keeps the connection open for the next refresh
+    playlistHttp.end();
+    return success;
+}
+
+int HlsFetcher::pump(RingBuffer& ring) {
+    if (!open) {
+        return -1;
+    }
+
+    // Refresh at half the target duration so new segments are queued
+    // before the ones in flight run out
+    if (!playlist.isEndList() &&
+        millis() - lastRefreshMs >= playlist.getTargetDuration() * 500) {
+        if (!refreshPlaylist()) {
+            Serial.println(lastError);
+        }
+    }
+
+    startSlots();
+
+    int delivered = 0;
+    Slot* head = headSlot();
+
+    for (auto& slot : slots) {
+        if (!slot.active) {
+            continue;
+        }
+
+        if (&slot == head) {
+            // Drain what was prefetched, then stream directly into the ring
+            if (slot.bufferPos < slot.bufferLen) {
+                size_t n = ring.write(slot.buffer + slot.bufferPos, slot.bufferLen - slot.bufferPos);
+                slot.bufferPos += n;
+                delivered += n;
+            }
+            if (slot.bufferPos == slot.bufferLen && !slot.complete) {
+                uint8_t chunk[STREAM_CHUNK_SIZE];
+                size_t want = min(ring.space(), sizeof(chunk));
+                int n = want > 0 ? readSegment(slot, chunk, want) : 0;
+                if (n > 0) {
+                    delivered += ring.write(chunk, n);
+                }
+            }
+            if (slot.complete && slot.bufferPos == slot.bufferLen && slot.tailPos < slot.tailLen) {
+                size_t n = ring.write(slot.tail + slot.tailPos, slot.tailLen - slot.tailPos);
+                slot.tailPos += n;
+                delivered += n;
+            }
+        } else if (!slot.complete && slot.bufferLen < HLS_SEGMENT_BUFFER_SIZE) {
+            // Prefetch buffers are only allocated once something runs ahead of the head
+            if (!slot.buffer) {
+                slot.buffer = (uint8_t*)heap_caps_malloc(HLS_SEGMENT_BUFFER_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+                if (!slot.buffer) {
+                    continue;
+                }
+            }
+            int n = readSegment(slot, slot.buffer + slot.bufferLen, HLS_SEGMENT_BUFFER_SIZE - slot.bufferLen);
+            if (n > 0) {
+                slot.bufferLen += n;
+            }
+        }
+
+        if (!slot.complete && slot.body.isComplete()) {
+            finishSlot(slot);
+        }
+
+        // The head is done once everything it fetched reached the ring
+        if (&slot == head && slot.complete && slot.bufferPos == slot.bufferLen && slot.tailPos == slot.tailLen) {
+            slot.active = false;
+            startSlots();
+        }
+    }
+
+    if (delivered == 0 && playlist.isEndList() && playlist.queuedCount() == 0 && !headSlot()) {
+        lastError = "Stream ended";
+        return -1;
+    }
+    return delivered;
+}
+
+void HlsFetcher::setMaxInFlight(uint8_t count) {
+    maxInFlight = constrain(count, 1, HLS_PREFETCH_SEGMENTS);
+}
+
+void HlsFetcher::startSlots() {
+    uint8_t inFlight = 0;
+    for (auto& slot : slots) {
+        if (slot.active) {
+            inFlight++;
+        }
+    }
+
+    for (auto& slot : slots) {
+        if (slot.active) {
+            continue;
+        }
+        if (inFlight >= maxInFlight) {
+            return;
+        }
+
+        HlsSegment segment;
+        if (!playlist.nextSegment(segment)) {
+            return;
+        }
+        startSlot(slot, segment);
+        inFlight++;
+    }
+}
+
+bool HlsFetcher::startSlot(Slot& slot, const HlsSegment& segment) {
+    slot.segment = segment;
+    slot.order = nextOrder++;
+    slot.active = true;
+    slot.complete = false;
+    slot.bufferLen = 0;
+    slot.bufferPos = 0;
+    slot.body.begin(nullptr, 0, false);
+    slot.encrypted = false;
+    slot.tailLen = 0;
+    slot.tailPos = 0;
+    slot.startMs = millis();
+
+    if (firstSegmentUrl.length() == 0) {
+        firstSegmentUrl = segment.uri;
+    }
+
+    if (segment.keyUri.length() > 0) {
+        // Keys are cached per URI, so this is a download only when it rotates
+        const uint8_t* key = keys.get(segment.keyUri);
+        if (!key) {
+            lastError = keys.getLastError();
+            Serial.println(lastError);
+            slot.complete = true;
+            return false;
+        }
+        slot.decryptor.begin(key, segment.iv);
+        slot.encrypted = true;
+    }
+
+    // Same host as the last segment: HTTPClient reuses the open connection
+    slot.http.setReuse(true);
+    slot.http.setTimeout(HTTP_TIMEOUT_MS);
+
+    const char* headerKeys[] = {"Transfer-Encoding"};
+    if (slot.http.begin(segment.uri)) {
+        slot.http.collectHeaders(headerKeys, 1);
+        int httpCode = slot.http.GET();
+        if (httpCode == HTTP_CODE_OK) {
+            slot.body.begin(slot.http.getStreamPtr(), slot.http.getSize(),
+                            slot.http.header("Transfer-Encoding").equalsIgnoreCase("chunked"));
+            return true;
+        }
+        lastError = "HLS: Segment " + String(segment.sequence) + " failed: HTTP " + String(httpCode);
+    } else {
+        lastError = "HLS: Invalid segment URL";
+    }
+
+    // Skip the segment rather than stall the stream behind it
+    Serial.println(lastError);
+    slot.http.end();
+    slot.complete = true;
+    return false;
+}
+
+void HlsFetcher::finishSlot(Slot& slot) {
+    slot.complete = true;
+    slot.http.end();
+
+    if (slot.encrypted) {
+        int n = slot.decryptor.finish(slot.tail);
+        if (n < 0) {
+            // Wrong key or a cut-off body: drop the last block, keep playing
+            Serial.printf("HLS: Segment %u failed to decrypt\n", slot.segment.sequence);
+            n = 0;
+        }
+        slot.tailLen = n;
+    }
+
+    uint32_t elapsed = millis() - slot.startMs;
+    lastSegmentMs = elapsed;
+    averageSegmentMs = segmentCount == 0 ? elapsed : (averageSegmentMs * 3 + elapsed) / 4;
+    segmentCount++;
+
+    Serial.printf("HLS: Segment %u (%u bytes, %.1fs) in %u ms\n",
+                  slot.segment.sequence, slot.body.getBytesRead(), slot.segment.duration, elapsed);
+    if (slot.encrypted && slot.decryptor.getMicros() > 0) {
+        Serial.printf("HLS: Decrypting at %.2f MB/s\n",
+                      (float)slot.decryptor.getBytes() / slot.decryptor.getMicros());
+    }
+}
+
+HlsFetcher::Slot* HlsFetcher::headSlot() {
+    Slot* head = nullptr;
+    for (auto& slot : slots) {
+        if (slot.active && (!head || (int32_t)(slot.order - head->order) < 0)) {
+            head = &slot;
+        }
+    }
+    return head;
+}
+
+int HlsFetcher::readSegment(Slot& slot, uint8_t* dst, size_t max) {
+    if (!slot.encrypted) {
+        return slot.body.readAvailable(dst, max);
+    }
+
+    // Ciphertext lands behind the headroom and is decrypted in place
+    if (max <= SegmentDecryptor::HEADROOM + 15) {
+        return 0;
+    }
+    int n = slot.body.readAvailable(dst + SegmentDecryptor::HEADROOM, max - SegmentDecryptor::HEADROOM - 15);
+    return n > 0 ? slot.decryptor.update(dst, n) : 0;
+}
+
+String HlsFetcher::getFirstSegmentUrl() {
+    return firstSegmentUrl;
+}
+
+String HlsFetcher::getLastError() {
+    return lastError;
+}
+
+uint32_t HlsFetcher::getLastSegmentMs() {
+    return lastSegmentMs;
+}
+
+uint32_t HlsFetcher::getAverageSegmentMs() {
+    return averageSegmentMs;
+}
+
+uint32_t HlsFetcher::getSegmentCount() {
+    return segmentCount;
+}
@@ -0,0 +1,224 @@
+#include "hls_playlist.h"
+#include "config.h"
+
+HlsPlaylist::HlsPlaylist() {
+    reset();
+}
+
+void HlsPlaylist::reset() {
+    queue.clear();
+    lineBuffer = "";
+    firstLoad = true;
+    haveQueued = false;
+    lastQueued = 0;
+    currentSequence = 0;
+    loadSegments = 0;
+    window = 0;
+    pendingDuration = 0;
+    targetDuration = 10;
+    endList = false;
+    keyUri = "";
+    keyHasIv = false;
+    master = false;
+    expectVariant = false;
+    pendingBandwidth = 0;
+    bestBandwidth = 0;
+    variantUrl = "";
+}
+
+void HlsPlaylist::begin(const String& playlistUrl) {
+    String url = playlistUrl;
+    int query = url.indexOf('?');
+    if (query >= 0) {
+        url = url.substring(0, query);
+    }
+    baseUrl = url.substring(0, url.lastIndexOf('/') + 1);
+
+    int hostStart = url.indexOf("://");
+    int pathStart = hostStart >= 0 ? url.indexOf('/', hostStart + 3) : -1;
+    origin = pathStart >= 0 ? url.substring(0, pathStart) : url;
+
+    lineBuffer = "";
+    currentSequence = 0;
+    loadSegments = 0;
+    pendingDuration = 0;
+    expectVariant = false;
+}
+
+void HlsPlaylist::feed(const char* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            lineBuffer.trim();
+            if (lineBuffer.length() > 0) {
+                parseLine(lineBuffer);
+            }
+            lineBuffer = "";
+        } else if (c != '\r') {
+            lineBuffer += c;
+        }
+    }
+}
+
+void HlsPlaylist::end() {
+    lineBuffer.trim();
+    if (lineBuffer.length() > 0) {
+        parseLine(lineBuffer);
+    }
+    lineBuffer = "";
+    window = loadSegments;
+
+    // Join a live stream near its edge rather than minutes behind it
+    if (firstLoad && !endList) {
+        while (queue.size() > HLS_LIVE_START_SEGMENTS) {
+            queue.pop_front();
+        }
+    }
+    firstLoad = false;
+}
+
+bool HlsPlaylist::nextSegment(HlsSegment& segment) {
+    if (queue.empty()) {
+        return false;
+    }
+    segment = queue.front();
+    queue.pop_front();
+    return true;
+}
+
+size_t HlsPlaylist::queuedCount() {
+    return queue.size();
+}
+
+bool HlsPlaylist::isMaster() {
+    return master;
+}
+
+String HlsPlaylist::getVariantUrl() {
+    return variantUrl;
+}
+
+bool HlsPlaylist::isEndList() {
+    return endList;
+}
+
+uint32_t HlsPlaylist::getTargetDuration() {
+    return targetDuration;
+}
+
+void HlsPlaylist::parseLine(const String& line) {
+    if (line.startsWith("#EXTINF:")) {
+        pendingDuration = line.substring(8).toFloat();
+    } else if (line.startsWith("#EXT-X-MEDIA-SEQUENCE:")) {
+        currentSequence = line.substring(22).toInt();
+    } else if (line.startsWith("#EXT-X-TARGETDURATION:")) {
+        targetDuration = line.substring(22).toInt();
+    } else if (line.startsWith("#EXT-X-KEY:")) {
+        parseKey(line);
+    } else if (line.startsWith("#EXT-X-ENDLIST")) {
+        endList = true;
+    } else if (line.startsWith("#EXT-X-STREAM-INF:")) {
+        master = true;
+        expectVariant = true;
+        int bw = line.indexOf("BANDWIDTH=");
+        pendingBandwidth = bw >= 0 ? line.substring(bw + 10).toInt() : 0;
+    } else if (line[0] == '#') {
+        // Other tags are not needed for audio-only playback
+    } else if (expectVariant) {
+        expectVariant = false;
+        if (variantUrl.length() == 0 || pendingBandwidth > bestBandwidth) {
+            bestBandwidth = pendingBandwidth;
+            variantUrl = resolve(line);
+        }
+    } else {
+        uint32_t sequence = currentSequence++;
+        if (loadSegments++ == 0 && haveQueued && sequence + window < lastQueued) {
+            // Numbering went back by more than a window (a stale cache
+            // lags by a segment at most): the encoder restarted, and
+            // nothing queued belongs to the new stream
+            Serial.printf("HLS: Media sequence went back from %u to %u, resyncing\n", lastQueued, sequence);
+            queue.clear();
+            haveQueued = false;
+            firstLoad = true;
+        }
+        if (!haveQueued || sequence > lastQueued) {
+            HlsSegment segment;
+            segment.sequence = sequence;
+            segment.duration = pendingDuration;
+            segment.uri = resolve(line);
+            segment.keyUri = keyUri;
+            if (keyHasIv) {
+                memcpy(segment.iv, keyIv, sizeof(segment.iv));
+            } else {
+                // RFC 8216 5.2: the media sequence number, big-endian
+                memset(segment.iv, 0, sizeof(segment.iv));
+                for (int i = 0; i < 4; i++) {
+                    segment.iv[15 - i] = (sequence >> (8 * i)) & 0xFF;
+                }
+            }
+            queue.push_back(segment);
+            lastQueued = sequence;
+            haveQueued = true;
+        }
+        pendingDuration = 0;
+    }
+}
+
+void HlsPlaylist::parseKey(const String& line) {
+    String method = attribute(line, "METHOD");
+    keyUri = "";
+    keyHasIv = false;
+
+    if (method == "NONE") {
+        return;
+    }
+    if (method != "AES-128") {
+        // SAMPLE-AES encrypts inside the audio frames; the decoder cannot
+        // take that, so the segments are passed through untouched
+        Serial.printf("HLS: Unsupported key method %s\n", method.c_str());
+        return;
+    }
+    keyUri = resolve(attribute(line, "URI"));
+
+    String iv = attribute(line, "IV");
+    if (iv.startsWith("0x") || iv.startsWith("0X")) {
+        // Right-aligned, so a short IV is zero-padded on the left
+        memset(keyIv, 0, sizeof(keyIv));
+        int byte = 15;
+        for (int i = iv.length() - 1; i >= 2 && byte >= 0; i -= 2, byte--) {
+            long value = strtol(iv.substring(max(2, i - 1), i + 1).c_str(), nullptr, 16);
+            keyIv[byte] = value & 0xFF;
+        }
+        keyHasIv = true;
+    }
+}
+
+String HlsPlaylist::attribute(const String& line, const char* name) {
+    // NAME=value or NAME="quoted value" in an attribute list
+    String key = String(name) + "=";
+    int start = line.indexOf(key);
+    while (start > 0 && line[start - 1] != ':' && line[start - 1] != ',') {
+        start = line.indexOf(key, start + 1);
+    }
+    if (start < 0) {
+        return "";
+    }
+    start += key.length();
+
+    if (line[start] == '"') {
+        int end = line.indexOf('"', start + 1);
+        return line.substring(start + 1, end < 0 ? line.length() : end);
+    }
+    int end = line.indexOf(',', start);
+    return line.substring(start, end < 0 ? line.length() : end);
+}
+
+String HlsPlaylist::resolve(const String& uri) {
+    if (uri.startsWith("http://") || uri.startsWith("https://")) {
+        return uri;
+    }
+    if (uri.startsWith("/")) {
+        return origin + uri;
+    }
+    return baseUrl + uri;
+}
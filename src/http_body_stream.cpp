@@ -0,0 +1,183 @@
+#include "http_body_stream.h"
+
+namespace {
+
+int hexValue(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+}  // namespace
+
+HttpBodyStream::HttpBodyStream()
+    : client(nullptr), remaining(0), chunked(false), chunkState(CHUNK_SIZE),
+      chunkLeft(0), chunkExt(false), lineLen(0), peeked(-1), bytesRead(0) {}
+
+void HttpBodyStream::begin(WiFiClient* client, int contentLength, bool chunked) {
+    this->client = client;
+    this->chunked = chunked;
+    remaining = chunked ? -1 : contentLength;
+    chunkState = CHUNK_SIZE;
+    chunkLeft = 0;
+    chunkExt = false;
+    lineLen = 0;
+    peeked = -1;
+    bytesRead = 0;
+}
+
+int HttpBodyStream::available() {
+    if (peeked >= 0) {
+        return 1;
+    }
+    if (!client || remaining == 0) {
+        return 0;
+    }
+    if (chunked && !skipFraming()) {
+        return 0;
+    }
+
+    int avail = client->available();
+    if (avail <= 0) {
+        return 0;
+    }
+    if (chunked) {
+        return min((uint32_t)avail, chunkLeft);
+    }
+    if (remaining > 0) {
+        return min(avail, (int)remaining);
+    }
+    return avail;
+}
+
+int HttpBodyStream::read() {
+    if (peeked >= 0) {
+        int c = peeked;
+        peeked = -1;
+        return c;
+    }
+    if (available() <= 0) {
+        return -1;
+    }
+
+    int c = client->read();
+    if (c >= 0) {
+        consumed(1);
+    }
+    return c;
+}
+
+int HttpBodyStream::readAvailable(uint8_t* dst, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+
+    int total = 0;
+    if (peeked >= 0) {
+        dst[total++] = (uint8_t)peeked;
+        peeked = -1;
+    }
+
+    // Across chunk boundaries, until max or the socket runs dry
+    while ((size_t)total < max) {
+        int avail = available();
+        if (avail <= 0) {
+            break;
+        }
+        int n = client->read(dst + total, min((size_t)avail, max - total));
+        if (n <= 0) {
+            break;
+        }
+        consumed(n);
+        total += n;
+    }
+    return total;
+}
+
+int HttpBodyStream::peek() {
+    if (peeked < 0) {
+        peeked = read();
+    }
+    return peeked;
+}
+
+void HttpBodyStream::drain() {
+    uint8_t scratch[128];
+    uint32_t start = millis();
+    while (!isComplete() && millis() - start < _timeout) {
+        if (readAvailable(scratch, sizeof(scratch)) <= 0) {
+            delay(1);
+        }
+    }
+}
+
+bool HttpBodyStream::isComplete() {
+    if (peeked >= 0) {
+        return false;
+    }
+    if (!client || remaining == 0) {
+        return true;
+    }
+    // Unknown length ends when the server closes the connection; a body
+    // cut short that way is over too, just truncated
+    return !client->connected() && client->available() == 0;
+}
+
+size_t HttpBodyStream::getBytesRead() {
+    return bytesRead;
+}
+
+bool HttpBodyStream::skipFraming() {
+    // Consume chunk headers until chunk data can be read
+    while (chunkState != CHUNK_DATA) {
+        if (remaining == 0 || client->available() <= 0) {
+            return false;
+        }
+
+        int c = client->read();
+        if (c < 0) {
+            return false;
+        }
+
+        if (chunkState == CHUNK_SIZE) {
+            if (c == '\n') {
+                chunkState = chunkLeft > 0 ? CHUNK_DATA : CHUNK_TRAILER;
+                chunkExt = false;
+                lineLen = 0;
+            } else if (c == ';') {
+                chunkExt = true;
+            } else if (!chunkExt && hexValue(c) >= 0) {
+                chunkLeft = chunkLeft * 16 + hexValue(c);
+            }
+        } else if (chunkState == CHUNK_CRLF) {
+            if (c == '\n') {
+                chunkState = CHUNK_SIZE;
+                chunkLeft = 0;
+            }
+        } else {
+            // Trailer lines end with an empty line
+            if (c == '\n') {
+                if (lineLen == 0) {
+                    remaining = 0;
+                }
+                lineLen = 0;
+            } else if (c != '\r') {
+                lineLen++;
+            }
+        }
+    }
+    return true;
+}
+
+void HttpBodyStream::consumed(size_t n) {
+    bytesRead += n;
+    if (chunked) {
+        chunkLeft -= n;
+        if (chunkLeft == 0) {
+            chunkState = CHUNK_CRLF;
+        }
+    } else if (remaining > 0) {
+        remaining -= n;
+    }
+}
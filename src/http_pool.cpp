@@ -0,0 +1,146 @@
+#include "http_pool.h"
+#include "config.h"
+#include "tls_session.h"
+
+HttpConnectionPool::HttpConnectionPool() : connectionsOpened(0), requestCount(0) {}
+
+HttpConnectionPool::~HttpConnectionPool() {
+    for (auto& connection : connections) {
+        close(connection);
+    }
+    connections.clear();
+}
+
+WiFiClient* HttpConnectionPool::acquire(const String& url) {
+    bool secure = false;
+    String key = keyFor(url, secure);
+    if (key.length() == 0) {
+        return nullptr;
+    }
+
+    Connection* found = nullptr;
+    for (auto& connection : connections) {
+        if (!connection.inUse && connection.key == key) {
+            found = &connection;
+            break;
+        }
+    }
+
+    if (!found) {
+        if (connections.size() >= HTTP_POOL_MAX_CONNECTIONS) {
+            // Replace the least recently used idle connection
+            for (auto& connection : connections) {
+                if (!connection.inUse && (!found || connection.lastUsed < found->lastUsed)) {
+                    found = &connection;
+                }
+            }
+            if (!found) {
+                return nullptr;
+            }
+            close(*found);
+        } else {
+            connections.push_back(Connection());
+            found = &connections.back();
+        }
+
+        found->key = key;
+        if (secure) {
+            // Reconnects to the host resume the TLS session
+            TlsResumingClient* client = new TlsResumingClient();
+            // Same trust model as HTTPClient::begin(url) without a CA
+            client->setInsecure();
+            found->client = client;
+        } else {
+            found->client = new WiFiClient();
+        }
+    }
+
+    // Health check: a connection that idled too long or has stray bytes
+    // from an earlier response is not safe to reuse
+    WiFiClient* client = found->client;
+    if (client->connected()) {
+        if (millis() - found->lastUsed > HTTP_POOL_IDLE_MS || client->available() > 0) {
+            client->stop();
+        }
+    }
+
+    if (!client->connected()) {
+        connectionsOpened++;  // HTTPClient will connect it
+    }
+
+    requestCount++;
+    found->inUse = true;
+    found->lastUsed = millis();
+    return client;
+}
+
+void HttpConnectionPool::release(WiFiClient* client) {
+    for (auto& connection : connections) {
+        if (connection.client == client) {
+            if (connection.closeOnRelease) {
+                connection.client->stop();
+                connection.closeOnRelease = false;
+            }
+            connection.inUse = false;
+            connection.lastUsed = millis();
+            return;
+        }
+    }
+}
+
+void HttpConnectionPool::closeIdle() {
+    for (auto& connection : connections) {
+        if (!connection.inUse && connection.client->connected() &&
+            millis() - connection.lastUsed > HTTP_POOL_IDLE_MS) {
+            connection.client->stop();
+        }
+    }
+}
+
+void HttpConnectionPool::closeAll() {
+    // The clients stay allocated: HTTPClient keeps a pointer to the last one
+    for (auto& connection : connections) {
+        if (connection.inUse) {
+            connection.closeOnRelease = true;
+        } else {
+            connection.client->stop();
+        }
+    }
+}
+
+uint32_t HttpConnectionPool::getConnectionsOpened() {
+    return connectionsOpened;
+}
+
+uint32_t HttpConnectionPool::getRequestCount() {
+    return requestCount;
+}
+
+String HttpConnectionPool::keyFor(const String& url, bool& secure) {
+    int schemeEnd = url.indexOf("://");
+    if (schemeEnd < 0) {
+        return "";
+    }
+
+    String scheme = url.substring(0, schemeEnd);
+    scheme.toLowerCase();
+    secure = scheme == "https";
+
+    int hostStart = schemeEnd + 3;
+    int hostEnd = url.indexOf('/', hostStart);
+    String host = hostEnd < 0 ? url.substring(hostStart) : url.substring(hostStart, hostEnd);
+    if (host.indexOf(':') < 0) {
+        host += secure ? ":443" : ":80";
+    }
+    return scheme + "://" + host;
+}
+
+void HttpConnectionPool::close(Connection& connection) {
+    if (connection.client) {
+        connection.client->stop();
+        delete connection.client;
+        connection.client = nullptr;
+    }
+    connection.inUse = false;
+    connection.closeOnRelease = false;
+}
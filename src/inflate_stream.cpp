@@ -0,0 +1,183 @@
+#include "inflate_stream.h"
+#include <esp_heap_caps.h>
+#include <esp32/rom/miniz.h>
+
+namespace {
+
+void* allocBuffer(size_t size) {
+    void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return p ? p : malloc(size);
+}
+
+}  // namespace
+
+InflateStream::InflateStream()
+    : source(nullptr), decompressor(nullptr), dict(nullptr), dictPos(0), outPos(0), outLen(0),
+      inputPos(0), inputLen(0), flags(0), done(false), error(false), bytesOut(0) {}
+
+InflateStream::~InflateStream() {
+    release();
+}
+
+bool InflateStream::begin(HttpBodyStream& source, Format format) {
+    release();
+    this->source = &source;
+    dictPos = 0;
+    outPos = 0;
+    outLen = 0;
+    inputPos = 0;
+    inputLen = 0;
+    done = false;
+    error = false;
+    bytesOut = 0;
+
+    decompressor = (tinfl_decompressor*)allocBuffer(sizeof(tinfl_decompressor));
+    dict = (uint8_t*)allocBuffer(TINFL_LZ_DICT_SIZE);
+    if (!decompressor || !dict) {
+        release();
+        error = true;
+        return false;
+    }
+    tinfl_init(decompressor);
+
+    flags = TINFL_FLAG_HAS_MORE_INPUT;
+    if (format == GZIP) {
+        if (!skipGzipHeader()) {
+            error = true;
+            return false;
+        }
+    } else {
+        // Meant to be zlib-wrapped, but some servers send raw deflate
+        uint8_t cmf, flg;
+        if (!readSourceByte(cmf) || !readSourceByte(flg)) {
+            error = true;
+            return false;
+        }
+        input[0] = cmf;
+        input[1] = flg;
+        inputLen = 2;
+        if ((cmf & 0x0F) == 8 && ((cmf << 8) | flg) % 31 == 0) {
+            flags |= TINFL_FLAG_PARSE_ZLIB_HEADER;
+        }
+    }
+    return true;
+}
+
+bool InflateStream::isComplete() {
+    return done && outLen == 0;
+}
+
+bool InflateStream::hasError() {
+    return error;
+}
+
+size_t InflateStream::getBytesOut() {
+    return bytesOut;
+}
+
+int InflateStream::available() {
+    return fill() ? outLen : 0;
+}
+
+int InflateStream::read() {
+    if (!fill()) {
+        return -1;
+    }
+    uint8_t c = dict[outPos++];
+    outLen--;
+    return c;
+}
+
+int InflateStream::peek() {
+    return fill() ? dict[outPos] : -1;
+}
+
+bool InflateStream::fill() {
+    if (outLen > 0) {
+        return true;
+    }
+
+    while (!done && !error && decompressor) {
+        if (inputPos == inputLen) {
+            int n = source->readAvailable(input, sizeof(input));
+            inputPos = 0;
+            inputLen = n > 0 ? n : 0;
+            if (inputLen == 0) {
+                // The body ending before the compressed stream does is an error
+                error = source->isComplete();
+                return false;
+            }
+        }
+
+        // The dictionary doubles as the output buffer, written circularly
+        size_t inSize = inputLen - inputPos;
+        size_t outSize = TINFL_LZ_DICT_SIZE - dictPos;
+        tinfl_status status = tinfl_decompress(decompressor, input + inputPos, &inSize,
+                                               dict, dict + dictPos, &outSize, flags);
+        inputPos += inSize;
+        outPos = dictPos;
+        outLen = outSize;
+        dictPos = (dictPos + outSize) & (TINFL_LZ_DICT_SIZE - 1);
+        bytesOut += outSize;
+
+        if (status == TINFL_STATUS_DONE) {
+            done = true;
+        } else if (status < 0) {
+            error = true;
+        }
+        if (outLen > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InflateStream::skipGzipHeader() {
+    // RFC 1952: magic, method 8, flags, mtime, xfl, os, then optional fields
+    uint8_t header[10];
+    if (source->readBytes((char*)header, sizeof(header)) != sizeof(header) ||
+        header[0] != 0x1F || header[1] != 0x8B || header[2] != 8) {
+        return false;
+    }
+
+    uint8_t flg = header[3];
+    uint8_t c;
+    if (flg & 0x04) {  // FEXTRA
+        uint8_t lo, hi;
+        if (!readSourceByte(lo) || !readSourceByte(hi)) {
+            return false;
+        }
+        for (size_t n = lo | (hi << 8); n > 0; n--) {
+            if (!readSourceByte(c)) {
+                return false;
+            }
+        }
+    }
+    for (uint8_t text : {0x08, 0x10}) {  // FNAME, FCOMMENT
+        if (flg & text) {
+            do {
+                if (!readSourceByte(c)) {
+                    return false;
+                }
+            } while (c != 0);
+        }
+    }
+    if (flg & 0x02) {  // FHCRC
+        if (!readSourceByte(c) || !readSourceByte(c)) {
+            return false;
+        }
+    }
+    // The CRC-32/size trailer is left for the body to drain
+    return true;
+}
+
+bool InflateStream::readSourceByte(uint8_t& c) {
+    return source->readBytes((char*)&c, 1) == 1;
+}
+
+void InflateStream::release() {
+    free(decompressor);
+    free(dict);
+    decompressor = nullptr;
+    dict = nullptr;
+}
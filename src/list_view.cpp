@@ -0,0 +1,305 @@
+#include "list_view.h"
+#include <math.h>
+
+ListView::ListView(int16_t x, int16_t y, int16_t w, int16_t h, int16_t rowHeight)
+    : x(x), y(y), w(w), h(h), rowHeight(rowHeight), count(0), textCache(nullptr), revision(0), selected(-1),
+      scroll(0), velocity(0), tracking(false), held(false), moving(false), catchTap(false), lastDragMs(0),
+      lastUpdateMs(0), frame(0), lastFrameAt(0), stats{0, 0, 0, 0, 0, 0} {}
+
+ListView::~ListView() {
+    for (auto& row : rows) {
+        row.sprite->deleteSprite();
+        delete row.sprite;
+    }
+}
+
+void ListView::begin(TFT_eSPI* display, bool rowBuffers, TextCache* textCache) {
+    this->textCache = textCache;
+    if (!rowBuffers) {
+        return;
+    }
+
+    // One more than can be partly visible at once, so a row scrolling on
+    // always finds a buffer that is not on screen
+    int needed = h / rowHeight + 2;
+    for (int i = 0; i < needed; i++) {
+        TFT_eSprite* sprite = new TFT_eSprite(display);
+        sprite->setAttribute(PSRAM_ENABLE, true);
+        sprite->setColorDepth(16);
+        if (!sprite->createSprite(w, rowHeight)) {
+            delete sprite;
+            break;
+        }
+        rows.push_back({sprite, -1, 0, 0});
+    }
+
+    if (rows.size() < (size_t)needed) {
+        Serial.println("UI: No memory for list row buffers, drawing rows directly");
+        for (auto& row : rows) {
+            row.sprite->deleteSprite();
+            delete row.sprite;
+        }
+        rows.clear();
+    }
+}
+
+void ListView::setItems(size_t count, const ItemText& text) {
+    this->count = count;
+    this->text = text;
+    revision++;
+    invalidateRows();
+
+    velocity = 0;
+    tracking = false;
+    held = false;
+    catchTap = false;
+    scrollBy(0);  // Clamp to the new length
+}
+
+void ListView::setSelected(int index) {
+    // Rows are buffered with their color, so only the two that change
+    // are rendered again
+    selected = index;
+}
+
+void ListView::scrollToItem(int index) {
+    float top = (float)index * rowHeight;
+    if (top < scroll) {
+        scroll = top;
+    } else if (top + rowHeight > scroll + h) {
+        scroll = top + rowHeight - h;
+    }
+    velocity = 0;
+    scrollBy(0);
+}
+
+int ListView::handleTouch(const TouchEvent& event) {
+    switch (event.type) {
+        case TouchEvent::PRESS:
+            tracking = contains(event.x, event.y);
+            if (!tracking) {
+                return -1;
+            }
+            // Touching a coasting list stops it; the tap that follows is
+            // not a selection
+            catchTap = fabsf(velocity) >= UI_LIST_MIN_VELOCITY;
+            velocity = 0;
+            held = true;
+            lastDragMs = event.timeMs;
+            return -1;
+
+        case TouchEvent::DRAG: {
+            if (!tracking) {
+                return -1;
+            }
+            scrollBy(-event.dy);
+
+            // Drag steps arrive unevenly: smooth the velocity they give
+            uint32_t dt = event.timeMs - lastDragMs;
+            if (dt > 0) {
+                float sample = -(float)event.dy / dt;
+                velocity = velocity * 0.4f + sample * 0.6f;
+            }
+            lastDragMs = event.timeMs;
+            return -1;
+        }
+
+        case TouchEvent::RELEASE:
+        case TouchEvent::SWIPE:
+            if (!tracking) {
+                return -1;
+            }
+            tracking = false;
+            held = false;
+            catchTap = false;
+
+            // A finger that came to a stop before lifting does not fling
+            if (event.timeMs - lastDragMs > UI_LIST_FLING_IDLE_MS) {
+                velocity = 0;
+            }
+            velocity = constrain(velocity, -UI_LIST_MAX_VELOCITY, UI_LIST_MAX_VELOCITY);
+            lastUpdateMs = millis();
+            return -1;
+
+        case TouchEvent::TAP: {
+            if (!tracking) {
+                return -1;
+            }
+            tracking = false;
+            held = false;
+            if (catchTap) {
+                catchTap = false;
+                return -1;
+            }
+            int32_t item = ((int32_t)scroll + event.y - y) / rowHeight;
+            return item < (int32_t)count ? item : -1;
+        }
+    }
+    return -1;
+}
+
+void ListView::update() {
+    uint32_t now = millis();
+    uint32_t dt = min(now - lastUpdateMs, (uint32_t)100);  // A stalled pass must not jump the list
+    lastUpdateMs = now;
+
+    if (!held && velocity != 0) {
+        scrollBy(velocity * dt);
+        velocity *= expf(-(float)dt / UI_LIST_FLING_TAU_MS);
+        if (fabsf(velocity) < UI_LIST_MIN_VELOCITY) {
+            velocity = 0;
+        }
+    }
+
+    bool nowMoving = isMoving();
+    if (moving && !nowMoving) {
+        Serial.printf("UI: List at rest, %u frames moving, last %u ms, max %u ms, draw %u us, %u rows rendered, %u reused\n",
+                      stats.frames, stats.lastFrameMs, stats.maxFrameMs, stats.lastDrawUs, stats.rowsRendered,
+                      stats.rowsReused);
+        lastFrameAt = 0;
+    }
+    moving = nowMoving;
+}
+
+bool ListView::isMoving() {
+    return held || velocity != 0;
+}
+
+void ListView::draw(TFT_eSPI* target, TFT_eSprite* canvas) {
+    uint32_t start = micros();
+    frame++;
+
+    int32_t top = (int32_t)scroll;
+    int32_t item = top / rowHeight;
+    int16_t rowY = y - (top - item * rowHeight);
+
+    bool buffered = canvas && !rows.empty();
+    if (!buffered) {
+        // Clip the partly visible rows at either end
+        target->setViewport(x, y, w, h, false);
+    }
+    for (; rowY < y + h; item++, rowY += rowHeight) {
+        uint16_t color = rowColor(item);
+        if (buffered) {
+            blitRow(canvas, *rowFor(item, color), rowY);
+        } else {
+            renderRow(target, canvas, x, rowY, item, color);
+            stats.rowsRendered++;
+        }
+    }
+    if (!buffered) {
+        target->resetViewport();
+    }
+    stats.lastDrawUs = micros() - start;
+
+    // Frame time as seen on the panel: from one moving frame to the next
+    if (isMoving()) {
+        uint32_t now = millis();
+        if (lastFrameAt != 0) {
+            stats.lastFrameMs = now - lastFrameAt;
+            stats.maxFrameMs = max(stats.maxFrameMs, stats.lastFrameMs);
+        }
+        lastFrameAt = now;
+        stats.frames++;
+    }
+}
+
+uint32_t ListView::getState() {
+    // FNV-1a over what the rows show
+    uint32_t values[] = {(uint32_t)(int32_t)scroll, (uint32_t)selected, (uint32_t)count, revision};
+    uint32_t state = 2166136261u;
+    for (uint32_t value : values) {
+        state ^= value;
+        state *= 16777619u;
+    }
+    return state;
+}
+
+int32_t ListView::getScroll() {
+    return (int32_t)scroll;
+}
+
+int32_t ListView::getContentHeight() {
+    return (int32_t)count * rowHeight;
+}
+
+ListView::Stats ListView::getStats() {
+    return stats;
+}
+
+bool ListView::contains(uint16_t px, uint16_t py) {
+    return px >= x && px < x + w && py >= y && py < y + h;
+}
+
+void ListView::scrollBy(float pixels) {
+    // The ends stop a fling dead
+    scroll += pixels;
+    if (scroll < 0) {
+        scroll = 0;
+        velocity = 0;
+    } else if (scroll > maxScroll()) {
+        scroll = maxScroll();
+        velocity = 0;
+    }
+}
+
+int32_t ListView::maxScroll() {
+    return max((int32_t)0, getContentHeight() - h);
+}
+
+void ListView::invalidateRows() {
+    for (auto& row : rows) {
+        row.item = -1;
+        row.lastUsed = 0;
+    }
+}
+
+ListView::RowBuffer* ListView::rowFor(int32_t item, uint16_t color) {
+    RowBuffer* victim = nullptr;
+    for (auto& row : rows) {
+        if (row.item == item && row.color == color) {
+            row.lastUsed = frame;
+            stats.rowsReused++;
+            return &row;
+        }
+        // The longest off screen gives up its buffer
+        if (row.lastUsed != frame && (!victim || row.lastUsed < victim->lastUsed)) {
+            victim = &row;
+        }
+    }
+
+    victim->item = item;
+    victim->color = color;
+    victim->lastUsed = frame;
+    renderRow(victim->sprite, victim->sprite, 0, 0, item, color);
+    stats.rowsRendered++;
+    return victim;
+}
+
+void ListView::renderRow(TFT_eSPI* target, TFT_eSprite* sprite, int16_t left, int16_t top, int32_t item,
+                         uint16_t color) {
+    // Same look as UIManager::drawRow; past the end is blank background
+    target->fillRect(left, top, w, rowHeight, COLOR_BG);
+    if (item < 0 || item >= (int32_t)count) {
+        return;
+    }
+    target->fillRoundRect(left, top, w, rowHeight - 5, 5, color);
+    textCache->draw(target, sprite, text(item), left + 10, top + rowHeight / 2, 2, ML_DATUM, COLOR_WHITE, color);
+}
+
+void ListView::blitRow(TFT_eSprite* canvas, const RowBuffer& row, int16_t top) {
+    // Both are 16-bit sprites in panel byte order: copy line by line,
+    // clipped to the list
+    uint16_t* dst = (uint16_t*)canvas->getPointer();
+    const uint16_t* src = (const uint16_t*)row.sprite->getPointer();
+    int16_t stride = canvas->width();
+    int16_t from = max(top, y);
+    int16_t to = min((int16_t)(top + rowHeight), (int16_t)(y + h));
+    for (int16_t line = from; line < to; line++) {
+        memcpy(dst + line * stride + x, src + (line - top) * w, w * sizeof(uint16_t));
+    }
+}
+
+uint16_t ListView::rowColor(int32_t item) {
+    return item == selected ? COLOR_PRIMARY : COLOR_DARKGRAY;
+}
@@ -7,6 +7,11 @@
 #include "fm_transmitter.h"
 #include "audio_player.h"
 #include "ui_manager.h"
+#include "touch_input.h"
+#include "channel_catalog.h"
+#include "channel_search.h"
+#include "radio_stations.h"
+#include <memory>
 
 // Global objects
 TFT_eSPI tft = TFT_eSPI();
@@ -15,61 +20,113 @@ WiFiMgr wifiManager;
 SXMClient sxmClient;
 FMTransmitter fmTransmitter;
 AudioPlayer audioPlayer;
+ChannelCatalog catalog;
+ChannelSearchIndex searchIndex;
 UIManager* uiManager;
+TouchInput touchInput;
 
 // State variables
 enum AppState {
     STATE_INIT,
     STATE_WIFI_SETUP,
+    STATE_WIFI_PASSWORD,
     STATE_SXM_SETUP,
     STATE_FM_SETUP,
     STATE_MAIN,
     STATE_CHANNEL_SELECT,
+    STATE_SEARCH,
     STATE_SETTINGS
 };
 
 AppState currentState = STATE_INIT;
 int selectedNetwork = 0;
 int selectedChannel = 0;
-int channelOffset = 0;
 String inputBuffer = "";
 bool inputEmailField = true;
 float currentFMFreq = FM_DEFAULT_FREQ;
 
 std::vector<WiFiNetwork> wifiNetworks;
-std::vector<SXMChannel> sxmChannels;
+const ChannelStore& sxmChannels = sxmClient.getChannels();
+std::vector<int> recentChannels;  // Most recent first, for standby streams
+String playingChannelId;           // Channel whose cached URL is being played
+String searchQuery;
+std::vector<uint16_t> searchResults;
+bool catalogRevalidate = false;    // Booted from the on-flash catalog; refresh it from the network
+uint32_t zapRequest = 0;           // Stream URL lookup for the channel being tuned
+std::vector<uint32_t> standbyRequests;  // Stream URL lookups for the standby streams
+uint32_t bootPhaseMs = 0;          // End of the previous boot phase
+bool bootAwaitingAudio = false;    // Report when the resumed channel is audible
 
 // Forward declarations
 void handleWiFiSetup();
+void handleWiFiPassword();
 void handleSXMSetup();
 void handleFMSetup();
 void handleMainScreen();
 void handleChannelSelect();
+void handleSearch();
 void handleSettings();
 void setupComplete();
+void updateStandbyStreams();
+void checkPlaybackFailure();
+bool loadChannelList();
+void revalidateCatalog();
+void catalogRevalidated(const String& selectedId);
+void startLastChannel();
+bool resumeLastStream(bool catalogLoaded);
+void bootPhase(const char* phase);
+void playChannel(int channelIndex);
+void playStation(int stationIndex);
+void updateSearchResults();
+String channelLabel(size_t index);
 
 void setup() {
     Serial.begin(115200);
     Serial.println("\n\n=== ESP32 SiriusXM IntraRadio ===");
     
-    // Initialize display
+    // Settings first: association can start before anything else is up
+    bool settingsReady = settings.begin();
+    bool connecting = settingsReady && !settings.isFirstRun();
+    if (connecting) {
+        wifiManager.setNetworks(settings.getWiFiNetworks());
+        wifiManager.beginSaved();
+    }
+    bootPhase("wifi start");
+    
+    // Display, catalog, FM and audio init overlap with the association,
+    // which runs on the WiFi task
     tft.init();
     tft.setRotation(1);
     uiManager = new UIManager(&tft);
     uiManager->begin();
     uiManager->drawSplash();
+    touchInput.begin(uiManager);
+    bootPhase("display");
     
-    delay(2000);
-    
-    // Initialize settings
-    if (!settings.begin()) {
+    if (!settingsReady) {
         Serial.println("Failed to initialize settings");
         uiManager->showMessage("Error", "Settings init failed", 3000);
         return;
     }
     
+    // Set SXM server if configured
+    if (settings.hasSXMServer()) {
+        sxmClient.setSXMServer(settings.getSXMServer());
+    }
+    
+    // Cached line-up lets the main screen come up without the network
+    bool catalogLoaded = false;
+    if (catalog.begin() && !settings.isFirstRun()) {
+        ChannelStore cached;
+        catalogLoaded = catalog.load(cached);
+        if (catalogLoaded) {
+            sxmClient.setCachedChannelList(cached, catalog.getETag(), catalog.getLastModified());
+            searchIndex.build(sxmChannels);
+        }
+    }
+    bootPhase("catalog");
+    
     // Initialize FM transmitter
-    uiManager->drawLoading("Init FM...");
     if (!fmTransmitter.begin()) {
         Serial.println("Warning: FM transmitter not found");
         uiManager->showMessage("Warning", "FM TX not found", 2000);
@@ -77,9 +134,9 @@ void setup() {
         currentFMFreq = settings.getFMFrequency();
         fmTransmitter.setFrequency(currentFMFreq);
     }
+    bootPhase("fm");
     
     // Initialize audio player
-    uiManager->drawLoading("Init Audio...");
     if (!audioPlayer.begin()) {
         Serial.println("Failed to initialize audio");
         uiManager->showMessage("Error", "Audio init failed", 3000);
@@ -88,57 +145,84 @@ void setup() {
     
     // Link audio player to FM transmitter for RDS metadata
     audioPlayer.setFMTransmitter(&fmTransmitter);
+    bootPhase("audio");
     
     // Check if first run
-    if (settings.isFirstRun()) {
+    if (!connecting) {
         Serial.println("First run - entering setup mode");
         currentState = STATE_WIFI_SETUP;
-    } else {
-        // Try to connect to saved WiFi
-        uiManager->drawLoading("Connecting WiFi...");
-        String ssid = settings.getWiFiSSID();
-        String password = settings.getWiFiPassword();
+        return;
+    }
+    
+    uiManager->drawLoading("Connecting WiFi...");
+    // Whatever is left of the association timeout, then any saved network
+    if (!wifiManager.waitForConnection(WIFI_TIMEOUT_MS - min((uint32_t)WIFI_TIMEOUT_MS, millis())) &&
+        !wifiManager.connectBestSaved(WIFI_TIMEOUT_MS)) {
+        uiManager->showMessage("Error", "WiFi failed", 3000);
+        currentState = STATE_WIFI_SETUP;
+        return;
+    }
+    bootPhase("wifi");
+    
+    // Load last channel
+    int lastChannel = settings.getLastChannel();
+    if (catalogLoaded && lastChannel > 0 && lastChannel <= sxmChannels.size()) {
+        selectedChannel = lastChannel - 1;
+    }
+    
+    // Music first: the stored URL needs neither login nor a lookup
+    bool resumed = resumeLastStream(catalogLoaded);
+    bootAwaitingAudio = true;
+    
+    if (catalogLoaded) {
+        // Play straight from the catalog; login and the channel
+        // list refresh run once the main screen is up
+        if (resumed) {
+            updateStandbyStreams();
+        } else {
+            startLastChannel();
+        }
+        catalogRevalidate = true;
+        currentState = STATE_MAIN;
+        return;
+    }
+    
+    // Login to SXM
+    uiManager->drawLoading("Login to SXM...");
+    
+    String email = settings.getSXMEmail();
+    String sxmPass = settings.getSXMPassword();
+    
+    if (sxmClient.login(email, sxmPass)) {
+        loadChannelList();
+        bootPhase("channels");
         
-        if (wifiManager.connect(ssid, password)) {
-            Serial.println("Connected to WiFi");
-            
-            // Login to SXM
-            uiManager->drawLoading("Login to SXM...");
-            
-            // Set SXM server if configured
-            if (settings.hasSXMServer()) {
-                sxmClient.setSXMServer(settings.getSXMServer());
-            }
-            
-            String email = settings.getSXMEmail();
-            String sxmPass = settings.getSXMPassword();
-            
-            if (sxmClient.login(email, sxmPass)) {
-                sxmClient.fetchChannelList();
-                sxmChannels = sxmClient.getChannels();
-                
-                // Load last channel
-                int lastChannel = settings.getLastChannel();
-                if (lastChannel > 0 && lastChannel <= sxmChannels.size()) {
-                    selectedChannel = lastChannel - 1;
-                }
-                
-                currentState = STATE_MAIN;
-            } else {
-                uiManager->showMessage("Error", "SXM login failed", 3000);
-                currentState = STATE_SXM_SETUP;
-            }
+        if (lastChannel > 0 && lastChannel <= sxmChannels.size()) {
+            selectedChannel = lastChannel - 1;
+        }
+        if (resumed) {
+            updateStandbyStreams();
         } else {
-            uiManager->showMessage("Error", "WiFi failed", 3000);
-            currentState = STATE_WIFI_SETUP;
+            startLastChannel();
         }
+        
+        currentState = STATE_MAIN;
+    } else {
+        uiManager->showMessage("Error", "SXM login failed", 3000);
+        currentState = STATE_SXM_SETUP;
     }
 }
 
 void loop() {
-    // Update audio player
+    // Forward stream metadata to RDS (decoding runs on its own tasks)
     audioPlayer.loop();
     
+    // Ignition to music, for the boot phase report
+    if (bootAwaitingAudio && audioPlayer.isPlaying()) {
+        bootAwaitingAudio = false;
+        bootPhase("playing");
+    }
+    
     // Update RDS data transmission (call periodically to keep RDS active)
     static unsigned long lastRDSUpdate = 0;
     if (millis() - lastRDSUpdate > 100) {  // Update every 100ms
@@ -146,9 +230,40 @@ void loop() {
         lastRDSUpdate = millis();
     }
     
-    // Handle touch input
-    uint16_t touchX, touchY;
-    bool touched = uiManager->checkTouch(touchX, touchY);
+    // Roam between saved networks; handoffs wait for the jitter buffer,
+    // which matters most while it fills or rebuffers
+    if (currentState != STATE_WIFI_SETUP && currentState != STATE_WIFI_PASSWORD) {
+        wifiManager.loop(audioPlayer.isStreamActive() ? audioPlayer.getBufferedMs() : UINT32_MAX);
+    }
+    
+    // The modem sleeps while the network task rests on a full buffer, and
+    // stays awake while a stream fills or rebuffers with the decoder stopped
+    if (!audioPlayer.isStreamActive()) {
+        wifiManager.setPowerMode(WiFiMgr::POWER_IDLE);
+    } else {
+        wifiManager.setPowerMode(audioPlayer.isRadioResting() ? WiFiMgr::POWER_REST : WiFiMgr::POWER_BURST);
+    }
+    static unsigned long lastPowerReport = 0;
+    if (millis() - lastPowerReport > POWER_REPORT_MS) {
+        WiFiMgr::PowerStats power = wifiManager.getPowerStats();
+        Serial.printf("Power: estimated ~%u mA radio (rest %u s in %u periods, burst %u s, idle %u s), %u underruns\n",
+                      wifiManager.getEstimatedRadioMa(), power.restMs / 1000, power.restPeriods,
+                      power.burstMs / 1000, power.idleMs / 1000, audioPlayer.getUnderrunCount());
+        UIManager::DrawStats draw = uiManager->getDrawStats();
+        Serial.printf("UI: %u frames, %u KB pushed, last frame %u bytes (%u us compose, %u us flush), %u full clears, text %u hits (%u us) / %u misses (%u us)\n",
+                      draw.frames, draw.bytes / 1024, draw.lastFrameBytes, draw.lastComposeUs, draw.lastFlushUs,
+                      draw.fullClears, draw.textHits, draw.textHitUs, draw.textMisses, draw.textMissUs);
+        Serial.printf("SXM: %u requests over %u connections\n",
+                      sxmClient.getRequestCount(), sxmClient.getConnectionsOpened());
+        lastPowerReport = millis();
+    }
+    
+    // Keep cached stream URLs fresh and drop ones that failed to play
+    sxmClient.loop();
+    checkPlaybackFailure();
+    
+    // Sample the panel; handlers take the queued gestures
+    touchInput.poll();
     
     // State machine
     switch (currentState) {
@@ -156,6 +271,10 @@ void loop() {
             handleWiFiSetup();
             break;
             
+        case STATE_WIFI_PASSWORD:
+            handleWiFiPassword();
+            break;
+            
         case STATE_SXM_SETUP:
             handleSXMSetup();
             break;
@@ -172,44 +291,68 @@ void loop() {
             handleChannelSelect();
             break;
             
+        case STATE_SEARCH:
+            handleSearch();
+            break;
+            
         case STATE_SETTINGS:
             handleSettings();
             break;
     }
     
-    delay(50);
+    // Refresh the cached line-up after the main screen has been drawn
+    if (catalogRevalidate && currentState == STATE_MAIN) {
+        revalidateCatalog();
+    }
+    
+    uiManager->endFrame();
+    
+    // A moving list gets a steady frame rate: sleep off what is left of
+    // the frame period instead of a fixed delay. So does a finger on the
+    // panel, which is sampled once per pass.
+    static unsigned long passStart = 0;
+    if (uiManager->isAnimating() || touchInput.isDown()) {
+        unsigned long elapsed = millis() - passStart;
+        delay(elapsed < UI_FRAME_MS ? UI_FRAME_MS - elapsed : 1);
+    } else {
+        delay(50);
+    }
+    passStart = millis();
 }
 
 void handleWiFiSetup() {
-    static bool networksScanned = false;
-    static unsigned long lastTouch = 0;
-    
-    if (!networksScanned) {
-        uiManager->drawLoading("Scanning WiFi...");
-        wifiNetworks = wifiManager.scanNetworks();
-        networksScanned = true;
-        
-        if (wifiNetworks.size() == 0) {
-            uiManager->showMessage("Error", "No networks found", 3000);
-            delay(2000);
-            networksScanned = false;
+    // Entering (or coming back to) the list starts a fresh scan; whatever
+    // is playing keeps playing while it runs
+    if (uiManager->getCurrentScreen() != SCREEN_WIFI_SCAN) {
+        uiManager->setScreen(SCREEN_WIFI_SCAN);
+        wifiNetworks.clear();
+        if (!wifiManager.startScan()) {
+            uiManager->showMessage("Error", "WiFi scan failed", 3000);
+            uiManager->setScreen(SCREEN_NONE);  // Try again
             return;
         }
-        
-        // Draw network list
+        uiManager->drawWiFiScan(std::vector<String>(), selectedNetwork, true);
+    }
+    
+    // The list fills in channel by channel
+    bool scanning = wifiManager.isScanning();
+    if (wifiManager.pollScan() || scanning != wifiManager.isScanning()) {
+        wifiNetworks = wifiManager.getNetworks();
         std::vector<String> networkNames;
         for (const auto& net : wifiNetworks) {
             networkNames.push_back(net.ssid);
         }
-        uiManager->setScreen(SCREEN_WIFI_SCAN);
-        uiManager->drawWiFiScan(networkNames, selectedNetwork);
+        uiManager->drawWiFiScan(networkNames, selectedNetwork, wifiManager.isScanning());
+        
+        if (!wifiManager.isScanning() && wifiNetworks.size() == 0) {
+            uiManager->showMessage("Error", "No networks found", 3000);
+            uiManager->setScreen(SCREEN_NONE);  // Scan again
+            return;
+        }
     }
     
     uint16_t x, y;
-    if (uiManager->checkTouch(x, y)) {
-        if (millis() - lastTouch < 300) return; // Debounce
-        lastTouch = millis();
-        
+    if (touchInput.nextTap(x, y)) {
         // Check if a network was touched
         int itemHeight = 35;
         int touchedItem = (y - 40) / itemHeight;
@@ -218,47 +361,54 @@ void handleWiFiSetup() {
             selectedNetwork = touchedItem;
             
             // Enter password
-            String ssid = wifiNetworks[selectedNetwork].ssid;
             inputBuffer = "";
-            
-            while (true) {
-                uiManager->setScreen(SCREEN_WIFI_PASSWORD);
-                uiManager->drawPasswordInput(ssid, inputBuffer);
-                
-                if (uiManager->checkTouch(x, y)) {
-                    delay(200); // Debounce
-                    
-                    // Check keyboard
-                    char key = uiManager->getKeyboardPress(x, y, false);
-                    if (key != '\0') {
-                        if (key == '\b') {
-                            if (inputBuffer.length() > 0) {
-                                inputBuffer.remove(inputBuffer.length() - 1);
-                            }
-                        } else {
-                            inputBuffer += key;
-                        }
-                        continue;
-                    }
-                    
-                    // Check connect button
-                    if (x >= SCREEN_WIDTH - 90 && x <= SCREEN_WIDTH - 10 && y >= 95 && y <= 125) {
-                        // Connect
-                        uiManager->drawLoading("Connecting...");
-                        
-                        if (wifiManager.connect(ssid, inputBuffer)) {
-                            settings.setWiFiCredentials(ssid, inputBuffer);
-                            uiManager->showMessage("Success", "WiFi connected!", 2000);
-                            currentState = STATE_SXM_SETUP;
-                            return;
-                        } else {
-                            uiManager->showMessage("Error", "Connection failed", 3000);
-                            break;
-                        }
-                    }
+            currentState = STATE_WIFI_PASSWORD;
+        }
+    }
+}
+
+void handleWiFiPassword() {
+    if (selectedNetwork >= wifiNetworks.size()) {
+        currentState = STATE_WIFI_SETUP;
+        return;
+    }
+    String ssid = wifiNetworks[selectedNetwork].ssid;
+    
+    uiManager->setScreen(SCREEN_WIFI_PASSWORD);
+    uiManager->drawPasswordInput(ssid, inputBuffer);
+    
+    uint16_t x, y;
+    if (touchInput.nextTap(x, y)) {
+        // Check keyboard
+        char key = uiManager->getKeyboardPress(x, y, false);
+        if (key != '\0') {
+            if (key == '\b') {
+                if (inputBuffer.length() > 0) {
+                    inputBuffer.remove(inputBuffer.length() - 1);
                 }
-                delay(50);
+            } else {
+                inputBuffer += key;
+            }
+            return;
+        }
+        
+        // Check connect button
+        if (x >= SCREEN_WIDTH - 90 && x <= SCREEN_WIDTH - 10 && y >= 95 && y <= 125) {
+            // Connect
+            uiManager->drawLoading("Connecting...");
+            
+            if (wifiManager.connect(ssid, inputBuffer)) {
+                settings.setWiFiCredentials(ssid, inputBuffer);
+                wifiManager.setNetworks(settings.getWiFiNetworks());
+                uiManager->showMessage("Success", "WiFi connected!", 2000);
+                currentState = STATE_SXM_SETUP;
+            } else {
+                // Back to the list, which scans again
+                uiManager->showMessage("Error", "Connection failed", 3000);
+                currentState = STATE_WIFI_SETUP;
             }
+            // Taps made while connecting were for the old screen
+            touchInput.clear();
         }
     }
 }
@@ -271,9 +421,7 @@ void handleSXMSetup() {
     uiManager->drawSXMLogin(email, password, inputEmailField);
     
     uint16_t x, y;
-    if (uiManager->checkTouch(x, y)) {
-        delay(200); // Debounce
-        
+    if (touchInput.nextTap(x, y)) {
         // Check which field was touched
         if (y >= 50 && y <= 80) {
             inputEmailField = true;
@@ -310,8 +458,7 @@ void handleSXMSetup() {
             
             if (sxmClient.login(email, password)) {
                 settings.setSXMCredentials(email, password);
-                sxmClient.fetchChannelList();
-                sxmChannels = sxmClient.getChannels();
+                loadChannelList();
                 uiManager->showMessage("Success", "Logged in!", 2000);
                 currentState = STATE_FM_SETUP;
             } else {
@@ -326,9 +473,7 @@ void handleFMSetup() {
     uiManager->drawFMConfig(currentFMFreq);
     
     uint16_t x, y;
-    if (uiManager->checkTouch(x, y)) {
-        delay(200); // Debounce
-        
+    if (touchInput.nextTap(x, y)) {
         // Check - button
         if (x >= 60 && x <= 120 && y >= SCREEN_HEIGHT / 2 + 20 && y <= SCREEN_HEIGHT / 2 + 60) {
             currentFMFreq -= 0.2;
@@ -360,17 +505,15 @@ void handleFMSetup() {
 void handleMainScreen() {
     static bool screenDrawn = false;
     
-    if (!screenDrawn) {
-        String channelName = sxmChannels.size() > 0 ? sxmChannels[selectedChannel].name : "No channels";
+    if (!screenDrawn || uiManager->isScreenDamaged()) {
+        String channelName = sxmChannels.size() > 0 ? sxmChannels[selectedChannel].name() : "No channels";
         uiManager->setScreen(SCREEN_MAIN);
         uiManager->drawMainScreen(channelName, "");
         screenDrawn = true;
     }
     
     uint16_t x, y;
-    if (uiManager->checkTouch(x, y)) {
-        delay(200); // Debounce
-        
+    if (touchInput.nextTap(x, y)) {
         // Check SXM logo (channel select)
         if (x >= 10 && x <= 150 && y >= 10 && y <= 90) {
             currentState = STATE_CHANNEL_SELECT;
@@ -389,19 +532,30 @@ void handleChannelSelect() {
     static bool screenDrawn = false;
     
     if (!screenDrawn) {
-        std::vector<String> channelNames;
-        for (const auto& ch : sxmChannels) {
-            channelNames.push_back(ch.number + " - " + ch.name);
-        }
-        
+        // Rows are named as they scroll into view
         uiManager->setScreen(SCREEN_CHANNEL_LIST);
-        uiManager->drawChannelList(channelNames, selectedChannel, channelOffset);
+        uiManager->setChannelList(sxmChannels.size(), channelLabel, selectedChannel);
         screenDrawn = true;
+    } else if (uiManager->isScreenDamaged()) {
+        // Drawn over: repaint it where it was scrolled to
+        uiManager->setScreen(SCREEN_CHANNEL_LIST);
     }
     
-    uint16_t x, y;
-    if (uiManager->checkTouch(x, y)) {
-        delay(200); // Debounce
+    TouchEvent event;
+    while (touchInput.next(event)) {
+        // Drags and flings scroll the list; a tap on a row plays it
+        int channelIndex = uiManager->channelListTouch(event);
+        if (channelIndex >= 0) {
+            playChannel(channelIndex);
+            currentState = STATE_MAIN;
+            screenDrawn = false;
+            return;
+        }
+        if (event.type != TouchEvent::TAP) {
+            continue;
+        }
+        uint16_t x = event.x;
+        uint16_t y = event.y;
         
         // Check back button
         if (x >= 10 && x <= 90 && y >= SCREEN_HEIGHT - 40 && y <= SCREEN_HEIGHT - 5) {
@@ -410,29 +564,73 @@ void handleChannelSelect() {
             return;
         }
         
-        // Check channel selection
-        int itemHeight = 40;
-        int touchedItem = (y - 40) / itemHeight;
+        // Check search button
+        if (x >= SCREEN_WIDTH - 90 && x <= SCREEN_WIDTH - 10 && y >= SCREEN_HEIGHT - 40 && y <= SCREEN_HEIGHT - 5) {
+            currentState = STATE_SEARCH;
+            screenDrawn = false;
+            return;
+        }
+    }
+    
+    uiManager->drawChannelList(selectedChannel);
+}
+
+void handleSearch() {
+    static bool screenDrawn = false;
+    
+    if (!screenDrawn || uiManager->isScreenDamaged()) {
+        uiManager->setScreen(SCREEN_SEARCH);
+        uiManager->drawSearch();
+        updateSearchResults();
+        screenDrawn = true;
+    }
+    
+    uint16_t x, y;
+    if (touchInput.nextTap(x, y)) {
+        // Check back button
+        if (x >= SCREEN_WIDTH - 60 && x <= SCREEN_WIDTH - 10 && y >= 34 && y <= 60) {
+            currentState = STATE_CHANNEL_SELECT;
+            screenDrawn = false;
+            return;
+        }
         
-        if (touchedItem >= 0 && touchedItem < 4) {
-            int channelIndex = channelOffset + touchedItem;
-            if (channelIndex < sxmChannels.size()) {
-                selectedChannel = channelIndex;
-                settings.setLastChannel(selectedChannel + 1);
-                
-                // Play channel
-                uiManager->drawLoading("Loading channel...");
-                String streamUrl = sxmChannels[selectedChannel].streamUrl;
-                
-                if (audioPlayer.play(streamUrl)) {
-                    uiManager->showMessage("Playing", sxmChannels[selectedChannel].name, 2000);
+        // Check delete button
+        if (x >= SCREEN_WIDTH - 115 && x <= SCREEN_WIDTH - 65 && y >= 34 && y <= 60) {
+            if (searchQuery.length() > 0) {
+                searchQuery.remove(searchQuery.length() - 1);
+                updateSearchResults();
+            }
+            return;
+        }
+        
+        // Check result rows
+        int itemHeight = 34;
+        if (y >= 64 && y < 64 + itemHeight * SEARCH_VISIBLE_RESULTS) {
+            size_t row = (y - 64) / itemHeight;
+            if (row < searchResults.size()) {
+                uint16_t item = searchResults[row];
+                if (searchIndex.isStation(item)) {
+                    playStation(searchIndex.stationIndex(item));
                 } else {
-                    uiManager->showMessage("Error", "Failed to play", 3000);
+                    playChannel(item);
                 }
-                
                 currentState = STATE_MAIN;
                 screenDrawn = false;
             }
+            return;
+        }
+        
+        // Check keyboard; results narrow with every key
+        char key = uiManager->getKeyboardPress(x, y, false);
+        if (key != '\0') {
+            if (key == '\b') {
+                if (searchQuery.length() > 0) {
+                    searchQuery.remove(searchQuery.length() - 1);
+                }
+            } else {
+                searchQuery += key;
+            }
+            updateSearchResults();
         }
     }
 }
@@ -440,16 +638,14 @@ void handleChannelSelect() {
 void handleSettings() {
     static bool screenDrawn = false;
     
-    if (!screenDrawn) {
+    if (!screenDrawn || uiManager->isScreenDamaged()) {
         uiManager->setScreen(SCREEN_SETTINGS);
         uiManager->drawSettings();
         screenDrawn = true;
     }
     
     uint16_t x, y;
-    if (uiManager->checkTouch(x, y)) {
-        delay(200); // Debounce
-        
+    if (touchInput.nextTap(x, y)) {
         // Check back button
         if (x >= 10 && x <= 90 && y >= SCREEN_HEIGHT - 40 && y <= SCREEN_HEIGHT - 5) {
             currentState = STATE_MAIN;
@@ -483,3 +679,278 @@ void handleSettings() {
         }
     }
 }
+
+void updateStandbyStreams() {
+    // A newer selection supersedes lookups still in flight
+    for (uint32_t requestId : standbyRequests) {
+        sxmClient.cancel(requestId);
+    }
+    standbyRequests.clear();
+
+    // Keep the next/previous channels and the recently played ones warm
+    int count = sxmChannels.size();
+    if (count < 2) {
+        return;
+    }
+
+    std::vector<int> candidates;
+    candidates.push_back((selectedChannel + 1) % count);
+    candidates.push_back((selectedChannel + count - 1) % count);
+    for (int index : recentChannels) {
+        candidates.push_back(index);
+    }
+
+    std::vector<String> channelIds;
+    for (int index : candidates) {
+        if (index == selectedChannel || index >= count) {
+            continue;
+        }
+        String channelId = sxmChannels[index].id();
+        if (std::find(channelIds.begin(), channelIds.end(), channelId) == channelIds.end()) {
+            channelIds.push_back(channelId);
+        }
+    }
+
+    // Look the URLs up together; the set is handed over once all are back,
+    // in candidate order
+    auto urls = std::make_shared<std::vector<String>>(channelIds.size());
+    auto remaining = std::make_shared<size_t>(channelIds.size());
+    auto finish = [urls]() {
+        std::vector<String> unique;
+        for (const String& url : *urls) {
+            if (url.length() > 0 && std::find(unique.begin(), unique.end(), url) == unique.end()) {
+                unique.push_back(url);
+            }
+        }
+        standbyRequests.clear();
+        audioPlayer.setStandbyUrls(unique);
+    };
+
+    for (size_t i = 0; i < channelIds.size(); i++) {
+        uint32_t requestId = sxmClient.getStreamUrlAsync(channelIds[i], [urls, remaining, finish, i](bool ok, const String& result) {
+            if (ok) {
+                (*urls)[i] = result;
+            }
+            if (--*remaining == 0) {
+                finish();
+            }
+        });
+        if (requestId != 0) {
+            standbyRequests.push_back(requestId);
+        } else {
+            --*remaining;
+        }
+    }
+    if (*remaining == 0) {
+        finish();
+    }
+}
+
+void checkPlaybackFailure() {
+    if (playingChannelId.length() == 0 || audioPlayer.isPlaying()) {
+        return;
+    }
+
+    String error = audioPlayer.getLastError();
+    if (error.length() == 0) {
+        return;  // Still connecting or buffering
+    }
+
+    // The cached URL may have expired on the server side: fetch a fresh one once
+    String channelId = playingChannelId;
+    playingChannelId = "";
+    sxmClient.invalidateStreamUrl(channelId);
+
+    sxmClient.cancel(zapRequest);
+    zapRequest = sxmClient.getStreamUrlAsync(channelId, [channelId](bool ok, const String& result) {
+        zapRequest = 0;
+        if (ok) {
+            Serial.printf("Retrying %s with a fresh stream URL\n", channelId.c_str());
+            if (audioPlayer.play(result)) {
+                settings.setLastStream(channelId, result);
+            }
+        }
+    });
+}
+
+bool loadChannelList() {
+    if (!sxmClient.fetchChannelList()) {
+        return false;
+    }
+    
+    catalog.save(sxmChannels, sxmClient.getChannelListETag(), sxmClient.getChannelListLastModified());
+    searchIndex.build(sxmChannels);
+    return true;
+}
+
+void revalidateCatalog() {
+    catalogRevalidate = false;
+    
+    // Playback and the UI keep running; a failure leaves the cached list
+    sxmClient.loginAsync(settings.getSXMEmail(), settings.getSXMPassword(), [](bool ok, const String& error) {
+        if (!ok) {
+            Serial.printf("Catalog revalidation failed: %s\n", error.c_str());
+            return;
+        }
+        
+        String selectedId = selectedChannel < sxmChannels.size() ? sxmChannels[selectedChannel].id() : "";
+        sxmClient.fetchChannelListAsync([selectedId](bool ok, const String& error) {
+            if (!ok) {
+                Serial.printf("Catalog revalidation failed: %s\n", error.c_str());
+                return;
+            }
+            catalogRevalidated(selectedId);
+        });
+    });
+}
+
+void catalogRevalidated(const String& selectedId) {
+    if (!sxmClient.wasChannelListModified()) {
+        // Same line-up (or 304); only store it again if the validators moved
+        if (sxmClient.getChannelListETag() != catalog.getETag() ||
+            sxmClient.getChannelListLastModified() != catalog.getLastModified()) {
+            catalog.save(sxmChannels, sxmClient.getChannelListETag(), sxmClient.getChannelListLastModified());
+        }
+        Serial.println("Catalog is up to date");
+        return;
+    }
+    
+    // Keep the selection on the same channel if it moved
+    ChannelStore::Channel selected = sxmClient.getChannelById(selectedId);
+    selectedChannel = selected ? selected.getIndex() : 0;
+    recentChannels.clear();
+    
+    catalog.save(sxmChannels, sxmClient.getChannelListETag(), sxmClient.getChannelListLastModified());
+    searchIndex.build(sxmChannels);
+    updateStandbyStreams();
+    
+    // The list and search screens may be open on the old line-up: their
+    // row counts and result indexes point into it
+    if (currentState == STATE_CHANNEL_SELECT) {
+        uiManager->setChannelList(sxmChannels.size(), channelLabel, selectedChannel);
+    } else if (currentState == STATE_SEARCH) {
+        updateSearchResults();
+    } else {
+        searchResults.clear();
+    }
+}
+
+void startLastChannel() {
+    if (selectedChannel >= sxmChannels.size()) {
+        return;
+    }
+    
+    String channelId = sxmChannels[selectedChannel].id();
+    sxmClient.cancel(zapRequest);
+    zapRequest = sxmClient.getStreamUrlAsync(channelId, [channelId](bool ok, const String& result) {
+        zapRequest = 0;
+        if (ok && audioPlayer.play(result)) {
+            playingChannelId = channelId;
+            settings.setLastStream(channelId, result);
+            updateStandbyStreams();
+        }
+    });
+}
+
+bool resumeLastStream(bool catalogLoaded) {
+    String channelId = settings.getLastStreamChannel();
+    String url = settings.getLastStreamUrl();
+    if (channelId.length() == 0 || url.length() == 0) {
+        return false;
+    }
+    
+    // With a line-up at hand, only resume the channel it has selected
+    if (catalogLoaded && (selectedChannel >= sxmChannels.size() || sxmChannels[selectedChannel].id() != channelId)) {
+        return false;
+    }
+    
+    // An expired URL fails like any other: checkPlaybackFailure() then
+    // looks up a fresh one
+    Serial.printf("Resuming %s from the stored stream URL\n", channelId.c_str());
+    if (!audioPlayer.play(url)) {
+        return false;
+    }
+    playingChannelId = channelId;
+    return true;
+}
+
+void bootPhase(const char* phase) {
+    uint32_t now = millis();
+    Serial.printf("Boot: %-10s at %5u ms (+%u ms)\n", phase, now, now - bootPhaseMs);
+    bootPhaseMs = now;
+}
+
+void playChannel(int channelIndex) {
+    if (channelIndex < 0 || (size_t)channelIndex >= sxmChannels.size()) {
+        return;
+    }
+    
+    // Remember the channel we leave so it stays warm
+    if (channelIndex != selectedChannel) {
+        recentChannels.erase(std::remove(recentChannels.begin(), recentChannels.end(), selectedChannel),
+                             recentChannels.end());
+        recentChannels.insert(recentChannels.begin(), selectedChannel);
+        if (recentChannels.size() > STANDBY_RECENT_CHANNELS) {
+            recentChannels.resize(STANDBY_RECENT_CHANNELS);
+        }
+    }
+
+    selectedChannel = channelIndex;
+    settings.setLastChannel(selectedChannel + 1);
+    
+    // Play channel once its URL is back; the UI stays live meanwhile and
+    // only the last of several quick zaps is resolved
+    String channelId = sxmChannels[selectedChannel].id();
+    sxmClient.cancel(zapRequest);
+    zapRequest = sxmClient.getStreamUrlAsync(channelId, [channelId](bool ok, const String& result) {
+        zapRequest = 0;
+        if (ok && audioPlayer.play(result)) {
+            playingChannelId = channelId;
+            settings.setLastStream(channelId, result);
+            updateStandbyStreams();
+        } else {
+            uiManager->showToast("Failed to play", 3000);
+        }
+    });
+    if (zapRequest == 0) {
+        uiManager->showToast("Failed to play", 3000);
+    }
+}
+
+void playStation(int stationIndex) {
+    const InternetRadioStation* station = getInternetRadioStation(stationIndex);
+    if (!station) {
+        return;
+    }
+    
+    // A channel still being looked up must not take over
+    sxmClient.cancel(zapRequest);
+    zapRequest = 0;
+    
+    uiManager->drawLoading("Loading station...");
+    if (audioPlayer.play(station->url)) {
+        playingChannelId = "";  // Not an SXM channel: no cached URL to refresh
+        uiManager->showMessage("Playing", station->name, 2000);
+    } else {
+        uiManager->showMessage("Error", "Failed to play", 3000);
+    }
+}
+
+void updateSearchResults() {
+    size_t total = searchIndex.search(searchQuery, searchResults, SEARCH_VISIBLE_RESULTS);
+    
+    std::vector<String> labels;
+    for (uint16_t item : searchResults) {
+        if (searchIndex.isStation(item)) {
+            labels.push_back(INTERNET_RADIO_STATIONS[searchIndex.stationIndex(item)].name);
+        } else {
+            labels.push_back(channelLabel(item));
+        }
+    }
+    
+    uiManager->drawSearchResults(searchQuery, labels, total);
+}
+
+String channelLabel(size_t index) {
+    return String(sxmChannels[index].number()) + " - " + sxmChannels[index].name();
+}
@@ -1,5 +1,6 @@
 #include "settings.h"
 #include "config.h"
+#include <algorithm>
 
 Settings::Settings() {}
 
@@ -31,6 +32,77 @@ String Settings::getWiFiPassword() {
 void Settings::setWiFiCredentials(const String& ssid, const String& password) {
     preferences.putString(KEY_WIFI_SSID, ssid);
     preferences.putString(KEY_WIFI_PASS, password);
+    
+    std::vector<SavedNetwork> networks = getWiFiNetworks();
+    uint8_t priority = networks.empty() ? 0 : networks[0].priority;
+    if (networks.empty() || networks[0].ssid != ssid) {
+        priority = min(priority + 1, 255);
+    }
+    addWiFiNetwork(ssid, password, priority);
+}
+
+std::vector<SavedNetwork> Settings::getWiFiNetworks() {
+    std::vector<SavedNetwork> networks;
+    uint8_t count = preferences.getUChar(KEY_WIFI_COUNT, 0);
+    for (uint8_t i = 0; i < count && i < WIFI_MAX_NETWORKS; i++) {
+        SavedNetwork network;
+        network.ssid = preferences.getString((KEY_WIFI_SSID_N + String(i)).c_str(), "");
+        network.password = preferences.getString((KEY_WIFI_PASS_N + String(i)).c_str(), "");
+        network.priority = preferences.getUChar((KEY_WIFI_PRIO_N + String(i)).c_str(), 0);
+        if (network.ssid.length() > 0) {
+            networks.push_back(network);
+        }
+    }
+    
+    // Stored before there was a list: the single network is the list
+    if (networks.empty() && hasWiFiCredentials()) {
+        networks.push_back({getWiFiSSID(), getWiFiPassword(), 0});
+    }
+    
+    std::stable_sort(networks.begin(), networks.end(), [](const SavedNetwork& a, const SavedNetwork& b) {
+        return a.priority > b.priority;
+    });
+    return networks;
+}
+
+void Settings::addWiFiNetwork(const String& ssid, const String& password, uint8_t priority) {
+    std::vector<SavedNetwork> networks = getWiFiNetworks();
+    networks.erase(std::remove_if(networks.begin(), networks.end(),
+                                  [&](const SavedNetwork& network) { return network.ssid == ssid; }),
+                   networks.end());
+    networks.push_back({ssid, password, priority});
+    
+    // Full: the lowest priority network goes
+    std::stable_sort(networks.begin(), networks.end(), [](const SavedNetwork& a, const SavedNetwork& b) {
+        return a.priority > b.priority;
+    });
+    if (networks.size() > WIFI_MAX_NETWORKS) {
+        networks.resize(WIFI_MAX_NETWORKS);
+    }
+    saveWiFiNetworks(networks);
+}
+
+void Settings::removeWiFiNetwork(const String& ssid) {
+    std::vector<SavedNetwork> networks = getWiFiNetworks();
+    networks.erase(std::remove_if(networks.begin(), networks.end(),
+                                  [&](const SavedNetwork& network) { return network.ssid == ssid; }),
+                   networks.end());
+    saveWiFiNetworks(networks);
+}
+
+void Settings::saveWiFiNetworks(const std::vector<SavedNetwork>& networks) {
+    uint8_t oldCount = preferences.getUChar(KEY_WIFI_COUNT, 0);
+    for (uint8_t i = 0; i < networks.size(); i++) {
+        preferences.putString((KEY_WIFI_SSID_N + String(i)).c_str(), networks[i].ssid);
+        preferences.putString((KEY_WIFI_PASS_N + String(i)).c_str(), networks[i].password);
+        preferences.putUChar((KEY_WIFI_PRIO_N + String(i)).c_str(), networks[i].priority);
+    }
+    for (uint8_t i = networks.size(); i < oldCount; i++) {
+        preferences.remove((KEY_WIFI_SSID_N + String(i)).c_str());
+        preferences.remove((KEY_WIFI_PASS_N + String(i)).c_str());
+        preferences.remove((KEY_WIFI_PRIO_N + String(i)).c_str());
+    }
+    preferences.putUChar(KEY_WIFI_COUNT, networks.size());
 }
 
 // SiriusXM Settings
@@ -82,6 +154,24 @@ void Settings::setLastChannel(int channel) {
     preferences.putInt(KEY_LAST_CHANNEL, channel);
 }
 
+String Settings::getLastStreamChannel() {
+    return preferences.getString(KEY_LAST_STREAM_ID, "");
+}
+
+String Settings::getLastStreamUrl() {
+    return preferences.getString(KEY_LAST_STREAM_URL, "");
+}
+
+void Settings::setLastStream(const String& channelId, const String& url) {
+    // Every zap lands here; only touch flash when something changed
+    if (getLastStreamChannel() != channelId) {
+        preferences.putString(KEY_LAST_STREAM_ID, channelId);
+    }
+    if (getLastStreamUrl() != url) {
+        preferences.putString(KEY_LAST_STREAM_URL, url);
+    }
+}
+
 // First run flag
 bool Settings::isFirstRun() {
     return !preferences.getBool("setup_done", false);
@@ -0,0 +1,292 @@
+#include "standby_manager.h"
+#include "config.h"
+#include <esp_heap_caps.h>
+
+StandbyManager::StandbyManager()
+    : lastOpenMs(0), warmCount(0), openQueue(nullptr), openTask(nullptr), owner(nullptr) {}
+
+StandbyManager::~StandbyManager() {
+    // The player lives as long as the firmware runs, so an open in progress
+    // here is not waited for
+    if (openTask) {
+        vTaskDelete(openTask);
+    }
+    if (openQueue) {
+        vQueueDelete(openQueue);
+    }
+    for (Slot* slot : slots) {
+        delete slot->session;
+        free(slot->storage);
+        delete slot;
+    }
+    slots.clear();
+}
+
+bool StandbyManager::begin(size_t budgetBytes) {
+    size_t count = min((size_t)STANDBY_MAX_STREAMS, budgetBytes / STANDBY_BUFFER_SIZE);
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t* storage = (uint8_t*)heap_caps_malloc(STANDBY_BUFFER_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!storage) {
+            break;
+        }
+
+        Slot* slot = new Slot();
+        slot->storage = storage;
+        slot->ring.attach(storage, STANDBY_BUFFER_SIZE);
+        slot->session = new StreamSession();
+        slot->session->setPrefetchLimit(1);
+        slot->lastUsed = 0;
+        slot->retryAt = 0;
+        slot->state.store(IDLE, std::memory_order_relaxed);
+        slots.push_back(slot);
+    }
+
+    if (!slots.empty()) {
+        openQueue = xQueueCreate(1, sizeof(Slot*));
+        if (openQueue) {
+            xTaskCreatePinnedToCore(openTaskEntry, "standby_open", STANDBY_TASK_STACK, this,
+                                    STANDBY_TASK_PRIORITY, &openTask, STANDBY_TASK_CORE);
+        }
+        if (!openTask) {
+            Serial.println("Standby: Failed to start the open task");
+        }
+    }
+
+    Serial.printf("Standby: %u streams of %u KB\n", slots.size(), STANDBY_BUFFER_SIZE / 1024);
+    return !slots.empty();
+}
+
+void StandbyManager::setWanted(const std::vector<String>& urls) {
+    wanted = urls;
+
+    // A slot still opening is released when it is handed back
+    for (Slot* slot : slots) {
+        if (slot->state.load(std::memory_order_acquire) == IDLE && slot->url.length() > 0 &&
+            !isWanted(slot->url)) {
+            Serial.printf("Standby: Releasing %s\n", slot->url.c_str());
+            park(*slot);
+        }
+    }
+    countWarm();
+}
+
+void StandbyManager::pump(bool allowOpen) {
+    bool opening = false;
+    for (Slot* slot : slots) {
+        uint8_t state = slot->state.load(std::memory_order_acquire);
+        if (state == OPENING) {
+            opening = true;
+            continue;
+        }
+        if (state != IDLE) {
+            finishOpen(*slot, state == OPENED);
+        }
+        if (!slot->session->isOpen()) {
+            continue;
+        }
+
+        // Nobody consumes a standby ring, so drop the oldest audio to keep
+        // the newest few seconds ready
+        size_t space = slot->ring.space();
+        if (space < STREAM_CHUNK_SIZE) {
+            slot->ring.discard(STREAM_CHUNK_SIZE - space);
+        }
+
+        if (slot->session->pump(slot->ring) < 0) {
+            Serial.printf("Standby: %s dropped (%s)\n", slot->url.c_str(), slot->session->getLastError().c_str());
+            slot->session->close();
+            slot->ring.clear();
+            slot->retryAt = millis() + STANDBY_RETRY_MS;
+        }
+    }
+
+    countWarm();
+    if (!allowOpen || opening || !openTask || millis() - lastOpenMs < STANDBY_OPEN_INTERVAL_MS) {
+        return;
+    }
+
+    // Connect the most important missing stream, one at a time
+    for (const String& url : wanted) {
+        Slot* slot = find(url);
+        if (slot && slot->session->isOpen()) {
+            continue;
+        }
+        if (slot && (int32_t)(millis() - slot->retryAt) < 0) {
+            continue;
+        }
+        if (!slot) {
+            slot = victim();
+        }
+        if (!slot) {
+            return;
+        }
+
+        lastOpenMs = millis();
+        park(*slot);
+        slot->url = url;
+        slot->lastUsed = millis();
+
+        owner = xTaskGetCurrentTaskHandle();
+        slot->state.store(OPENING, std::memory_order_release);
+        if (xQueueSend(openQueue, &slot, 0) != pdTRUE) {
+            slot->state.store(IDLE, std::memory_order_release);
+        }
+        return;
+    }
+}
+
+bool StandbyManager::exchange(const String& wantUrl, StreamSession*& active, const String& activeUrl, RingBuffer& dest) {
+    bool keepPrevious = active->isOpen() && activeUrl.length() > 0 && activeUrl != wantUrl;
+    Slot* warm = find(wantUrl);
+    if (warm && warm->state.load(std::memory_order_acquire) != IDLE) {
+        warm = nullptr;  // Still opening: the zap is cold
+    }
+
+    if (isReady(warm)) {
+        // Hand over what the standby stream has buffered
+        uint8_t chunk[STREAM_CHUNK_SIZE];
+        size_t n;
+        while ((n = warm->ring.read(chunk, min(sizeof(chunk), dest.space()))) > 0) {
+            dest.write(chunk, n);
+        }
+        warm->ring.clear();
+
+        std::swap(warm->session, active);
+        if (keepPrevious) {
+            warm->url = activeUrl;
+            warm->lastUsed = millis();
+            warm->session->setTitleCallback(nullptr);
+            warm->session->setPrefetchLimit(1);
+        } else {
+            park(*warm);
+        }
+        countWarm();
+        return true;
+    }
+
+    if (keepPrevious) {
+        Slot* slot = warm ? warm : victim();
+        if (!slot) {
+            // Every slot is wanted; evict the least recently used
+            for (Slot* candidate : slots) {
+                if (candidate->state.load(std::memory_order_acquire) != IDLE) {
+                    continue;
+                }
+                if (!slot || candidate->lastUsed < slot->lastUsed) {
+                    slot = candidate;
+                }
+            }
+        }
+
+        if (slot) {
+            park(*slot);
+            std::swap(slot->session, active);
+            slot->url = activeUrl;
+            slot->lastUsed = millis();
+            slot->session->setTitleCallback(nullptr);
+            slot->session->setPrefetchLimit(1);
+        }
+    }
+
+    active->close();
+    countWarm();
+    return false;
+}
+
+bool StandbyManager::isWarm(const String& url) {
+    return isReady(find(url));
+}
+
+size_t StandbyManager::getWarmCount() {
+    return warmCount.load(std::memory_order_acquire);
+}
+
+size_t StandbyManager::getCapacity() {
+    return slots.size();
+}
+
+void StandbyManager::openTaskEntry(void* arg) {
+    static_cast<StandbyManager*>(arg)->openLoop();
+}
+
+void StandbyManager::openLoop() {
+    Slot* slot;
+    for (;;) {
+        if (xQueueReceive(openQueue, &slot, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        bool ok = slot->session->open(slot->url);
+        slot->state.store(ok ? OPENED : FAILED, std::memory_order_release);
+        xTaskNotifyGive(owner);
+    }
+}
+
+void StandbyManager::finishOpen(Slot& slot, bool ok) {
+    slot.state.store(IDLE, std::memory_order_release);
+    if (!ok) {
+        Serial.printf("Standby: Failed to open %s\n", slot.url.c_str());
+        slot.session->close();
+        slot.retryAt = millis() + STANDBY_RETRY_MS;
+    } else if (!isWanted(slot.url)) {
+        // Dropped from the wanted list while it was opening
+        park(slot);
+    } else {
+        Serial.printf("Standby: Warming %s\n", slot.url.c_str());
+    }
+}
+
+bool StandbyManager::isReady(Slot* slot) {
+    return slot && slot->state.load(std::memory_order_acquire) == IDLE && slot->session->isOpen();
+}
+
+void StandbyManager::countWarm() {
+    size_t count = 0;
+    for (Slot* slot : slots) {
+        if (isReady(slot)) {
+            count++;
+        }
+    }
+    warmCount.store(count, std::memory_order_release);
+}
+
+StandbyManager::Slot* StandbyManager::find(const String& url) {
+    for (Slot* slot : slots) {
+        if (slot->url == url) {
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+StandbyManager::Slot* StandbyManager::victim() {
+    // Prefer an empty slot, then one holding a stream nobody wants; a slot
+    // being opened is not ours to take
+    for (Slot* slot : slots) {
+        if (slot->state.load(std::memory_order_acquire) == IDLE && slot->url.length() == 0) {
+            return slot;
+        }
+    }
+    for (Slot* slot : slots) {
+        if (slot->state.load(std::memory_order_acquire) == IDLE && !isWanted(slot->url)) {
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+bool StandbyManager::isWanted(const String& url) {
+    for (const String& w : wanted) {
+        if (w == url) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void StandbyManager::park(Slot& slot) {
+    slot.session->close();
+    slot.ring.clear();
+    slot.url = "";
+    slot.retryAt = 0;
+}
@@ -0,0 +1,203 @@
+#include "stream_session.h"
+#include "stream_source.h"
+#include "config.h"
+
+StreamSession::StreamSession()
+    : stream(nullptr), hlsMode(false), metaInterval(0), audioUntilMeta(0), metaRemaining(0) {
+    // Same trust model as HTTPClient::begin(url) without a CA
+    tlsClient.setInsecure();
+}
+
+StreamSession::~StreamSession() {
+    close();
+}
+
+bool StreamSession::open(const String& streamUrl) {
+    close();
+    url = streamUrl;
+    lastError = "";
+
+    http.setTimeout(HTTP_TIMEOUT_MS);
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+
+    bool secure = url.startsWith("https://") || url.startsWith("HTTPS://");
+    if (!(secure ? http.begin(tlsClient, url) : http.begin(url))) {
+        lastError = "Invalid stream URL";
+        return false;
+    }
+
+    const char* headerKeys[] = {"Content-Type", "icy-metaint", "icy-name"};
+    http.collectHeaders(headerKeys, 3);
+    http.addHeader("Icy-MetaData", "1");
+
+    int httpCode = http.GET();
+    if (httpCode != HTTP_CODE_OK) {
+        lastError = "Stream connect failed: HTTP " + String(httpCode);
+        http.end();
+        return false;
+    }
+
+    contentType = http.header("Content-Type");
+
+    if (isPlaylistContentType(contentType, url)) {
+        hlsMode = hls.begin(url, http);
+        http.end();
+        if (!hlsMode) {
+            lastError = hls.getLastError();
+        }
+        return hlsMode;
+    }
+
+    metaInterval = http.header("icy-metaint").toInt();
+    audioUntilMeta = metaInterval;
+    metaRemaining = 0;
+    metaBuffer = "";
+    lastTitle = "";
+    stream = http.getStreamPtr();
+
+    Serial.printf("Stream: Connected (%s, metaint %u)\n", contentType.c_str(), metaInterval);
+    return true;
+}
+
+void StreamSession::close() {
+    if (hlsMode) {
+        hls.close();
+        hlsMode = false;
+    }
+    if (stream) {
+        http.end();
+        stream = nullptr;
+    }
+    // A live stream is never reused; the TLS session outlives it in the cache
+    tlsClient.stop();
+}
+
+bool StreamSession::isOpen() {
+    return stream != nullptr || hlsMode;
+}
+
+int StreamSession::pump(RingBuffer& ring) {
+    if (hlsMode) {
+        int delivered = hls.pump(ring);
+        if (delivered < 0) {
+            lastError = hls.getLastError();
+        }
+        return delivered;
+    }
+
+    if (!stream) {
+        return -1;
+    }
+
+    size_t space = ring.space();
+    if (space == 0) {
+        return 0;
+    }
+
+    int avail = stream->available();
+    if (avail <= 0) {
+        if (!stream->connected()) {
+            lastError = "Stream ended";
+            return -1;
+        }
+        return 0;
+    }
+
+    uint8_t chunk[STREAM_CHUNK_SIZE];
+    size_t want = min((size_t)avail, min(space, sizeof(chunk)));
+    int n = stream->read(chunk, want);
+    if (n <= 0) {
+        return 0;
+    }
+
+    if (metaInterval == 0) {
+        return ring.write(chunk, n);
+    }
+
+    // Split the chunk into audio runs and metadata blocks
+    int delivered = 0;
+    int i = 0;
+    while (i < n) {
+        if (metaRemaining > 0) {
+            int take = min((int)metaRemaining, n - i);
+            metaBuffer.concat((const char*)chunk + i, take);
+            metaRemaining -= take;
+            i += take;
+            if (metaRemaining == 0) {
+                handleMetadata();
+            }
+        } else if (audioUntilMeta == 0) {
+            metaRemaining = chunk[i++] * 16;
+            metaBuffer = "";
+            audioUntilMeta = metaInterval;
+        } else {
+            int take = min((int)audioUntilMeta, n - i);
+            delivered += ring.write(chunk + i, take);
+            audioUntilMeta -= take;
+            i += take;
+        }
+    }
+
+    return delivered;
+}
+
+void StreamSession::handleMetadata() {
+    int start = metaBuffer.indexOf("StreamTitle='");
+    if (start < 0) {
+        return;
+    }
+    start += 13;
+
+    int end = metaBuffer.indexOf("';", start);
+    if (end < 0) {
+        end = metaBuffer.lastIndexOf('\'');
+    }
+    if (end < start) {
+        return;
+    }
+
+    String title = metaBuffer.substring(start, end);
+    if (title.length() > 0 && title != lastTitle && titleCallback) {
+        lastTitle = title;
+        titleCallback(title);
+    }
+}
+
+void StreamSession::setTitleCallback(std::function<void(const String&)> callback) {
+    titleCallback = callback;
+}
+
+String StreamSession::getUrl() {
+    return url;
+}
+
+String StreamSession::getContentType() {
+    return contentType;
+}
+
+bool StreamSession::isPlaylist() {
+    return hlsMode;
+}
+
+String StreamSession::getLastError() {
+    return lastError;
+}
+
+void StreamSession::setPrefetchLimit(uint8_t segments) {
+    hls.setMaxInFlight(segments);
+}
+
+const char* StreamSession::getCodecPath() {
+    if (hlsMode) {
+        return codecPathForContentType("", hls.getFirstSegmentUrl());
+    }
+    return codecPathForContentType(contentType, url);
+}
+
+uint32_t StreamSession::getLastSegmentMs() {
+    return hlsMode ? hls.getLastSegmentMs() : 0;
+}
+
+uint32_t StreamSession::getAverageSegmentMs() {
+    return hlsMode ? hls.getAverageSegmentMs() : 0;
+}
@@ -0,0 +1,188 @@
+#include "stream_source.h"
+#include "config.h"
+
+namespace {
+
+// Read-only, endless file over a RingBuffer
+class RingFileImpl : public fs::FileImpl {
+public:
+    RingFileImpl(RingBuffer* ring, const char* path) : ring(ring), consumed(0), open(true) {
+        strncpy(filePath, path, sizeof(filePath) - 1);
+        filePath[sizeof(filePath) - 1] = '\0';
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        return 0;
+    }
+
+    size_t read(uint8_t* buf, size_t size) override {
+        if (!open || !ring) {
+            return 0;
+        }
+        size_t n = ring->read(buf, size);
+        consumed += n;
+        return n;
+    }
+
+    void flush() override {}
+
+    bool seek(uint32_t pos, fs::SeekMode mode) override {
+        // A live stream can only move forward, and only over bytes we already have
+        size_t target = pos;
+        if (mode == fs::SeekCur) {
+            target = consumed + pos;
+        } else if (mode == fs::SeekEnd) {
+            return false;
+        }
+
+        if (target == consumed) {
+            return true;
+        }
+        if (target < consumed || !ring || target - consumed > ring->available()) {
+            return false;
+        }
+        consumed += ring->discard(target - consumed);
+        return true;
+    }
+
+    size_t position() const override {
+        return consumed;
+    }
+
+    size_t size() const override {
+        return STREAM_VIRTUAL_SIZE;
+    }
+
+    bool setBufferSize(size_t size) {
+        return true;
+    }
+
+    void close() override {
+        open = false;
+    }
+
+    time_t getLastWrite() override {
+        return 0;
+    }
+
+    const char* path() const override {
+        return filePath;
+    }
+
+    const char* name() const override {
+        const char* slash = strrchr(filePath, '/');
+        return slash ? slash + 1 : filePath;
+    }
+
+    boolean isDirectory(void) override {
+        return false;
+    }
+
+    fs::FileImplPtr openNextFile(const char* mode) override {
+        return fs::FileImplPtr();
+    }
+
+    boolean seekDir(long position) {
+        return false;
+    }
+
+    String getNextFileName(void) {
+        return "";
+    }
+
+    String getNextFileName(bool* isDir) {
+        return "";
+    }
+
+    void rewindDirectory(void) override {}
+
+    operator bool() override {
+        return open && ring != nullptr;
+    }
+
+private:
+    RingBuffer* ring;
+    size_t consumed;
+    bool open;
+    char filePath[32];
+};
+
+} // namespace
+
+RingStreamFS::RingStreamFS() : ring(nullptr) {}
+
+void RingStreamFS::setRing(RingBuffer* newRing) {
+    ring = newRing;
+}
+
+RingBuffer* RingStreamFS::getRing() {
+    return ring;
+}
+
+fs::FileImplPtr RingStreamFS::open(const char* path, const char* mode, const bool create) {
+    if (!ring || (mode && mode[0] != 'r')) {
+        return fs::FileImplPtr();
+    }
+    return std::make_shared<RingFileImpl>(ring, path);
+}
+
+bool RingStreamFS::exists(const char* path) {
+    return ring != nullptr;
+}
+
+bool RingStreamFS::rename(const char* pathFrom, const char* pathTo) {
+    return false;
+}
+
+bool RingStreamFS::remove(const char* path) {
+    return false;
+}
+
+bool RingStreamFS::mkdir(const char* path) {
+    return false;
+}
+
+bool RingStreamFS::rmdir(const char* path) {
+    return false;
+}
+
+const char* codecPathForContentType(const String& contentType, const String& url) {
+    String type = contentType;
+    type.toLowerCase();
+    String lowerUrl = url;
+    lowerUrl.toLowerCase();
+
+    int query = lowerUrl.indexOf('?');
+    if (query >= 0) {
+        lowerUrl = lowerUrl.substring(0, query);
+    }
+
+    if (type.indexOf("aac") >= 0 || lowerUrl.endsWith(".aac")) {
+        return "/stream.aac";
+    }
+    if (type.indexOf("ogg") >= 0 || type.indexOf("opus") >= 0 || lowerUrl.endsWith(".ogg")) {
+        return "/stream.ogg";
+    }
+    if (type.indexOf("flac") >= 0 || lowerUrl.endsWith(".flac")) {
+        return "/stream.flac";
+    }
+    if (type.indexOf("wav") >= 0 || lowerUrl.endsWith(".wav")) {
+        return "/stream.wav";
+    }
+    // audio/mpeg and unknown types: most internet radio is MP3
+    return "/stream.mp3";
+}
+
+bool isPlaylistContentType(const String& contentType, const String& url) {
+    String type = contentType;
+    type.toLowerCase();
+    String lowerUrl = url;
+    lowerUrl.toLowerCase();
+
+    int query = lowerUrl.indexOf('?');
+    if (query >= 0) {
+        lowerUrl = lowerUrl.substring(0, query);
+    }
+
+    return type.indexOf("mpegurl") >= 0 || lowerUrl.endsWith(".m3u8");
+}
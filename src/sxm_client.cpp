@@ -1,13 +1,26 @@
 #include "sxm_client.h"
 #include "config.h"
+#include "http_body_stream.h"
+#include "inflate_stream.h"
+#include <algorithm>
 
-SXMClient::SXMClient() : sxmServer(DEFAULT_SXM_SERVER) {}
+SXMClient::SXMClient()
+    : poolLock(nullptr), workQueue(nullptr), doneQueue(nullptr), nextRequestId(1), refreshRequest(0),
+      sxmServer(DEFAULT_SXM_SERVER), channelListModified(false), lastUrlRefresh(0) {
+    conn.http.setReuse(true);
+}
 
 SXMClient::~SXMClient() {
     logout();
 }
 
 void SXMClient::setSXMServer(const String& serverUrl) {
+    if (serverUrl != sxmServer) {
+        streamUrlCache.clear();
+        channelListETag = "";
+        channelListLastModified = "";
+        cancelAll();
+    }
     sxmServer = serverUrl;
     Serial.printf("SXM: Server set to %s\n", sxmServer.c_str());
 }
@@ -17,49 +30,10 @@ String SXMClient::getSXMServer() {
 }
 
 bool SXMClient::login(const String& email, const String& password) {
-    Serial.println("SXM: Attempting login...");
-    
-#if USE_SXM_SERVER
-    // Use m3u8XM server mode
-    Serial.println("SXM: Using server mode");
-    return loginToServer(email, password);
-#else
-    // Direct API mode (not fully implemented)
-    Serial.println("SXM: Using direct API mode (placeholder)");
-    
-    HTTPClient http;
-    http.begin(SXM_LOGIN_URL);
-    http.addHeader("Content-Type", "application/json");
-    
-    StaticJsonDocument<512> doc;
-    doc["email"] = email;
-    doc["password"] = password;
-    
-    String payload;
-    serializeJson(doc, payload);
-    
-    int httpCode = http.POST(payload);
-    
-    if (httpCode == HTTP_CODE_OK) {
-        String response = http.getString();
-        DynamicJsonDocument responseDoc(2048);
-        DeserializationError error = deserializeJson(responseDoc, response);
-        
-        if (!error) {
-            if (responseDoc.containsKey("token")) {
-                authToken = responseDoc["token"].as<String>();
-                Serial.println("SXM: Login successful");
-                http.end();
-                return true;
-            }
-        }
-    }
-    
-    lastError = "Login failed: HTTP " + String(httpCode);
-    Serial.println(lastError);
-    http.end();
-    return false;
-#endif
+    Request request;
+    prepareLogin(request, email, password);
+    perform(conn, request);
+    return apply(request);
 }
 
 bool SXMClient::isAuthenticated() {
@@ -70,251 +44,720 @@ void SXMClient::logout() {
     authToken = "";
     sessionId = "";
     channels.clear();
+    channelListETag = "";
+    channelListLastModified = "";
+    streamUrlCache.clear();
+    
+    // Nothing started before the logout may land after it
+    cancelAll();
 }
 
 bool SXMClient::fetchChannelList() {
-    if (!isAuthenticated()) {
-        lastError = "Not authenticated";
-        return false;
-    }
-    
-    Serial.println("SXM: Fetching channel list...");
-    
-#if USE_SXM_SERVER
-    return fetchChannelListFromServer();
-#else
-    // Placeholder implementation with mock channels
-    channels.clear();
-    
-    // Example channels (these would come from API)
-    const char* channelData[][4] = {
-        {"1", "Hits 1", "Pop", "https://example.com/ch1"},
-        {"2", "The Highway", "Country", "https://example.com/ch2"},
-        {"3", "Octane", "Rock", "https://example.com/ch3"},
-        {"4", "BPM", "Dance", "https://example.com/ch4"},
-        {"5", "Hip-Hop Nation", "Hip-Hop", "https://example.com/ch5"},
-        {"6", "The Pulse", "Pop", "https://example.com/ch6"},
-        {"7", "Classic Vinyl", "Classic Rock", "https://example.com/ch7"},
-        {"8", "Soul Town", "Soul", "https://example.com/ch8"},
-        {"9", "The Coffee House", "Singer-Songwriter", "https://example.com/ch9"},
-        {"10", "Watercolors", "Jazz", "https://example.com/ch10"}
-    };
-    
-    for (int i = 0; i < 10; i++) {
-        SXMChannel ch;
-        ch.number = channelData[i][0];
-        ch.name = channelData[i][1];
-        ch.genre = channelData[i][2];
-        ch.streamUrl = channelData[i][3];
-        ch.id = String(i + 1);
-        channels.push_back(ch);
-    }
-    
-    Serial.printf("SXM: Loaded %d channels\n", channels.size());
-    return true;
-#endif
+    Request request;
+    prepareChannelList(request);
+    perform(conn, request);
+    return apply(request);
 }
 
-std::vector<SXMChannel> SXMClient::getChannels() {
+const ChannelStore& SXMClient::getChannels() {
     return channels;
 }
 
-SXMChannel* SXMClient::getChannelById(const String& id) {
-    for (auto& ch : channels) {
-        if (ch.id == id) {
-            return &ch;
-        }
+void SXMClient::setCachedChannelList(ChannelStore& cached, const String& etag, const String& lastModified) {
+    channels.swap(cached);
+    cached.clear();
+    channelListETag = etag;
+    channelListLastModified = lastModified;
+}
+
+bool SXMClient::wasChannelListModified() {
+    return channelListModified;
+}
+
+String SXMClient::getChannelListETag() {
+    return channelListETag;
+}
+
+String SXMClient::getChannelListLastModified() {
+    return channelListLastModified;
+}
+
+ChannelStore::Channel SXMClient::getChannelById(const String& id) {
+    return channels.findById(id.c_str());
+}
+
+ChannelStore::Channel SXMClient::getChannelByNumber(uint16_t number) {
+    return channels.findByNumber(number);
+}
+
+String SXMClient::getStreamUrl(const String& channelId) {
+    Request request;
+    prepareStreamUrl(request, channelId);
+    perform(conn, request);
+    return apply(request) ? request.result : "";
+}
+
+void SXMClient::invalidateStreamUrl(const String& channelId) {
+    if (streamUrlCache.erase(channelId) > 0) {
+        Serial.printf("SXM: Dropped cached stream URL for %s\n", channelId.c_str());
     }
-    return nullptr;
 }
 
-SXMChannel* SXMClient::getChannelByNumber(const String& number) {
-    for (auto& ch : channels) {
-        if (ch.number == number) {
-            return &ch;
+uint32_t SXMClient::loginAsync(const String& email, const String& password, const Completion& done) {
+    Request* request = new Request();
+    prepareLogin(*request, email, password);
+    return submit(request, done);
+}
+
+uint32_t SXMClient::fetchChannelListAsync(const Completion& done) {
+    Request* request = new Request();
+    prepareChannelList(*request);
+    return submit(request, done);
+}
+
+uint32_t SXMClient::getStreamUrlAsync(const String& channelId, const Completion& done) {
+    Request* request = new Request();
+    prepareStreamUrl(*request, channelId);
+    return submit(request, done);
+}
+
+void SXMClient::cancel(uint32_t requestId) {
+    if (requestId == 0) {
+        return;
+    }
+
+    // A running request still finishes; only its result is dropped
+    for (Request* request : pending) {
+        if (request->id == requestId) {
+            request->cancelled = true;
+        }
+    }
+    for (Request* request : completed) {
+        if (request->id == requestId) {
+            request->cancelled = true;
         }
     }
-    return nullptr;
 }
 
-String SXMClient::getStreamUrl(const String& channelId) {
+void SXMClient::cancelAll() {
+    // Queued requests are skipped by the workers; running ones finish on
+    // their connection, which the pool closes when it is handed back
+    for (Request* request : pending) {
+        request->cancelled = true;
+    }
+    for (Request* request : completed) {
+        request->cancelled = true;
+    }
+    refreshRequest = 0;
+    
+    lockPool();
+    pool.closeAll();
+    unlockPool();
+}
+
+size_t SXMClient::getPendingRequests() {
+    return pending.size() + completed.size();
+}
+
+void SXMClient::loop() {
+    // Completions run here, on the caller's task, so they may touch client
+    // state and the UI. Requests they submit are delivered on a later call.
+    std::vector<Request*> finished;
+    finished.swap(completed);
+    Request* received;
+    while (doneQueue && xQueueReceive(doneQueue, &received, 0) == pdTRUE) {
+        pending.erase(std::remove(pending.begin(), pending.end(), received), pending.end());
+        finished.push_back(received);
+    }
+    for (Request* request : finished) {
+        if (!request->cancelled) {
+            bool ok = apply(*request);
+            if (request->done) {
+                request->done(ok, ok ? request->result : lastError);
+            }
+        }
+        delete request;
+    }
+
+    lockPool();
+    pool.closeIdle();
+    unlockPool();
+
 #if USE_SXM_SERVER
-    // Get stream URL from server
-    return getStreamUrlFromServer(channelId);
-#else
-    // Use cached stream URL from channel
-    SXMChannel* ch = getChannelById(channelId);
-    if (ch) {
-        return ch->streamUrl;
+    if (refreshRequest != 0 || streamUrlCache.empty() || millis() - lastUrlRefresh < SXM_STREAM_URL_REFRESH_MS) {
+        return;
     }
-    return "";
+
+    // Refresh the most recently used entry that is close to expiring
+    String channelId;
+    uint32_t newestUse = 0;
+    for (auto& entry : streamUrlCache) {
+        uint32_t age = millis() - entry.second.fetchedAt;
+        bool stale = age >= entry.second.ttlMs / 100 * SXM_STREAM_URL_REFRESH_PCT;
+        if (stale && (channelId.length() == 0 || entry.second.lastUsed > newestUse)) {
+            channelId = entry.first;
+            newestUse = entry.second.lastUsed;
+        }
+    }
+    if (channelId.length() == 0) {
+        return;
+    }
+
+    lastUrlRefresh = millis();
+    Request* refresh = new Request();
+    refresh->refresh = true;
+    prepareStreamUrl(*refresh, channelId);
+    refreshRequest = submit(refresh, [this, channelId](bool ok, const String& result) {
+        refreshRequest = 0;
+        if (ok) {
+            Serial.printf("SXM: Refreshed stream URL for %s\n", channelId.c_str());
+        }
+    });
 #endif
 }
 
+void SXMClient::cacheStreamUrl(const String& channelId, const String& url, uint32_t ttlMs) {
+    if (streamUrlCache.find(channelId) == streamUrlCache.end() &&
+        streamUrlCache.size() >= SXM_STREAM_URL_CACHE_MAX) {
+        // Evict the least recently used entry
+        auto oldest = streamUrlCache.begin();
+        for (auto it = streamUrlCache.begin(); it != streamUrlCache.end(); ++it) {
+            if (it->second.lastUsed < oldest->second.lastUsed) {
+                oldest = it;
+            }
+        }
+        streamUrlCache.erase(oldest);
+    }
+
+    StreamUrlEntry& entry = streamUrlCache[channelId];
+    entry.url = url;
+    entry.fetchedAt = millis();
+    entry.ttlMs = ttlMs;
+    entry.lastUsed = millis();
+}
+
 String SXMClient::getLastError() {
     return lastError;
 }
 
-bool SXMClient::makeRequest(const String& url, const String& method, const String& payload, String& response) {
-    HTTPClient http;
-    http.begin(url);
+uint32_t SXMClient::getConnectionsOpened() {
+    return pool.getConnectionsOpened();
+}
+
+uint32_t SXMClient::getRequestCount() {
+    return pool.getRequestCount();
+}
+
+bool SXMClient::beginRequest(Connection& connection, const String& url, String& error) {
+    // Requests to the same host share keep-alive connections
+    lockPool();
+    connection.client = pool.acquire(url);
+    unlockPool();
+    if (!connection.client) {
+        error = "No connection for " + url;
+        Serial.println("SXM: " + error);
+        return false;
+    }
+    if (!connection.http.begin(*connection.client, url)) {
+        endRequest(connection);
+        error = "Invalid URL: " + url;
+        Serial.println("SXM: " + error);
+        return false;
+    }
+    return true;
+}
+
+void SXMClient::endRequest(Connection& connection) {
+    connection.http.end();
+    if (connection.client) {
+        lockPool();
+        pool.release(connection.client);
+        unlockPool();
+        connection.client = nullptr;
+    }
+}
+
+void SXMClient::lockPool() {
+    // Only needed once worker tasks share the pool
+    if (poolLock) {
+        xSemaphoreTake(poolLock, portMAX_DELAY);
+    }
+}
+
+void SXMClient::unlockPool() {
+    if (poolLock) {
+        xSemaphoreGive(poolLock);
+    }
+}
+
+void SXMClient::prepareLogin(Request& request, const String& email, const String& password) {
+    Serial.println("SXM: Attempting login...");
+    request.type = REQUEST_LOGIN;
+    
+#if USE_SXM_SERVER
+    // Use m3u8XM server mode
+    request.url = "http://" + sxmServer + SXM_SERVER_LOGIN;
     
-    if (authToken.length() > 0) {
-        http.addHeader("Authorization", "Bearer " + authToken);
+    StaticJsonDocument<256> doc;
+    doc["username"] = email;
+    doc["password"] = password;
+#else
+    // Direct API mode (not fully implemented)
+    request.url = SXM_LOGIN_URL;
+    
+    StaticJsonDocument<512> doc;
+    doc["email"] = email;
+    doc["password"] = password;
+#endif
+    
+    serializeJson(doc, request.payload);
+}
+
+void SXMClient::prepareChannelList(Request& request) {
+    request.type = REQUEST_CHANNELS;
+    if (!isAuthenticated()) {
+        request.error = "Not authenticated";
+        request.ready = true;
+        return;
     }
     
-    int httpCode = -1;
+    Serial.println("SXM: Fetching channel list...");
+    request.url = "http://" + sxmServer + SXM_SERVER_CHANNELS;
+    request.authToken = authToken;
+    
+    // Validators only make sense while there is a list to fall back on
+    request.conditional = !channels.empty();
+    request.etag = channelListETag;
+    request.lastModified = channelListLastModified;
+}
+
+void SXMClient::prepareStreamUrl(Request& request, const String& channelId) {
+    request.type = REQUEST_STREAM_URL;
+    request.channelId = channelId;
     
-    if (method == "GET") {
-        httpCode = http.GET();
-    } else if (method == "POST") {
-        http.addHeader("Content-Type", "application/json");
-        httpCode = http.POST(payload);
+#if USE_SXM_SERVER
+    // A fresh cached URL needs no round-trip to the server
+    auto it = streamUrlCache.find(channelId);
+    if (!request.refresh && it != streamUrlCache.end() && millis() - it->second.fetchedAt < it->second.ttlMs) {
+        it->second.lastUsed = millis();
+        request.result = it->second.url;
+        request.ok = true;
+        request.ready = true;
+        return;
     }
     
-    if (httpCode == HTTP_CODE_OK) {
-        response = http.getString();
-        http.end();
-        return true;
+    request.url = "http://" + sxmServer + SXM_SERVER_STREAM + "/" + channelId;
+    request.authToken = authToken;
+    request.ttlMs = SXM_STREAM_URL_TTL_MS;
+#else
+    // Use cached stream URL from channel
+    ChannelStore::Channel ch = getChannelById(channelId);
+    if (ch) {
+        request.result = ch.streamUrl();
+        request.ok = true;
+    } else {
+        request.error = "Unknown channel " + channelId;
+    }
+    request.ready = true;
+#endif
+}
+
+void SXMClient::perform(Connection& connection, Request& request) {
+    if (request.ready) {
+        return;
     }
     
-    lastError = "Request failed: HTTP " + String(httpCode);
-    http.end();
-    return false;
+    switch (request.type) {
+        case REQUEST_LOGIN:
+            performLogin(connection, request);
+            break;
+        case REQUEST_CHANNELS:
+            performChannelList(connection, request);
+            break;
+        case REQUEST_STREAM_URL:
+            performStreamUrl(connection, request);
+            break;
+    }
 }
 
-bool SXMClient::parseChannelList(const String& jsonResponse) {
-    DynamicJsonDocument doc(8192);
-    DeserializationError error = deserializeJson(doc, jsonResponse);
+bool SXMClient::apply(Request& request) {
+    if (request.type == REQUEST_CHANNELS) {
+        channelListModified = false;
+        if (request.notModified && channels.empty()) {
+            // Logged out while the request was in flight
+            request.ok = false;
+            request.error = "Channel list not modified, but none cached";
+        }
+    }
     
-    if (error) {
-        lastError = "JSON parse error";
+    if (!request.ok) {
+        lastError = request.error;
         return false;
     }
     
-    // Parse channel list from JSON
-    // This depends on actual API response format
-    
+    switch (request.type) {
+        case REQUEST_LOGIN:
+            authToken = request.authToken;
+            Serial.println("SXM: Login successful");
+            break;
+            
+        case REQUEST_CHANNELS:
+            if (request.notModified) {
+                Serial.println("SXM: Channel list not modified");
+                break;
+            }
+            // The request and the old store it holds are freed after this,
+            // and the search index points into whichever store is kept
+            channelListModified = channels.replace(request.channels);
+            channelListETag = request.etag;
+            channelListLastModified = request.lastModified;
+            Serial.printf("SXM: Channel store uses %u bytes, %u genres\n",
+                          channels.getMemoryUsage(), channels.getGenreCount());
+            break;
+            
+        case REQUEST_STREAM_URL:
+            if (!request.ready) {
+                // A background refresh keeps the entry's place in the LRU order
+                auto it = streamUrlCache.find(request.channelId);
+                uint32_t lastUsed = request.refresh && it != streamUrlCache.end() ? it->second.lastUsed : millis();
+                cacheStreamUrl(request.channelId, request.result, request.ttlMs);
+                streamUrlCache[request.channelId].lastUsed = lastUsed;
+            }
+            break;
+    }
     return true;
 }
 
-// Server mode implementations
-bool SXMClient::loginToServer(const String& email, const String& password) {
-    HTTPClient http;
-    String url = "http://" + sxmServer + SXM_SERVER_LOGIN;
+uint32_t SXMClient::submit(Request* request, const Completion& done) {
+    request->id = nextRequestId++;
+    request->done = done;
     
-    Serial.printf("SXM: Connecting to server at %s\n", url.c_str());
+    if (request->ready) {
+        completed.push_back(request);
+        return request->id;
+    }
     
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
+    if (!startWorkers() || xQueueSend(workQueue, &request, 0) != pdTRUE) {
+        lastError = "Request queue full";
+        Serial.println("SXM: " + lastError);
+        delete request;
+        return 0;
+    }
+    pending.push_back(request);
+    return request->id;
+}
+
+bool SXMClient::startWorkers() {
+    if (workQueue) {
+        return true;
+    }
     
-    StaticJsonDocument<256> doc;
-    doc["username"] = email;
-    doc["password"] = password;
+    SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+    QueueHandle_t work = xQueueCreate(SXM_ASYNC_QUEUE, sizeof(Request*));
+    QueueHandle_t done = xQueueCreate(SXM_ASYNC_QUEUE + SXM_ASYNC_WORKERS, sizeof(Request*));
+    if (!lock || !work || !done) {
+        Serial.println("SXM: Failed to create request queues");
+        if (lock) {
+            vSemaphoreDelete(lock);
+        }
+        if (work) {
+            vQueueDelete(work);
+        }
+        if (done) {
+            vQueueDelete(done);
+        }
+        return false;
+    }
+    poolLock = lock;
+    workQueue = work;
+    doneQueue = done;
+    
+    // Each worker owns an HTTPClient, so requests to different channels
+    // (or a fetch and a zap) are in flight together
+    for (int i = 0; i < SXM_ASYNC_WORKERS; i++) {
+        xTaskCreatePinnedToCore(workerTaskEntry, "sxm_req", SXM_TASK_STACK, this,
+                                SXM_TASK_PRIORITY, nullptr, SXM_TASK_CORE);
+    }
+    Serial.printf("SXM: Started %d request workers\n", SXM_ASYNC_WORKERS);
+    return true;
+}
+
+void SXMClient::workerTaskEntry(void* param) {
+    static_cast<SXMClient*>(param)->workerTask();
+}
+
+void SXMClient::workerTask() {
+    Connection connection;
+    connection.http.setReuse(true);
+    
+    Request* request;
+    while (true) {
+        if (xQueueReceive(workQueue, &request, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        // Cancelled while it waited: skip the round-trip
+        if (!request->cancelled) {
+            perform(connection, *request);
+        }
+        xQueueSend(doneQueue, &request, portMAX_DELAY);
+    }
+}
+
+void SXMClient::performLogin(Connection& connection, Request& request) {
+#if USE_SXM_SERVER
+    Serial.printf("SXM: Connecting to server at %s\n", request.url.c_str());
+#else
+    Serial.println("SXM: Using direct API mode (placeholder)");
+#endif
     
-    String payload;
-    serializeJson(doc, payload);
+    if (!beginRequest(connection, request.url, request.error)) {
+        return;
+    }
+    connection.http.addHeader("Content-Type", "application/json");
     
-    int httpCode = http.POST(payload);
+    int httpCode = connection.http.POST(request.payload);
     
     if (httpCode == HTTP_CODE_OK) {
-        String response = http.getString();
+        String response = connection.http.getString();
         
-        DynamicJsonDocument responseDoc(1024);
+        DynamicJsonDocument responseDoc(2048);
         DeserializationError error = deserializeJson(responseDoc, response);
         
-        if (!error && responseDoc.containsKey("success")) {
-            if (responseDoc["success"].as<bool>()) {
-                authToken = "server_authenticated";  // Token from server if provided
-                Serial.println("SXM: Server login successful");
-                http.end();
-                return true;
-            }
+#if USE_SXM_SERVER
+        if (!error && responseDoc.containsKey("success") && responseDoc["success"].as<bool>()) {
+            request.authToken = "server_authenticated";  // Token from server if provided
+            request.ok = true;
         }
+#else
+        if (!error && responseDoc.containsKey("token")) {
+            request.authToken = responseDoc["token"].as<String>();
+            request.ok = true;
+        }
+#endif
     }
     
-    lastError = "Server login failed: HTTP " + String(httpCode);
-    Serial.println(lastError);
-    http.end();
-    return false;
+    if (!request.ok) {
+        request.error = (USE_SXM_SERVER ? "Server login failed: HTTP " : "Login failed: HTTP ") + String(httpCode);
+        Serial.println(request.error);
+    }
+    endRequest(connection);
 }
 
-bool SXMClient::fetchChannelListFromServer() {
-    HTTPClient http;
-    String url = "http://" + sxmServer + SXM_SERVER_CHANNELS;
+void SXMClient::performChannelList(Connection& connection, Request& request) {
+#if USE_SXM_SERVER
+    Serial.printf("SXM: Fetching channels from %s\n", request.url.c_str());
     
-    Serial.printf("SXM: Fetching channels from %s\n", url.c_str());
+    if (!beginRequest(connection, request.url, request.error)) {
+        return;
+    }
+    HTTPClient& http = connection.http;
+    http.addHeader("Authorization", "Bearer " + request.authToken);
+    http.addHeader("Accept-Encoding", "gzip, deflate");
     
-    http.begin(url);
-    http.addHeader("Authorization", "Bearer " + authToken);
+    if (request.conditional) {
+        if (request.etag.length() > 0) {
+            http.addHeader("If-None-Match", request.etag);
+        }
+        if (request.lastModified.length() > 0) {
+            http.addHeader("If-Modified-Since", request.lastModified);
+        }
+    }
+
+    const char* headerKeys[] = {"Transfer-Encoding", "Content-Encoding", "ETag", "Last-Modified"};
+    http.collectHeaders(headerKeys, 4);
     
     int httpCode = http.GET();
     
+    if (httpCode == HTTP_CODE_NOT_MODIFIED && request.conditional) {
+        request.notModified = true;
+        request.ok = true;
+        endRequest(connection);
+        return;
+    }
+    
     if (httpCode == HTTP_CODE_OK) {
-        String response = http.getString();
-        
-        DynamicJsonDocument doc(16384);
-        DeserializationError error = deserializeJson(doc, response);
+        // Parse straight off the connection; the body is never held in RAM
+        HttpBodyStream body;
+        body.setTimeout(HTTP_TIMEOUT_MS);
+        body.begin(http.getStreamPtr(), http.getSize(),
+                   http.header("Transfer-Encoding").equalsIgnoreCase("chunked"));
+
+        // Compressed bodies are inflated on the fly in front of the parser
+        String encoding = http.header("Content-Encoding");
+        encoding.toLowerCase();
+        InflateStream inflater;
+        Stream* input = &body;
+        if (encoding == "gzip" || encoding == "x-gzip" || encoding == "deflate") {
+            inflater.setTimeout(HTTP_TIMEOUT_MS);
+            if (!inflater.begin(body, encoding == "deflate" ? InflateStream::DEFLATE : InflateStream::GZIP)) {
+                request.error = "Cannot decode " + encoding + " channel list";
+                Serial.println(request.error);
+                endRequest(connection);
+                return;
+            }
+            input = &inflater;
+        }
+
+        ChannelStore& loaded = request.channels;
+        bool stored = true;
+        int count = parseChannelStream(*input, [&loaded, &stored](const SXMChannel& channel) {
+            stored = loaded.add(channel) && stored;
+        }, request.error);
+        if (count >= 0 && !stored) {
+            request.error = "Out of memory for channel list";
+            count = -1;
+        }
         
-        if (!error) {
-            channels.clear();
-            
-            JsonArray channelArray = doc["channels"].as<JsonArray>();
+        if (count >= 0) {
+            loaded.shrinkToFit();
+            body.drain();
+            request.etag = http.header("ETag");
+            request.lastModified = http.header("Last-Modified");
+            request.ok = true;
             
-            for (JsonObject channelObj : channelArray) {
-                SXMChannel channel;
-                channel.id = channelObj["id"].as<String>();
-                channel.name = channelObj["name"].as<String>();
-                channel.number = channelObj["number"] | channelObj["channelNumber"].as<String>();
-                channel.genre = channelObj["genre"].as<String>();
-                channel.logoUrl = channelObj["logoUrl"] | channelObj["logo"].as<String>();
-                // Stream URL will be fetched on demand
-                
-                channels.push_back(channel);
+            if (input == &inflater) {
+                Serial.printf("SXM: Loaded %d channels from server (%u bytes, %u inflated)\n",
+                              count, body.getBytesRead(), inflater.getBytesOut());
+            } else {
+                Serial.printf("SXM: Loaded %d channels from server (%u bytes)\n", count, body.getBytesRead());
             }
-            
-            Serial.printf("SXM: Loaded %d channels from server\n", channels.size());
-            http.end();
-            return true;
+            endRequest(connection);
+            return;
         }
         
-        lastError = "Failed to parse channel list from server";
-        Serial.println(lastError);
+        Serial.println(request.error);
     } else {
-        lastError = "Failed to fetch channels: HTTP " + String(httpCode);
-        Serial.println(lastError);
+        request.error = "Failed to fetch channels: HTTP " + String(httpCode);
+        Serial.println(request.error);
     }
     
-    http.end();
-    return false;
+    endRequest(connection);
+#else
+    // Placeholder implementation with mock channels
+    
+    // Example channels (these would come from API)
+    const char* channelData[][4] = {
+        {"1", "Hits 1", "Pop", "https://example.com/ch1"},
+        {"2", "The Highway", "Country", "https://example.com/ch2"},
+        {"3", "Octane", "Rock", "https://example.com/ch3"},
+        {"4", "BPM", "Dance", "https://example.com/ch4"},
+        {"5", "Hip-Hop Nation", "Hip-Hop", "https://example.com/ch5"},
+        {"6", "The Pulse", "Pop", "https://example.com/ch6"},
+        {"7", "Classic Vinyl", "Classic Rock", "https://example.com/ch7"},
+        {"8", "Soul Town", "Soul", "https://example.com/ch8"},
+        {"9", "The Coffee House", "Singer-Songwriter", "https://example.com/ch9"},
+        {"10", "Watercolors", "Jazz", "https://example.com/ch10"}
+    };
+    
+    for (int i = 0; i < 10; i++) {
+        SXMChannel ch;
+        ch.number = channelData[i][0];
+        ch.name = channelData[i][1];
+        ch.genre = channelData[i][2];
+        ch.streamUrl = channelData[i][3];
+        ch.id = String(i + 1);
+        request.channels.add(ch);
+    }
+    
+    Serial.printf("SXM: Loaded %d channels\n", request.channels.size());
+    request.ok = true;
+#endif
 }
 
-String SXMClient::getStreamUrlFromServer(const String& channelId) {
-    HTTPClient http;
-    String url = "http://" + sxmServer + SXM_SERVER_STREAM + "/" + channelId;
-    
-    Serial.printf("SXM: Getting stream URL from %s\n", url.c_str());
+int SXMClient::parseChannelStream(Stream& body, const ChannelCallback& onChannel, String& error) {
+    if (!body.find("\"channels\"") || !body.find("[")) {
+        error = "Failed to parse channel list from server";
+        return -1;
+    }
+
+    // Only these fields are copied out of each channel object
+    StaticJsonDocument<128> filter;
+    for (const char* key : {"id", "name", "number", "channelNumber", "genre", "logoUrl", "logo"}) {
+        filter[key] = true;
+    }
+
+    // One channel at a time, so peak memory does not grow with the line-up
+    StaticJsonDocument<SXM_CHANNEL_JSON_SIZE> doc;
+    int count = 0;
+
+    while (true) {
+        int c = nextToken(body);
+        if (c < 0) {
+            error = "Channel list truncated after " + String(count) + " channels";
+            return -1;
+        }
+        if (c == ']') {
+            body.read();
+            return count;
+        }
+
+        DeserializationError result = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+        if (result) {
+            error = "Channel " + String(count) + " parse error: " + result.c_str();
+            return -1;
+        }
+
+        JsonObject channelObj = doc.as<JsonObject>();
+        SXMChannel channel;
+        channel.id = channelObj["id"].as<String>();
+        channel.name = channelObj["name"].as<String>();
+        channel.number = channelObj["number"] | channelObj["channelNumber"].as<String>();
+        channel.genre = channelObj["genre"].as<String>();
+        channel.logoUrl = channelObj["logoUrl"] | channelObj["logo"].as<String>();
+        // Stream URL will be fetched on demand
+
+        onChannel(channel);
+        count++;
+    }
+}
+
+int SXMClient::nextToken(Stream& body) {
+    // Next byte that is not whitespace or an element separator, left unread
+    uint32_t start = millis();
+    while (millis() - start < HTTP_TIMEOUT_MS) {
+        int c = body.peek();
+        if (c < 0) {
+            delay(1);
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',') {
+            body.read();
+        } else {
+            return c;
+        }
+    }
+    return -1;
+}
+
+void SXMClient::performStreamUrl(Connection& connection, Request& request) {
+    Serial.printf("SXM: Getting stream URL from %s\n", request.url.c_str());
     
-    http.begin(url);
-    http.addHeader("Authorization", "Bearer " + authToken);
+    if (!beginRequest(connection, request.url, request.error)) {
+        return;
+    }
+    connection.http.addHeader("Authorization", "Bearer " + request.authToken);
     
-    int httpCode = http.GET();
+    int httpCode = connection.http.GET();
     
     if (httpCode == HTTP_CODE_OK) {
-        String response = http.getString();
+        String response = connection.http.getString();
         
         StaticJsonDocument<512> doc;
         DeserializationError error = deserializeJson(doc, response);
         
         if (!error && doc.containsKey("streamUrl")) {
-            String streamUrl = doc["streamUrl"].as<String>();
-            http.end();
-            return streamUrl;
+            request.result = doc["streamUrl"].as<String>();
+
+            // Honour the server's expiry (seconds) when it gives one
+            uint32_t expiresIn = doc["expiresIn"] | doc["ttl"].as<uint32_t>();
+            if (expiresIn > 0) {
+                request.ttlMs = expiresIn * 1000UL;
+            }
+            request.ok = true;
+            endRequest(connection);
+            return;
         }
     }
     
-    lastError = "Failed to get stream URL: HTTP " + String(httpCode);
-    Serial.println(lastError);
-    http.end();
-    return "";
+    request.error = "Failed to get stream URL: HTTP " + String(httpCode);
+    Serial.println(request.error);
+    endRequest(connection);
 }
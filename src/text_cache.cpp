@@ -0,0 +1,206 @@
+#include "text_cache.h"
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+
+namespace {
+
+const char* const FONT_PATHS[] = {UI_FONT_SMALL_PATH, UI_FONT_MEDIUM_PATH, UI_FONT_LARGE_PATH};
+
+}  // namespace
+
+TextCache::TextCache()
+    : renderers{nullptr, nullptr, nullptr}, fonts{nullptr, nullptr, nullptr}, ready(false), stats{0, 0, 0, 0, 0, 0} {}
+
+TextCache::~TextCache() {
+    clear();
+    for (uint8_t i = 0; i < SIZES; i++) {
+        if (renderers[i]) {
+            if (fonts[i]) {
+                renderers[i]->unloadFont();
+            }
+            renderers[i]->deleteSprite();
+            delete renderers[i];
+        }
+        free(fonts[i]);
+    }
+}
+
+void TextCache::begin(TFT_eSPI* display) {
+    if (!psramFound()) {
+        Serial.println("UI: No PSRAM, text drawn directly");
+        return;
+    }
+
+    // Not formatted here: the catalog mounts (and formats) it for real
+    bool mounted = LittleFS.begin(false);
+
+    for (uint8_t i = 0; i < SIZES; i++) {
+        renderers[i] = new TFT_eSprite(display);
+        renderers[i]->setAttribute(PSRAM_ENABLE, true);
+        renderers[i]->setColorDepth(16);
+        if (!renderers[i]->createSprite(SCREEN_WIDTH, UI_TEXT_MAX_HEIGHT)) {
+            Serial.println("UI: No memory for the text cache, text drawn directly");
+            return;
+        }
+        if (!mounted || !loadFont(i, FONT_PATHS[i])) {
+            renderers[i]->setTextFont(1);
+            renderers[i]->setTextSize(i + 1);
+        }
+        renderers[i]->setTextWrap(false, false);
+    }
+    ready = true;
+
+    Serial.printf("UI: Text cache %u KB, smooth fonts %s/%s/%s\n", UI_TEXT_CACHE_BYTES / 1024,
+                  fonts[0] ? "yes" : "no", fonts[1] ? "yes" : "no", fonts[2] ? "yes" : "no");
+}
+
+void TextCache::draw(TFT_eSPI* target, TFT_eSprite* sprite, const String& text, int16_t x, int16_t y, uint8_t size,
+                     uint8_t datum, uint16_t fg, uint16_t bg) {
+    size = constrain(size, 1, SIZES);
+    uint32_t start = micros();
+    uint32_t misses = stats.misses;
+    const Entry* entry = ready ? get(text, size, fg, bg) : nullptr;
+    if (!entry) {
+        // No cache, or no memory for this string: straight to the target
+        target->setTextColor(fg);
+        target->setTextSize(size);
+        target->setTextDatum(datum);
+        target->drawString(text, x, y);
+        return;
+    }
+
+    // Datums run left/center/right along, then top/middle/bottom down;
+    // the baseline ones are taken as bottom
+    uint8_t across = datum % 3;
+    uint8_t down = min(datum / 3, 2);
+    int16_t left = x - (across == 1 ? entry->w / 2 : (across == 2 ? entry->w : 0));
+    int16_t top = y - (down == 1 ? entry->h / 2 : (down == 2 ? entry->h : 0));
+
+    if (sprite) {
+        sprite->pushImage(left, top, entry->w, entry->h, entry->pixels);
+    } else {
+        target->pushImage(left, top, entry->w, entry->h, entry->pixels);
+    }
+    if (stats.misses == misses) {
+        stats.hitUs += micros() - start;
+    }
+}
+
+bool TextCache::hasSmoothFont(uint8_t size) {
+    return size >= 1 && size <= SIZES && fonts[size - 1];
+}
+
+TextCache::Stats TextCache::getStats() {
+    return stats;
+}
+
+void TextCache::clear() {
+    for (auto& entry : entries) {
+        free(entry.pixels);
+    }
+    entries.clear();
+    index.clear();
+    stats.bytes = 0;
+}
+
+const TextCache::Entry* TextCache::get(const String& text, uint8_t size, uint16_t fg, uint16_t bg) {
+    uint32_t key = keyFor(text, size, fg, bg);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        auto it = found->second;
+        if (it->size == size && it->fg == fg && it->bg == bg && it->text == text) {
+            entries.splice(entries.begin(), entries, it);
+            stats.hits++;
+            return &*it;
+        }
+        evict(it);  // Hash collision: the newer string takes the slot
+    }
+
+    stats.misses++;
+    return render(key, text, size, fg, bg);
+}
+
+const TextCache::Entry* TextCache::render(uint32_t key, const String& text, uint8_t size, uint16_t fg, uint16_t bg) {
+    uint32_t start = micros();
+    TFT_eSprite* renderer = renderers[size - 1];
+    int16_t w = min((int16_t)renderer->textWidth(text), (int16_t)renderer->width());
+    int16_t h = min((int16_t)renderer->fontHeight(), (int16_t)renderer->height());
+    if (w <= 0 || h <= 0) {
+        return nullptr;
+    }
+
+    uint32_t bytes = w * h * sizeof(uint16_t);
+    while (!entries.empty() && stats.bytes + bytes > UI_TEXT_CACHE_BYTES) {
+        evict(std::prev(entries.end()));
+        stats.evictions++;
+    }
+    uint16_t* pixels = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (!pixels) {
+        return nullptr;
+    }
+
+    // Anti-aliased edges are blended into bg as they are drawn
+    renderer->fillRect(0, 0, w, h, bg);
+    renderer->setTextColor(fg, bg);
+    renderer->setTextDatum(TL_DATUM);
+    renderer->drawString(text, 0, 0);
+
+    // Same byte order as any sprite, ready for pushImage
+    const uint16_t* src = (const uint16_t*)renderer->getPointer();
+    for (int16_t line = 0; line < h; line++) {
+        memcpy(pixels + line * w, src + line * renderer->width(), w * sizeof(uint16_t));
+    }
+
+    entries.push_front({key, text, size, fg, bg, w, h, pixels});
+    index[key] = entries.begin();
+    stats.bytes += bytes;
+    stats.renderUs += micros() - start;
+    return &entries.front();
+}
+
+void TextCache::evict(std::list<Entry>::iterator it) {
+    stats.bytes -= it->w * it->h * sizeof(uint16_t);
+    free(it->pixels);
+    index.erase(it->key);
+    entries.erase(it);
+}
+
+bool TextCache::loadFont(uint8_t slot, const char* path) {
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    // The whole file: glyph metrics and bitmaps, read from memory from now on
+    size_t size = file.size();
+    uint8_t* data = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    bool ok = data && file.read(data, size) == size;
+    file.close();
+    if (!ok) {
+        free(data);
+        Serial.printf("UI: Could not load font %s\n", path);
+        return false;
+    }
+
+    fonts[slot] = data;
+    renderers[slot]->loadFont(data);
+    return true;
+}
+
+uint32_t TextCache::keyFor(const String& text, uint8_t size, uint16_t fg, uint16_t bg) {
+    // FNV-1a over the text, then the size and colors
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < text.length(); i++) {
+        hash ^= (uint8_t)text[i];
+        hash *= 16777619u;
+    }
+    uint8_t tail[] = {size, (uint8_t)fg, (uint8_t)(fg >> 8), (uint8_t)bg, (uint8_t)(bg >> 8)};
+    for (uint8_t b : tail) {
+        hash ^= b;
+        hash *= 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,290 @@
+#include "tls_session.h"
+
+#if TLS_SESSION_RESUME
+
+#include "config.h"
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/net_sockets.h>
+
+TlsSessionCache tlsSessionCache;
+
+TlsSessionCache::TlsSessionCache() : stats{0, 0, 0, 0}, lock(xSemaphoreCreateMutex()) {}
+
+TlsSessionCache::~TlsSessionCache() {
+    clear();
+    vSemaphoreDelete(lock);
+}
+
+bool TlsSessionCache::restore(const String& key, mbedtls_ssl_context* ssl) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Entry* entry = find(key);
+    bool offered = entry && mbedtls_ssl_set_session(ssl, entry->session) == 0;
+    if (offered) {
+        entry->lastUsed = millis();
+    }
+    xSemaphoreGive(lock);
+    return offered;
+}
+
+void TlsSessionCache::save(const String& key, const mbedtls_ssl_context* ssl) {
+    mbedtls_ssl_session* session = (mbedtls_ssl_session*)malloc(sizeof(mbedtls_ssl_session));
+    if (!session) {
+        return;
+    }
+    mbedtls_ssl_session_init(session);
+    if (mbedtls_ssl_get_session(ssl, session) != 0) {
+        mbedtls_ssl_session_free(session);
+        free(session);
+        return;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Entry* entry = find(key);
+    if (!entry) {
+        if (entries.size() >= TLS_SESSION_CACHE_MAX) {
+            // Replace the least recently used host
+            entry = &entries[0];
+            for (auto& candidate : entries) {
+                if (candidate.lastUsed < entry->lastUsed) {
+                    entry = &candidate;
+                }
+            }
+            release(*entry);
+        } else {
+            entries.push_back(Entry());
+            entry = &entries.back();
+            entry->session = nullptr;
+        }
+        entry->key = key;
+    } else {
+        release(*entry);
+    }
+    entry->session = session;
+    entry->savedAt = millis();
+    entry->lastUsed = millis();
+    xSemaphoreGive(lock);
+}
+
+void TlsSessionCache::forget(const String& key) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->key == key) {
+            release(*it);
+            entries.erase(it);
+            break;
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+bool TlsSessionCache::wasResumed(const String& key, const mbedtls_ssl_context* ssl) {
+    // A resumed session keeps its master secret; a full handshake derives
+    // a new one. This holds for session IDs and tickets alike.
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Entry* entry = find(key);
+    bool resumed = entry && ssl->session &&
+                   memcmp(entry->session->master, ssl->session->master, sizeof(ssl->session->master)) == 0;
+    xSemaphoreGive(lock);
+    return resumed;
+}
+
+void TlsSessionCache::recordHandshake(bool resumed, uint32_t ms) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (resumed) {
+        stats.resumedHandshakes++;
+        stats.resumedMs += ms;
+    } else {
+        stats.fullHandshakes++;
+        stats.fullMs += ms;
+    }
+    xSemaphoreGive(lock);
+}
+
+TlsSessionCache::Stats TlsSessionCache::getStats() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Stats copy = stats;
+    xSemaphoreGive(lock);
+    return copy;
+}
+
+void TlsSessionCache::clear() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto& entry : entries) {
+        release(entry);
+    }
+    entries.clear();
+    xSemaphoreGive(lock);
+}
+
+TlsSessionCache::Entry* TlsSessionCache::find(const String& key) {
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->key != key) {
+            continue;
+        }
+        if (millis() - it->savedAt > TLS_SESSION_TTL_MS) {
+            release(*it);
+            entries.erase(it);
+            return nullptr;
+        }
+        return &*it;
+    }
+    return nullptr;
+}
+
+void TlsSessionCache::release(Entry& entry) {
+    if (entry.session) {
+        mbedtls_ssl_session_free(entry.session);
+        free(entry.session);
+        entry.session = nullptr;
+    }
+}
+
+int TlsResumingClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, _timeout);
+}
+
+int TlsResumingClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    if (!canResume()) {
+        return WiFiClientSecure::connect(host, port, timeout);
+    }
+    if (timeout <= 0) {
+        timeout = HTTP_TIMEOUT_MS;
+    }
+
+    IPAddress address;
+    if (!WiFi.hostByName(host, address)) {
+        return 0;
+    }
+
+    stop();
+    int ret = startSession(address, port, host, timeout);
+    if (ret != 0) {
+        _lastError = ret;
+        Serial.printf("TLS: Connect to %s:%u failed (-0x%04x)\n", host, port, -ret);
+        stop();
+        return 0;
+    }
+    _connected = true;
+    return 1;
+}
+
+bool TlsResumingClient::canResume() {
+    return (_use_insecure || _CA_cert) && !_use_ca_bundle && !_cert && !_private_key &&
+           !_pskIdent && !_psKey && !_alpn_protos;
+}
+
+int TlsResumingClient::startSession(const IPAddress& address, uint16_t port, const char* host, int32_t timeout) {
+    sslclient_context* ctx = sslclient;
+
+    // TCP connect, bounded by the timeout like the core's
+    ctx->socket = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (ctx->socket < 0) {
+        return MBEDTLS_ERR_NET_SOCKET_FAILED;
+    }
+    lwip_fcntl(ctx->socket, F_SETFL, lwip_fcntl(ctx->socket, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in serverAddress = {};
+    serverAddress.sin_family = AF_INET;
+    serverAddress.sin_addr.s_addr = address;
+    serverAddress.sin_port = htons(port);
+
+    if (lwip_connect(ctx->socket, (struct sockaddr*)&serverAddress, sizeof(serverAddress)) < 0 &&
+        errno != EINPROGRESS) {
+        return MBEDTLS_ERR_NET_CONNECT_FAILED;
+    }
+
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(ctx->socket, &writable);
+    struct timeval tv;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+    int socketError = 0;
+    socklen_t length = sizeof(socketError);
+    if (lwip_select(ctx->socket + 1, nullptr, &writable, nullptr, timeout > 0 ? &tv : nullptr) <= 0 ||
+        lwip_getsockopt(ctx->socket, SOL_SOCKET, SO_ERROR, &socketError, &length) < 0 || socketError != 0) {
+        return MBEDTLS_ERR_NET_CONNECT_FAILED;
+    }
+
+    int enable = 1;
+    lwip_setsockopt(ctx->socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    lwip_setsockopt(ctx->socket, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+
+    // TLS context, set up the way the core's ssl_init() and
+    // start_ssl_client() do so its stop() frees it; stop() leaves the
+    // contexts freed, so every session initializes them again
+    mbedtls_ssl_init(&ctx->ssl_ctx);
+    mbedtls_ssl_config_init(&ctx->ssl_conf);
+    mbedtls_ctr_drbg_init(&ctx->drbg_ctx);
+    mbedtls_entropy_init(&ctx->entropy_ctx);
+    int ret = mbedtls_ctr_drbg_seed(&ctx->drbg_ctx, mbedtls_entropy_func, &ctx->entropy_ctx, nullptr, 0);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = mbedtls_ssl_config_defaults(&ctx->ssl_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (_CA_cert) {
+        mbedtls_x509_crt_init(&ctx->ca_cert);
+        ret = mbedtls_x509_crt_parse(&ctx->ca_cert, (const unsigned char*)_CA_cert, strlen(_CA_cert) + 1);
+        if (ret < 0) {
+            mbedtls_x509_crt_free(&ctx->ca_cert);
+            return ret;
+        }
+        mbedtls_ssl_conf_ca_chain(&ctx->ssl_conf, &ctx->ca_cert, nullptr);
+        mbedtls_ssl_conf_authmode(&ctx->ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    } else {
+        mbedtls_ssl_conf_authmode(&ctx->ssl_conf, MBEDTLS_SSL_VERIFY_NONE);
+    }
+
+    mbedtls_ssl_conf_rng(&ctx->ssl_conf, mbedtls_ctr_drbg_random, &ctx->drbg_ctx);
+    ret = mbedtls_ssl_setup(&ctx->ssl_ctx, &ctx->ssl_conf);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = mbedtls_ssl_set_hostname(&ctx->ssl_ctx, host);
+    if (ret != 0) {
+        return ret;
+    }
+
+    // The one step the core cannot do: offer the cached session
+    String key = String(host) + ":" + String(port);
+    bool offered = tlsSessionCache.restore(key, &ctx->ssl_ctx);
+    mbedtls_ssl_set_bio(&ctx->ssl_ctx, &ctx->socket, mbedtls_net_send, mbedtls_net_recv, nullptr);
+
+    uint32_t start = millis();
+    while ((ret = mbedtls_ssl_handshake(&ctx->ssl_ctx)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            if (offered) {
+                // Do not offer a session the server choked on again
+                tlsSessionCache.forget(key);
+            }
+            return ret;
+        }
+        if (millis() - start > ctx->handshake_timeout) {
+            return MBEDTLS_ERR_SSL_TIMEOUT;
+        }
+        vTaskDelay(2 / portTICK_PERIOD_MS);
+    }
+    uint32_t elapsed = millis() - start;
+
+    if (_CA_cert && mbedtls_ssl_get_verify_result(&ctx->ssl_ctx) != 0) {
+        return MBEDTLS_ERR_X509_CERT_VERIFY_FAILED;
+    }
+
+    bool resumed = offered && tlsSessionCache.wasResumed(key, &ctx->ssl_ctx);
+    tlsSessionCache.recordHandshake(resumed, elapsed);
+    // Saved after a resumption too: the server may have issued a new ticket
+    tlsSessionCache.save(key, &ctx->ssl_ctx);
+
+    Serial.printf("TLS: %s %s handshake in %u ms\n", key.c_str(), resumed ? "resumed" : "full", elapsed);
+    return 0;
+}
+
+#endif // TLS_SESSION_RESUME
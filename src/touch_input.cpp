@@ -0,0 +1,168 @@
+#include "touch_input.h"
+#include "ui_manager.h"
+
+volatile bool TouchInput::irqPending = false;
+volatile uint32_t TouchInput::irqMs = 0;
+
+void IRAM_ATTR TouchInput::onIrq() {
+    // SPI is off limits here: note the time and let poll() read the panel
+    if (!irqPending) {
+        irqMs = millis();
+        irqPending = true;
+    }
+}
+
+TouchInput::TouchInput()
+    : ui(nullptr), head(0), count(0), dropped(0), down(false), startX(0), startY(0), lastX(0), lastY(0),
+      dragX(0), dragY(0), moved(false), downMs(0), lastContactMs(0), releaseMs(0), lastSampleMs(0),
+      samplePeriodMs(0), repressMs(TOUCH_REPRESS_MS), misses(0) {}
+
+void TouchInput::begin(UIManager* ui) {
+    this->ui = ui;
+    if (TOUCH_IRQ >= 0) {
+        pinMode(TOUCH_IRQ, INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(TOUCH_IRQ), onIrq, FALLING);
+    }
+}
+
+void TouchInput::poll() {
+    if (!ui) {
+        return;
+    }
+    
+    // Idle: with the interrupt, nothing to read until it fires
+    uint32_t now = millis();
+    if (!down) {
+        if (TOUCH_IRQ >= 0 && !irqPending) {
+            return;
+        }
+        if (TOUCH_IRQ < 0 && now - lastSampleMs < TOUCH_SAMPLE_MS) {
+            return;
+        }
+    }
+    if (down) {
+        samplePeriodMs = now - lastSampleMs;
+    }
+    lastSampleMs = now;
+    
+    uint16_t x, y;
+    bool contact = ui->checkTouch(x, y);
+    
+    if (!down) {
+        uint32_t pressMs = irqPending ? irqMs : now;
+        irqPending = false;
+        if (!contact) {
+            return;  // A glitch on T_IRQ, or the SPI read itself
+        }
+        if (pressMs - releaseMs < repressMs) {
+            return;  // Bounce of the last release
+        }
+        
+        down = true;
+        moved = false;
+        startX = lastX = dragX = x;
+        startY = lastY = dragY = y;
+        downMs = pressMs;
+        lastContactMs = now;
+        misses = 0;
+        push(TouchEvent::PRESS, x, y, 0, 0, pressMs);
+        return;
+    }
+    
+    if (contact) {
+        lastContactMs = now;
+        misses = 0;
+        lastX = x;
+        lastY = y;
+        
+        if (abs((int)x - startX) > TOUCH_TAP_SLOP_PX || abs((int)y - startY) > TOUCH_TAP_SLOP_PX) {
+            moved = true;
+        }
+        int dx = (int)x - dragX;
+        int dy = (int)y - dragY;
+        if (moved && (abs(dx) >= TOUCH_DRAG_STEP_PX || abs(dy) >= TOUCH_DRAG_STEP_PX)) {
+            push(TouchEvent::DRAG, x, y, dx, dy, now);
+            dragX = x;
+            dragY = y;
+        }
+        return;
+    }
+    
+    // The panel drops out for a sample now and then: only a sustained
+    // gap is a release, however far apart the loop passes are
+    if (misses < 0xFF) {
+        misses++;
+    }
+    if (now - lastContactMs < TOUCH_RELEASE_MS || misses < TOUCH_RELEASE_SAMPLES) {
+        return;
+    }
+    down = false;
+    irqPending = false;
+    releaseMs = lastContactMs;
+    repressMs = max((uint32_t)TOUCH_REPRESS_MS, samplePeriodMs * 2);
+    
+    int dx = (int)lastX - startX;
+    int dy = (int)lastY - startY;
+    uint32_t duration = lastContactMs - downMs;
+    if (!moved) {
+        push(TouchEvent::TAP, startX, startY, 0, 0, lastContactMs);
+    } else if (duration <= TOUCH_SWIPE_MAX_MS && max(abs(dx), abs(dy)) >= TOUCH_SWIPE_MIN_PX) {
+        push(TouchEvent::SWIPE, lastX, lastY, dx, dy, lastContactMs);
+    } else {
+        push(TouchEvent::RELEASE, lastX, lastY, dx, dy, lastContactMs);
+    }
+}
+
+bool TouchInput::next(TouchEvent& event) {
+    if (count == 0) {
+        return false;
+    }
+    event = queue[head];
+    head = (head + 1) % TOUCH_QUEUE_SIZE;
+    count--;
+    return true;
+}
+
+bool TouchInput::nextTap(uint16_t& x, uint16_t& y) {
+    TouchEvent event;
+    while (next(event)) {
+        if (event.type == TouchEvent::TAP) {
+            x = event.x;
+            y = event.y;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TouchInput::clear() {
+    head = 0;
+    count = 0;
+}
+
+bool TouchInput::isDown() {
+    return down;
+}
+
+uint32_t TouchInput::getDroppedCount() {
+    return dropped;
+}
+
+void TouchInput::push(TouchEvent::Type type, uint16_t x, uint16_t y, int16_t dx, int16_t dy, uint32_t timeMs) {
+    // Full: the oldest event goes, the newest is the one that matters
+    if (count == TOUCH_QUEUE_SIZE) {
+        head = (head + 1) % TOUCH_QUEUE_SIZE;
+        count--;
+        dropped++;
+    }
+    TouchEvent& event = queue[(head + count) % TOUCH_QUEUE_SIZE];
+    event.type = type;
+    event.x = x;
+    event.y = y;
+    event.startX = startX;
+    event.startY = startY;
+    event.dx = dx;
+    event.dy = dy;
+    event.timeMs = timeMs;
+    count++;
+}
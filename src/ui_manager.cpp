@@ -1,14 +1,66 @@
 #include "ui_manager.h"
+#include <esp_heap_caps.h>
 
-UIManager::UIManager(TFT_eSPI* tft) : tft(tft), currentScreen(SCREEN_NONE) {}
+// Times the outermost draw call, so nested widgets are not counted twice
+struct UIManager::ComposeScope {
+    UIManager* ui;
+    
+    ComposeScope(UIManager* ui) : ui(ui) {
+        if (ui->composeDepth++ == 0) {
+            ui->composeStart = micros();
+        }
+    }
+    
+    ~ComposeScope() {
+        if (--ui->composeDepth == 0) {
+            ui->composeUs += micros() - ui->composeStart;
+        }
+    }
+};
+
+UIManager::UIManager(TFT_eSPI* tft)
+    : display(tft), tft(tft), canvas(nullptr), bounce{nullptr, nullptr}, dmaReady(false), dmaPending(false),
+      dirtyBands(0), composeDepth(0), composeStart(0), composeUs(0), currentScreen(SCREEN_NONE),
+      screenDamaged(true), stats{0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, frameBytes(0), channelList(10, 40, SCREEN_WIDTH - 20, 160, 40),
+      toastUntil(0), toastShown(false) {}
 
 void UIManager::begin() {
-    tft->begin();
-    tft->setRotation(1); // Landscape
-    tft->fillScreen(COLOR_BG);
+    display->begin();
+    display->setRotation(1); // Landscape
+    
+    // Compose off-screen when there is PSRAM for a full-screen sprite
+    if (UI_USE_SPRITE && psramFound()) {
+        canvas = new TFT_eSprite(display);
+        canvas->setAttribute(PSRAM_ENABLE, true);
+        canvas->setColorDepth(16);
+        size_t bandBytes = SCREEN_WIDTH * UI_FLUSH_BAND_LINES * sizeof(uint16_t);
+        bounce[0] = (uint16_t*)heap_caps_malloc(bandBytes, MALLOC_CAP_DMA);
+        bounce[1] = (uint16_t*)heap_caps_malloc(bandBytes, MALLOC_CAP_DMA);
+        if (canvas->createSprite(SCREEN_WIDTH, SCREEN_HEIGHT) && bounce[0] && bounce[1]) {
+            tft = canvas;
+            dmaReady = display->initDMA();
+            Serial.printf("UI: Composing in PSRAM, %s flushes\n", dmaReady ? "DMA" : "blocking");
+        } else {
+            Serial.println("UI: No memory for the sprite, drawing directly");
+            delete canvas;
+            canvas = nullptr;
+            free(bounce[0]);
+            free(bounce[1]);
+            bounce[0] = bounce[1] = nullptr;
+        }
+    }
+    
+    textCache.begin(display);
+    channelList.begin(display, canvas != nullptr, &textCache);
+    
+    clearScreen();
+    flush();
 }
 
 void UIManager::setScreen(Screen screen) {
+    if (screen == currentScreen && !screenDamaged) {
+        return;
+    }
     currentScreen = screen;
     clearScreen();
 }
@@ -17,9 +69,16 @@ Screen UIManager::getCurrentScreen() {
     return currentScreen;
 }
 
+bool UIManager::isScreenDamaged() {
+    return screenDamaged;
+}
+
 bool UIManager::checkTouch(uint16_t& x, uint16_t& y) {
+    // The touch controller shares the SPI bus with the panel
+    finishFlush();
+    
     uint16_t touchX, touchY;
-    bool touched = tft->getTouch(&touchX, &touchY);
+    bool touched = display->getTouch(&touchX, &touchY);
     
     if (touched) {
         x = touchX;
@@ -32,49 +91,201 @@ bool UIManager::checkTouch(uint16_t& x, uint16_t& y) {
 
 void UIManager::clearScreen() {
     tft->fillScreen(COLOR_BG);
+    widgets.clear();
+    screenDamaged = false;
+    toastShown = false;
+    stats.fullClears++;
+    markDirty(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+void UIManager::markDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+    // A widget repainted under the toast covers it
+    if (toastShown && x < UI_TOAST_X + UI_TOAST_W && x + w > UI_TOAST_X &&
+        y < UI_TOAST_Y + UI_TOAST_H && y + h > UI_TOAST_Y) {
+        toastShown = false;
+    }
+    if (!canvas) {
+        // Already on the panel
+        frameBytes += w * h * 2;
+        return;
+    }
+    int first = max(0, (int)y) / UI_FLUSH_BAND_LINES;
+    int last = min(SCREEN_HEIGHT - 1, y + h - 1) / UI_FLUSH_BAND_LINES;
+    for (int band = first; band <= last; band++) {
+        dirtyBands |= 1u << band;
+    }
+}
+
+void UIManager::flush() {
+    if (!canvas || dirtyBands == 0) {
+        return;
+    }
+    uint32_t start = micros();
+    
+    // The bounce buffers are free once the last flush is off the wire
+    finishFlush();
+    display->startWrite();
+    display->setSwapBytes(false);  // The sprite holds panel byte order
+    
+    uint16_t* pixels = (uint16_t*)canvas->getPointer();
+    int next = 0;
+    for (int band = 0; band * UI_FLUSH_BAND_LINES < SCREEN_HEIGHT; band++) {
+        if (!(dirtyBands & (1u << band))) {
+            continue;
+        }
+        int y = band * UI_FLUSH_BAND_LINES;
+        int h = min(UI_FLUSH_BAND_LINES, SCREEN_HEIGHT - y);
+        if (dmaReady) {
+            // Copies into one buffer while the other is still being sent
+            display->pushImageDMA(0, y, SCREEN_WIDTH, h, pixels + y * SCREEN_WIDTH, bounce[next]);
+            next ^= 1;
+        } else {
+            display->pushImage(0, y, SCREEN_WIDTH, h, pixels + y * SCREEN_WIDTH);
+        }
+        frameBytes += SCREEN_WIDTH * h * 2;
+    }
+    dirtyBands = 0;
+    
+    if (dmaReady) {
+        dmaPending = true;  // Left to finish in the background
+    } else {
+        display->endWrite();
+    }
+    stats.lastFlushUs = micros() - start;
+}
+
+void UIManager::finishFlush() {
+    if (dmaPending) {
+        display->dmaWait();
+        display->endWrite();
+        dmaPending = false;
+    }
+}
+
+bool UIManager::needsPaint(int16_t x, int16_t y, int16_t w, int16_t h, uint32_t state) {
+    for (auto& widget : widgets) {
+        if (widget.x == x && widget.y == y && widget.w == w && widget.h == h) {
+            if (widget.state == state) {
+                return false;
+            }
+            widget.state = state;
+            markDirty(x, y, w, h);
+            return true;
+        }
+    }
+    widgets.push_back({x, y, w, h, state});
+    markDirty(x, y, w, h);
+    return true;
+}
+
+uint32_t UIManager::hashState(const String& text, uint32_t seed) {
+    // FNV-1a
+    uint32_t hash = seed;
+    for (size_t i = 0; i < text.length(); i++) {
+        hash ^= (uint8_t)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t UIManager::hashState(uint32_t value, uint32_t seed) {
+    uint32_t hash = seed;
+    for (int i = 0; i < 4; i++) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void UIManager::endFrame() {
+    // The toast goes on last so it stays above this pass's widgets
+    if (toastText.length() > 0) {
+        if ((int32_t)(millis() - toastUntil) >= 0) {
+            toastText = "";
+            screenDamaged = true;
+        } else if (!toastShown) {
+            drawToast();
+        }
+    }
+    flush();
+    if (frameBytes == 0) {
+        return;
+    }
+    stats.lastComposeUs = composeUs;
+    composeUs = 0;
+    stats.frames++;
+    stats.bytes += frameBytes;
+    stats.lastFrameBytes = frameBytes;
+    frameBytes = 0;
+}
+
+bool UIManager::isAnimating() {
+    return currentScreen == SCREEN_CHANNEL_LIST && channelList.isMoving();
+}
+
+UIManager::DrawStats UIManager::getDrawStats() {
+    TextCache::Stats text = textCache.getStats();
+    stats.textHits = text.hits;
+    stats.textMisses = text.misses;
+    stats.textHitUs = text.hits ? text.hitUs / text.hits : 0;
+    stats.textMissUs = text.misses ? text.renderUs / text.misses : 0;
+    return stats;
 }
 
 void UIManager::drawHeader(const String& title) {
+    if (!needsPaint(0, 0, SCREEN_WIDTH, 30, hashState(title))) {
+        return;
+    }
     tft->fillRect(0, 0, SCREEN_WIDTH, 30, COLOR_PRIMARY);
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(2);
-    tft->setTextDatum(MC_DATUM);
-    tft->drawString(title, SCREEN_WIDTH / 2, 15);
+    drawText(title, SCREEN_WIDTH / 2, 15, 2, MC_DATUM, COLOR_WHITE, COLOR_PRIMARY);
+}
+
+void UIManager::drawRow(int16_t x, int16_t y, int16_t w, int16_t h, const String& text, uint16_t color, int16_t textY) {
+    // A list row; an empty one is blank background
+    if (!needsPaint(x, y, w, h, hashState(text, hashState(color)))) {
+        return;
+    }
+    tft->fillRect(x, y, w, h, COLOR_BG);
+    if (text.length() == 0) {
+        return;
+    }
+    tft->fillRoundRect(x, y, w, h, 5, color);
+    drawText(text, x + 10, textY, 2, ML_DATUM, COLOR_WHITE, color);
+}
+
+void UIManager::drawText(const String& text, int16_t x, int16_t y, uint8_t size, uint8_t datum, uint16_t fg, uint16_t bg) {
+    textCache.draw(tft, canvas, text, x, y, size, datum, fg, bg);
 }
 
 void UIManager::drawSplash() {
+    ComposeScope scope(this);
+    currentScreen = SCREEN_SPLASH;
     clearScreen();
     
     // Draw SiriusXM logo text
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(3);
-    tft->setTextDatum(MC_DATUM);
-    tft->drawString("SiriusXM", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 - 20);
+    drawText("SiriusXM", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 - 20, 3, MC_DATUM, COLOR_WHITE, COLOR_BG);
+    
+    drawText("IntraRadio", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 20, 2, MC_DATUM, COLOR_WHITE, COLOR_BG);
     
-    tft->setTextSize(2);
-    tft->drawString("IntraRadio", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 20);
+    drawText("Initializing...", SCREEN_WIDTH / 2, SCREEN_HEIGHT - 30, 1, MC_DATUM, COLOR_WHITE, COLOR_BG);
     
-    tft->setTextSize(1);
-    tft->drawString("Initializing...", SCREEN_WIDTH / 2, SCREEN_HEIGHT - 30);
+    // Boot work follows, not the loop: show it now
+    flush();
 }
 
-void UIManager::drawWiFiScan(const std::vector<String>& networks, int selected) {
-    drawHeader("WiFi Networks");
+void UIManager::drawWiFiScan(const std::vector<String>& networks, int selected, bool scanning) {
+    ComposeScope scope(this);
+    drawHeader(scanning ? "WiFi Networks..." : "WiFi Networks");
     
     int y = 40;
     int itemHeight = 35;
     int maxVisible = 5;
     
-    for (int i = 0; i < networks.size() && i < maxVisible; i++) {
+    // Rows fill in as scan results arrive; unchanged ones are left alone
+    for (int i = 0; i < maxVisible; i++) {
+        String text = i < networks.size() ? networks[i] : "";
         uint16_t bgColor = (i == selected) ? COLOR_PRIMARY : COLOR_DARKGRAY;
-        uint16_t textColor = COLOR_WHITE;
-        
-        tft->fillRoundRect(10, y, SCREEN_WIDTH - 20, itemHeight - 5, 5, bgColor);
-        tft->setTextColor(textColor);
-        tft->setTextSize(2);
-        tft->setTextDatum(ML_DATUM);
-        tft->drawString(networks[i], 20, y + itemHeight / 2 - 2);
-        
+        drawRow(10, y, SCREEN_WIDTH - 20, itemHeight - 5, text, bgColor, y + itemHeight / 2 - 2);
         y += itemHeight;
     }
     
@@ -85,25 +296,25 @@ void UIManager::drawWiFiScan(const std::vector<String>& networks, int selected)
 }
 
 void UIManager::drawPasswordInput(const String& ssid, const String& password) {
+    ComposeScope scope(this);
     drawHeader("Enter Password");
     
     // Draw SSID
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(1);
-    tft->setTextDatum(TL_DATUM);
-    tft->drawString("Network: " + ssid, 10, 40);
+    if (needsPaint(10, 36, SCREEN_WIDTH - 20, 20, hashState(ssid))) {
+        tft->fillRect(10, 36, SCREEN_WIDTH - 20, 20, COLOR_BG);
+        drawText("Network: " + ssid, 10, 40, 1, TL_DATUM, COLOR_WHITE, COLOR_BG);
+    }
     
     // Draw password field
-    tft->fillRoundRect(10, 60, SCREEN_WIDTH - 20, 30, 5, COLOR_DARKGRAY);
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(2);
-    tft->setTextDatum(ML_DATUM);
-    
-    String displayPass = "";
-    for (int i = 0; i < password.length(); i++) {
-        displayPass += "*";
+    if (needsPaint(10, 60, SCREEN_WIDTH - 20, 30, hashState(password.length()))) {
+        tft->fillRoundRect(10, 60, SCREEN_WIDTH - 20, 30, 5, COLOR_DARKGRAY);
+        
+        String displayPass = "";
+        for (int i = 0; i < password.length(); i++) {
+            displayPass += "*";
+        }
+        drawText(displayPass, 20, 75, 2, ML_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
     }
-    tft->drawString(displayPass, 20, 75);
     
     // Draw keyboard
     drawKeyboard(false);
@@ -113,33 +324,31 @@ void UIManager::drawPasswordInput(const String& ssid, const String& password) {
 }
 
 void UIManager::drawSXMLogin(const String& email, const String& password, bool emailField) {
+    ComposeScope scope(this);
     drawHeader("SiriusXM Login");
     
-    // Email field
+    // Email field, with its label above it
     uint16_t emailColor = emailField ? COLOR_PRIMARY : COLOR_DARKGRAY;
-    tft->fillRoundRect(10, 50, SCREEN_WIDTH - 20, 30, 5, emailColor);
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(1);
-    tft->setTextDatum(TL_DATUM);
-    tft->drawString("Email:", 15, 42);
-    tft->setTextSize(2);
-    tft->setTextDatum(ML_DATUM);
-    tft->drawString(email, 20, 65);
+    if (needsPaint(10, 40, SCREEN_WIDTH - 20, 40, hashState(email, hashState(emailColor)))) {
+        tft->fillRect(10, 40, SCREEN_WIDTH - 20, 10, COLOR_BG);
+        tft->fillRoundRect(10, 50, SCREEN_WIDTH - 20, 30, 5, emailColor);
+        drawText("Email:", 15, 42, 1, TL_DATUM, COLOR_WHITE, COLOR_BG);
+        drawText(email, 20, 65, 2, ML_DATUM, COLOR_WHITE, emailColor);
+    }
     
     // Password field
     uint16_t passColor = !emailField ? COLOR_PRIMARY : COLOR_DARKGRAY;
-    tft->fillRoundRect(10, 95, SCREEN_WIDTH - 20, 30, 5, passColor);
-    tft->setTextSize(1);
-    tft->setTextDatum(TL_DATUM);
-    tft->drawString("Password:", 15, 87);
-    
-    String displayPass = "";
-    for (int i = 0; i < password.length(); i++) {
-        displayPass += "*";
+    if (needsPaint(10, 85, SCREEN_WIDTH - 20, 40, hashState(password.length(), hashState(passColor)))) {
+        tft->fillRect(10, 85, SCREEN_WIDTH - 20, 10, COLOR_BG);
+        tft->fillRoundRect(10, 95, SCREEN_WIDTH - 20, 30, 5, passColor);
+        drawText("Password:", 15, 87, 1, TL_DATUM, COLOR_WHITE, COLOR_BG);
+        
+        String displayPass = "";
+        for (int i = 0; i < password.length(); i++) {
+            displayPass += "*";
+        }
+        drawText(displayPass, 20, 110, 2, ML_DATUM, COLOR_WHITE, passColor);
     }
-    tft->setTextSize(2);
-    tft->setTextDatum(ML_DATUM);
-    tft->drawString(displayPass, 20, 110);
     
     // Draw keyboard
     drawKeyboard(false);
@@ -149,15 +358,15 @@ void UIManager::drawSXMLogin(const String& email, const String& password, bool e
 }
 
 void UIManager::drawFMConfig(float frequency) {
+    ComposeScope scope(this);
     drawHeader("FM Frequency");
     
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(3);
-    tft->setTextDatum(MC_DATUM);
-    
     char freqStr[10];
     sprintf(freqStr, "%.1f MHz", frequency);
-    tft->drawString(freqStr, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 - 20);
+    if (needsPaint(40, SCREEN_HEIGHT / 2 - 40, SCREEN_WIDTH - 80, 40, hashState(String(freqStr)))) {
+        tft->fillRect(40, SCREEN_HEIGHT / 2 - 40, SCREEN_WIDTH - 80, 40, COLOR_BG);
+        drawText(freqStr, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 - 20, 3, MC_DATUM, COLOR_WHITE, COLOR_BG);
+    }
     
     // Draw - and + buttons
     drawButton(60, SCREEN_HEIGHT / 2 + 20, 60, 40, "-", COLOR_SECONDARY);
@@ -168,24 +377,21 @@ void UIManager::drawFMConfig(float frequency) {
 }
 
 void UIManager::drawMainScreen(const String& channelName, const String& artist) {
-    clearScreen();
-    
+    ComposeScope scope(this);
     // Draw SXM logo area (touchable)
-    tft->fillRoundRect(10, 10, 140, 80, 10, COLOR_PRIMARY);
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(2);
-    tft->setTextDatum(MC_DATUM);
-    tft->drawString("SiriusXM", 80, 50);
+    if (needsPaint(10, 10, 140, 80, 0)) {
+        tft->fillRoundRect(10, 10, 140, 80, 10, COLOR_PRIMARY);
+        drawText("SiriusXM", 80, 50, 2, MC_DATUM, COLOR_WHITE, COLOR_PRIMARY);
+    }
     
     // Draw current channel info
-    tft->fillRoundRect(160, 10, SCREEN_WIDTH - 170, 80, 10, COLOR_DARKGRAY);
-    tft->setTextSize(2);
-    tft->setTextDatum(MC_DATUM);
-    tft->drawString(channelName, 240, 35);
-    
-    if (artist.length() > 0) {
-        tft->setTextSize(1);
-        tft->drawString(artist, 240, 60);
+    if (needsPaint(160, 10, SCREEN_WIDTH - 170, 80, hashState(artist, hashState(channelName)))) {
+        tft->fillRoundRect(160, 10, SCREEN_WIDTH - 170, 80, 10, COLOR_DARKGRAY);
+        drawText(channelName, 240, 35, 2, MC_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
+        
+        if (artist.length() > 0) {
+            drawText(artist, 240, 60, 1, MC_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
+        }
     }
     
     // Draw internet radio button
@@ -195,43 +401,96 @@ void UIManager::drawMainScreen(const String& channelName, const String& artist)
     drawButton(160, 100, 140, 60, "Settings", COLOR_SECONDARY);
     
     // Draw status bar at bottom
-    tft->fillRect(0, SCREEN_HEIGHT - 20, SCREEN_WIDTH, 20, COLOR_DARKGRAY);
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(1);
-    tft->setTextDatum(MC_DATUM);
-    tft->drawString("Touch SiriusXM logo to change channels", SCREEN_WIDTH / 2, SCREEN_HEIGHT - 10);
+    if (needsPaint(0, SCREEN_HEIGHT - 20, SCREEN_WIDTH, 20, 0)) {
+        tft->fillRect(0, SCREEN_HEIGHT - 20, SCREEN_WIDTH, 20, COLOR_DARKGRAY);
+        drawText("Touch SiriusXM logo to change channels", SCREEN_WIDTH / 2, SCREEN_HEIGHT - 10, 1, MC_DATUM,
+                 COLOR_WHITE, COLOR_DARKGRAY);
+    }
+}
+
+void UIManager::setChannelList(size_t count, const ListView::ItemText& text, int selected) {
+    channelList.setItems(count, text);
+    channelList.setSelected(selected);
+    channelList.scrollToItem(selected);
 }
 
-void UIManager::drawChannelList(const std::vector<String>& channels, int selected, int offset) {
+void UIManager::drawChannelList(int selected) {
+    ComposeScope scope(this);
     drawHeader("Select Channel");
     
-    int y = 40;
-    int itemHeight = 40;
-    int maxVisible = 4;
-    
-    for (int i = offset; i < channels.size() && i < offset + maxVisible; i++) {
-        uint16_t bgColor = (i == selected) ? COLOR_PRIMARY : COLOR_DARKGRAY;
-        uint16_t textColor = COLOR_WHITE;
-        
-        tft->fillRoundRect(10, y, SCREEN_WIDTH - 20, itemHeight - 5, 5, bgColor);
-        tft->setTextColor(textColor);
-        tft->setTextSize(2);
-        tft->setTextDatum(ML_DATUM);
-        tft->drawString(channels[i], 20, y + itemHeight / 2);
-        
-        y += itemHeight;
+    // Only the rows on screen are drawn, and only when the list moved or
+    // the selection changed
+    channelList.setSelected(selected);
+    channelList.update();
+    if (needsPaint(10, 40, SCREEN_WIDTH - 20, 160, channelList.getState())) {
+        channelList.draw(tft, canvas);
     }
     
     // Draw scrollbar
-    if (channels.size() > maxVisible) {
-        drawScrollbar(SCREEN_WIDTH - 8, 40, 160, channels.size(), selected, maxVisible);
+    int32_t contentHeight = channelList.getContentHeight();
+    if (contentHeight > 160) {
+        drawScrollbar(SCREEN_WIDTH - 8, 40, 160, contentHeight, channelList.getScroll(), 160);
     }
     
-    // Draw back button
+    // Draw back and search buttons
     drawButton(10, SCREEN_HEIGHT - 40, 80, 35, "Back", COLOR_SECONDARY);
+    drawButton(SCREEN_WIDTH - 90, SCREEN_HEIGHT - 40, 80, 35, "Search", COLOR_PRIMARY);
+}
+
+int UIManager::channelListTouch(const TouchEvent& event) {
+    if (currentScreen != SCREEN_CHANNEL_LIST) {
+        return -1;
+    }
+    return channelList.handleTouch(event);
+}
+
+void UIManager::drawSearch() {
+    ComposeScope scope(this);
+    drawHeader("Search");
+    
+    // Delete and back buttons next to the query field
+    drawButton(SCREEN_WIDTH - 115, 34, 50, 26, "Del", COLOR_RED);
+    drawButton(SCREEN_WIDTH - 60, 34, 50, 26, "Back", COLOR_SECONDARY);
+    
+    drawKeyboard(false);
+}
+
+void UIManager::drawSearchResults(const String& query, const std::vector<String>& results, size_t total) {
+    ComposeScope scope(this);
+    // Query field
+    if (needsPaint(10, 34, SCREEN_WIDTH - 130, 26, hashState(query))) {
+        tft->fillRoundRect(10, 34, SCREEN_WIDTH - 130, 26, 5, COLOR_DARKGRAY);
+        drawText(query, 16, 47, 2, ML_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
+    }
+    
+    // Result rows between the query field and the keyboard
+    int y = 64;
+    int itemHeight = 34;
+    bool noMatches = query.length() > 0 && total == 0;
+    for (size_t i = 0; i < SEARCH_VISIBLE_RESULTS; i++) {
+        if (i == 0 && noMatches) {
+            // Shown in place of the first row
+            if (needsPaint(10, y, SCREEN_WIDTH - 20, itemHeight - 4, hashState("No matches"))) {
+                tft->fillRect(10, y, SCREEN_WIDTH - 20, itemHeight - 4, COLOR_BG);
+                drawText("No matches", SCREEN_WIDTH / 2, 64 + itemHeight / 2, 1, MC_DATUM, COLOR_LIGHTGRAY, COLOR_BG);
+            }
+        } else {
+            String text = i < results.size() ? results[i] : "";
+            drawRow(10, y, SCREEN_WIDTH - 20, itemHeight - 4, text, COLOR_PRIMARY, y + (itemHeight - 4) / 2);
+        }
+        y += itemHeight;
+    }
+    
+    // Count of the matches that did not fit, in the strip above the keyboard
+    String more = total > SEARCH_VISIBLE_RESULTS ? "+" + String(total - SEARCH_VISIBLE_RESULTS) + " more" : "";
+    if (needsPaint(0, y - 4, SCREEN_WIDTH, 8, hashState(more))) {
+        tft->fillRect(0, y - 4, SCREEN_WIDTH, 8, COLOR_BG);
+        drawText(more, SCREEN_WIDTH - 12, y, 1, MR_DATUM, COLOR_LIGHTGRAY, COLOR_BG);
+    }
 }
 
 void UIManager::drawSettings() {
+    ComposeScope scope(this);
     drawHeader("Settings");
     
     int y = 50;
@@ -245,14 +504,13 @@ void UIManager::drawSettings() {
     };
     
     for (int i = 0; i < 4; i++) {
-        tft->fillRoundRect(10, y, SCREEN_WIDTH - 20, itemHeight - 5, 5, COLOR_DARKGRAY);
-        tft->setTextColor(COLOR_WHITE);
-        tft->setTextSize(2);
-        tft->setTextDatum(ML_DATUM);
-        tft->drawString(menuItems[i], 20, y + itemHeight / 2);
-        
-        // Draw arrow
-        tft->drawString(">", SCREEN_WIDTH - 30, y + itemHeight / 2);
+        if (needsPaint(10, y, SCREEN_WIDTH - 20, itemHeight - 5, hashState(String(menuItems[i])))) {
+            tft->fillRoundRect(10, y, SCREEN_WIDTH - 20, itemHeight - 5, 5, COLOR_DARKGRAY);
+            drawText(menuItems[i], 20, y + itemHeight / 2, 2, ML_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
+            
+            // Draw arrow
+            drawText(">", SCREEN_WIDTH - 30, y + itemHeight / 2, 2, ML_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
+        }
         
         y += itemHeight;
     }
@@ -262,15 +520,21 @@ void UIManager::drawSettings() {
 }
 
 void UIManager::drawLoading(const String& message) {
-    clearScreen();
+    ComposeScope scope(this);
+    if (currentScreen != SCREEN_LOADING) {
+        currentScreen = SCREEN_LOADING;
+        clearScreen();
+    }
     
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(2);
-    tft->setTextDatum(MC_DATUM);
-    tft->drawString(message, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+    if (needsPaint(0, SCREEN_HEIGHT / 2 - 12, SCREEN_WIDTH, 24, hashState(message))) {
+        tft->fillRect(0, SCREEN_HEIGHT / 2 - 12, SCREEN_WIDTH, 24, COLOR_BG);
+        drawText(message, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, 2, MC_DATUM, COLOR_WHITE, COLOR_BG);
+    }
     
     // Draw simple spinner
     static uint8_t angle = 0;
+    needsPaint(SCREEN_WIDTH / 2 - 30, SCREEN_HEIGHT / 2, 61, 61, angle);
+    tft->fillRect(SCREEN_WIDTH / 2 - 30, SCREEN_HEIGHT / 2, 61, 61, COLOR_BG);
     for (int i = 0; i < 8; i++) {
         float a = (angle + i * 45) * 0.0174533;
         int x1 = SCREEN_WIDTH / 2 + cos(a) * 20;
@@ -281,26 +545,36 @@ void UIManager::drawLoading(const String& message) {
         tft->drawLine(x1, y1, x2, y2, color);
     }
     angle += 10;
+    
+    // A blocking step follows: show it now
+    flush();
 }
 
 void UIManager::drawButton(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const String& text, uint16_t color, bool pressed) {
+    ComposeScope scope(this);
     uint16_t bgColor = pressed ? tft->color565(color >> 1, (color >> 1) & 0x3F, color & 0x1F) : color;
+    if (!needsPaint(x, y, w, h, hashState(text, hashState(bgColor)))) {
+        return;
+    }
     
     tft->fillRoundRect(x, y, w, h, 5, bgColor);
     tft->drawRoundRect(x, y, w, h, 5, COLOR_WHITE);
     
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(2);
-    tft->setTextDatum(MC_DATUM);
-    tft->drawString(text, x + w / 2, y + h / 2);
+    drawText(text, x + w / 2, y + h / 2, 2, MC_DATUM, COLOR_WHITE, bgColor);
 }
 
 void UIManager::drawKeyboard(bool uppercase) {
+    ComposeScope scope(this);
     int startY = 170;
     int keyW = 26;
     int keyH = 22;
     int gap = 2;
     
+    // The keyboard is one widget: it only changes with the case
+    if (!needsPaint(0, startY, SCREEN_WIDTH, SCREEN_HEIGHT - startY, uppercase)) {
+        return;
+    }
+    
     const char* rows[] = {
         "1234567890",
         "QWERTYUIOP",
@@ -323,12 +597,9 @@ void UIManager::drawKeyboard(bool uppercase) {
             int y = startY + row * (keyH + gap);
             
             tft->fillRoundRect(x, y, keyW, keyH, 3, COLOR_DARKGRAY);
-            tft->setTextColor(COLOR_WHITE);
-            tft->setTextSize(1);
-            tft->setTextDatum(MC_DATUM);
             
             char c[2] = {rows[row][col], '\0'};
-            tft->drawString(c, x + keyW / 2, y + keyH / 2);
+            drawText(c, x + keyW / 2, y + keyH / 2, 1, MC_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
         }
     }
     
@@ -336,15 +607,12 @@ void UIManager::drawKeyboard(bool uppercase) {
     int spaceX = 80;
     int spaceY = startY + 4 * (keyH + gap);
     tft->fillRoundRect(spaceX, spaceY, 160, keyH, 3, COLOR_DARKGRAY);
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(1);
-    tft->setTextDatum(MC_DATUM);
-    tft->drawString("SPACE", spaceX + 80, spaceY + keyH / 2);
+    drawText("SPACE", spaceX + 80, spaceY + keyH / 2, 1, MC_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
     
     // Backspace
     int bkspX = 10;
     tft->fillRoundRect(bkspX, spaceY, 60, keyH, 3, COLOR_RED);
-    tft->drawString("<-", bkspX + 30, spaceY + keyH / 2);
+    drawText("<-", bkspX + 30, spaceY + keyH / 2, 1, MC_DATUM, COLOR_WHITE, COLOR_RED);
 }
 
 char UIManager::getKeyboardPress(uint16_t x, uint16_t y, bool uppercase) {
@@ -396,6 +664,7 @@ char UIManager::getKeyboardPress(uint16_t x, uint16_t y, bool uppercase) {
 }
 
 void UIManager::showMessage(const String& title, const String& message, uint16_t duration) {
+    ComposeScope scope(this);
     // Draw message box
     int boxW = 260;
     int boxH = 100;
@@ -404,26 +673,50 @@ void UIManager::showMessage(const String& title, const String& message, uint16_t
     
     tft->fillRoundRect(boxX, boxY, boxW, boxH, 10, COLOR_DARKGRAY);
     tft->drawRoundRect(boxX, boxY, boxW, boxH, 10, COLOR_WHITE);
+    markDirty(boxX, boxY, boxW, boxH);
     
-    tft->setTextColor(COLOR_WHITE);
-    tft->setTextSize(2);
-    tft->setTextDatum(MC_DATUM);
-    tft->drawString(title, SCREEN_WIDTH / 2, boxY + 25);
+    drawText(title, SCREEN_WIDTH / 2, boxY + 25, 2, MC_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
     
-    tft->setTextSize(1);
-    tft->drawString(message, SCREEN_WIDTH / 2, boxY + 55);
+    drawText(message, SCREEN_WIDTH / 2, boxY + 55, 1, MC_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
     
+    // The box covers parts of several widgets: the next setScreen() repaints all
+    screenDamaged = true;
+    
+    flush();
     delay(duration);
 }
 
+void UIManager::showToast(const String& message, uint16_t duration) {
+    toastText = message;
+    toastUntil = millis() + duration;
+    toastShown = false;
+}
+
+void UIManager::drawToast() {
+    ComposeScope scope(this);
+    tft->fillRoundRect(UI_TOAST_X, UI_TOAST_Y, UI_TOAST_W, UI_TOAST_H, 8, COLOR_DARKGRAY);
+    tft->drawRoundRect(UI_TOAST_X, UI_TOAST_Y, UI_TOAST_W, UI_TOAST_H, 8, COLOR_WHITE);
+    drawText(toastText, SCREEN_WIDTH / 2, UI_TOAST_Y + UI_TOAST_H / 2, 2, MC_DATUM, COLOR_WHITE, COLOR_DARKGRAY);
+    markDirty(UI_TOAST_X, UI_TOAST_Y, UI_TOAST_W, UI_TOAST_H);
+    toastShown = true;
+}
+
 void UIManager::drawProgress(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t percent) {
+    ComposeScope scope(this);
+    if (!needsPaint(x, y, w, h, percent)) {
+        return;
+    }
     tft->drawRoundRect(x, y, w, h, 3, COLOR_WHITE);
     
     uint16_t fillW = (w - 4) * percent / 100;
+    tft->fillRect(x + 2, y + 2, w - 4, h - 4, COLOR_BG);
     tft->fillRoundRect(x + 2, y + 2, fillW, h - 4, 2, COLOR_GREEN);
 }
 
 void UIManager::drawScrollbar(uint16_t x, uint16_t y, uint16_t h, int total, int current, int visible) {
+    if (!needsPaint(x, y, 4, h, hashState(total, hashState(current)))) {
+        return;
+    }
     tft->fillRect(x, y, 4, h, COLOR_DARKGRAY);
     
     int thumbH = (h * visible) / total;
@@ -1,53 +1,186 @@
 #include "wifi_manager.h"
+#include "config.h"
 
-WiFiMgr::WiFiMgr() {}
+WiFiMgr::WiFiMgr()
+    : hintsOpen(false), beginMs(0), connectMs(0), fastAttempt(false), fastConnect(false),
+      roamState(ROAM_IDLE), roamStats{0, 0, 0, 0, 0}, rssiCount(0), rssiPos(0), lastSampleMs(0),
+      lastRoamScanMs(0), roamStateMs(0), gapStartMs(0), fallback(false), powerMode(POWER_IDLE),
+      powerSave(WIFI_PS_MIN_MODEM), powerStats{0, 0, 0, 0}, powerModeMs(0), scanChannel(0) {}
 
 std::vector<WiFiNetwork> WiFiMgr::scanNetworks() {
-    std::vector<WiFiNetwork> networks;
+    if (startScan()) {
+        while (isScanning()) {
+            pollScan();
+            delay(10);
+        }
+    }
+    return networks;
+}
+
+bool WiFiMgr::startScan() {
+    if (scanChannel != 0) {
+        return false;
+    }
     
     Serial.println("Scanning WiFi networks...");
-    WiFi.mode(WIFI_STA);
-    WiFi.disconnect();
-    delay(100);
     
-    int n = WiFi.scanNetworks();
-    Serial.printf("Found %d networks\n", n);
+    // Scanning works alongside an association: no disconnect, so a stream
+    // that is playing keeps playing
+    if (WiFi.getMode() == WIFI_OFF) {
+        WiFi.mode(WIFI_STA);
+    }
     
-    for (int i = 0; i < n; i++) {
-        WiFiNetwork network;
-        network.ssid = WiFi.SSID(i);
-        network.rssi = WiFi.RSSI(i);
-        network.encrypted = (WiFi.encryptionType(i) != WIFI_AUTH_OPEN);
+    networks.clear();
+    networkIndex.clear();
+    scanChannel = 1;
+    if (!scanChannelStart()) {
+        scanChannel = 0;
+        return false;
+    }
+    return true;
+}
+
+bool WiFiMgr::pollScan() {
+    if (scanChannel == 0) {
+        return false;
+    }
+    
+    int count = WiFi.scanComplete();
+    if (count == WIFI_SCAN_RUNNING) {
+        return false;
+    }
+    
+    // A failed channel is skipped, not retried
+    bool changed = count > 0 && mergeScanResults(count);
+    WiFi.scanDelete();
+    
+    if (++scanChannel > WIFI_SCAN_CHANNELS || !scanChannelStart()) {
+        scanChannel = 0;
+        Serial.printf("Found %d networks\n", networks.size());
+    }
+    return changed;
+}
+
+bool WiFiMgr::isScanning() {
+    return scanChannel != 0;
+}
+
+const std::vector<WiFiNetwork>& WiFiMgr::getNetworks() {
+    return networks;
+}
+
+bool WiFiMgr::scanChannelStart() {
+    return WiFi.scanNetworks(true, false, false, WIFI_SCAN_MS_PER_CHANNEL, scanChannel) == WIFI_SCAN_RUNNING;
+}
+
+bool WiFiMgr::mergeScanResults(int count) {
+    bool changed = false;
+    for (int i = 0; i < count; i++) {
+        String ssid = WiFi.SSID(i);
+        if (ssid.length() == 0) {
+            continue;
+        }
         
-        // Skip duplicate SSIDs
-        bool duplicate = false;
-        for (const auto& existing : networks) {
-            if (existing.ssid == network.ssid) {
-                duplicate = true;
-                break;
+        // Several APs of one network show up once, with the best signal
+        uint32_t hash = hashSsid(ssid);
+        int rssi = WiFi.RSSI(i);
+        auto it = networkIndex.find(hash);
+        WiFiNetwork* existing = nullptr;
+        if (it != networkIndex.end()) {
+            existing = &networks[it->second];
+            if (existing->ssid != ssid) {
+                // Two SSIDs on one hash: rare enough for a linear look
+                existing = nullptr;
+                for (auto& network : networks) {
+                    if (network.ssid == ssid) {
+                        existing = &network;
+                        break;
+                    }
+                }
             }
         }
+        if (existing) {
+            if (rssi > existing->rssi) {
+                existing->rssi = rssi;
+                memcpy(existing->bssid, WiFi.BSSID(i), sizeof(existing->bssid));
+                existing->channel = WiFi.channel(i);
+                changed = true;
+            }
+            continue;
+        }
         
-        if (!duplicate && network.ssid.length() > 0) {
-            networks.push_back(network);
+        WiFiNetwork network;
+        network.ssid = ssid;
+        network.rssi = rssi;
+        network.encrypted = (WiFi.encryptionType(i) != WIFI_AUTH_OPEN);
+        network.hash = hash;
+        memcpy(network.bssid, WiFi.BSSID(i), sizeof(network.bssid));
+        network.channel = WiFi.channel(i);
+        networks.push_back(network);
+        if (it == networkIndex.end()) {
+            networkIndex[hash] = networks.size() - 1;
         }
+        changed = true;
     }
     
-    // Sort by signal strength
-    std::sort(networks.begin(), networks.end(), [](const WiFiNetwork& a, const WiFiNetwork& b) {
-        return a.rssi > b.rssi;
-    });
-    
-    return networks;
+    if (changed) {
+        // Sort by signal strength; positions move, so the index follows
+        std::sort(networks.begin(), networks.end(), [](const WiFiNetwork& a, const WiFiNetwork& b) {
+            return a.rssi > b.rssi;
+        });
+        networkIndex.clear();
+        for (size_t i = 0; i < networks.size(); i++) {
+            networkIndex.emplace(networks[i].hash, i);
+        }
+    }
+    return changed;
+}
+
+uint32_t WiFiMgr::hashSsid(const String& ssid) {
+    // FNV-1a, as ChannelStore uses for channel ids
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < ssid.length(); i++) {
+        hash ^= (uint8_t)ssid[i];
+        hash *= 16777619u;
+    }
+    return hash;
 }
 
 bool WiFiMgr::connect(const String& ssid, const String& password, uint32_t timeout) {
+    begin(ssid, password);
+    return waitForConnection(timeout);
+}
+
+void WiFiMgr::begin(const String& ssid, const String& password) {
     Serial.printf("Connecting to WiFi: %s\n", ssid.c_str());
+    this->ssid = ssid;
+    this->password = password;
+    beginMs = millis();
+    connectMs = 0;
+    fastAttempt = false;
+    fastConnect = false;
     
     WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid.c_str(), password.c_str());
     
-    return waitForConnection(timeout);
+    // Hints only apply to the network they were recorded on
+    uint8_t bssid[6];
+    if (openHints() && hints.getString(KEY_WIFI_HINT_SSID, "") == ssid &&
+        hints.getBytes(KEY_WIFI_HINT_BSSID, bssid, sizeof(bssid)) == sizeof(bssid)) {
+        int32_t channel = hints.getUChar(KEY_WIFI_HINT_CHANNEL, 0);
+        if (WIFI_REUSE_IP && hints.getUInt(KEY_WIFI_HINT_IP, 0) != 0) {
+            WiFi.config(IPAddress(hints.getUInt(KEY_WIFI_HINT_IP, 0)),
+                        IPAddress(hints.getUInt(KEY_WIFI_HINT_GATEWAY, 0)),
+                        IPAddress(hints.getUInt(KEY_WIFI_HINT_SUBNET, 0)),
+                        IPAddress(hints.getUInt(KEY_WIFI_HINT_DNS, 0)));
+        }
+        Serial.printf("WiFi: Fast connect to %02x:%02x:%02x:%02x:%02x:%02x on channel %d\n",
+                      bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5], channel);
+        WiFi.begin(ssid.c_str(), password.c_str(), channel, bssid);
+        fastAttempt = true;
+        return;
+    }
+    
+    WiFi.begin(ssid.c_str(), password.c_str());
 }
 
 bool WiFiMgr::waitForConnection(uint32_t timeout) {
@@ -58,7 +191,25 @@ bool WiFiMgr::waitForConnection(uint32_t timeout) {
             Serial.println("WiFi connection timeout");
             return false;
         }
-        delay(100);
+        
+        // The AP moved, changed channel or is gone: scan like a first connect
+        if (fastAttempt && millis() - beginMs > WIFI_FAST_CONNECT_MS) {
+            Serial.println("WiFi: Fast connect failed, scanning");
+            fastAttempt = false;
+            forgetHints();
+            WiFi.disconnect();
+            WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+            WiFi.begin(ssid.c_str(), password.c_str());
+        }
+        delay(fastAttempt ? 10 : 100);
+    }
+    
+    if (connectMs == 0) {
+        connectMs = millis() - beginMs;
+        fastConnect = fastAttempt;
+        fastAttempt = false;
+        saveHints();
+        Serial.printf("WiFi: Connected in %u ms (%s)\n", connectMs, fastConnect ? "fast" : "scan");
     }
     
     Serial.println("WiFi connected!");
@@ -67,6 +218,178 @@ bool WiFiMgr::waitForConnection(uint32_t timeout) {
     return true;
 }
 
+void WiFiMgr::setNetworks(const std::vector<SavedNetwork>& networks) {
+    saved = networks;
+}
+
+void WiFiMgr::beginSaved() {
+    if (saved.empty()) {
+        return;
+    }
+    
+    // The last network is the likely one, and the one the hints are for
+    const SavedNetwork* network = &saved[0];
+    if (openHints()) {
+        const SavedNetwork* last = findSaved(hints.getString(KEY_WIFI_HINT_SSID, ""));
+        if (last) {
+            network = last;
+        }
+    }
+    begin(network->ssid, network->password);
+}
+
+bool WiFiMgr::connectBestSaved(uint32_t timeout) {
+    unsigned long startTime = millis();
+    scanNetworks();
+    if (!pickCandidate(-127)) {
+        Serial.println("WiFi: No saved network in range");
+        return false;
+    }
+    
+    begin(roamTarget.ssid, roamPassword);
+    uint32_t elapsed = millis() - startTime;
+    return waitForConnection(timeout > elapsed ? timeout - elapsed : 0);
+}
+
+void WiFiMgr::loop(uint32_t bufferedMs) {
+    if (saved.empty()) {
+        return;
+    }
+    
+    bool connected = WiFi.status() == WL_CONNECTED;
+    switch (roamState) {
+        case ROAM_IDLE:
+            if (!connected) {
+                // Lost: the gap runs from here until a network is back
+                Serial.println("WiFi: Link lost, recovering");
+                gapStartMs = millis();
+                rssiCount = 0;
+                startScan();
+                setRoamState(ROAM_RECOVERING);
+                break;
+            }
+            
+            sampleRssi();
+            if (saved.size() > 1 && rssiCount == WIFI_ROAM_SAMPLES &&
+                millis() - lastRoamScanMs > WIFI_ROAM_SCAN_INTERVAL_MS) {
+                int rssi = averageRssi();
+                bool falling = rssi < WIFI_ROAM_RSSI_DBM && rssiTrend() <= -WIFI_ROAM_TREND_DB;
+                if (falling || rssi < WIFI_ROAM_CRITICAL_DBM) {
+                    Serial.printf("WiFi: RSSI %d dBm (trend %d dB), looking for a better network\n",
+                                  rssi, rssiTrend());
+                    lastRoamScanMs = millis();
+                    if (startScan()) {
+                        setRoamState(ROAM_SCANNING);
+                    }
+                }
+            }
+            break;
+            
+        case ROAM_SCANNING:
+            pollScan();
+            if (!isScanning()) {
+                int threshold = max(WIFI_ROAM_USABLE_DBM, averageRssi() + WIFI_ROAM_HYSTERESIS_DB);
+                setRoamState(pickCandidate(threshold) ? ROAM_WAITING : ROAM_IDLE);
+            }
+            break;
+            
+        case ROAM_WAITING:
+            // A handoff drops the link: only go once the buffer covers it
+            if (bufferedMs >= max((uint32_t)WIFI_ROAM_MIN_BUFFER_MS, roamStats.maxGapMs * 2)) {
+                startHandoff(millis());
+            } else if (millis() - roamStateMs > WIFI_ROAM_BUFFER_WAIT_MS || !connected) {
+                Serial.println("WiFi: Buffer too low for a handoff, staying");
+                setRoamState(ROAM_IDLE);
+            }
+            break;
+            
+        case ROAM_HANDOFF:
+            if (connected) {
+                finishHandoff();
+            } else if (millis() - roamStateMs > WIFI_ROAM_HANDOFF_TIMEOUT_MS) {
+                roamStats.failures++;
+                Serial.printf("WiFi: Handoff to %s timed out\n", roamTarget.ssid.c_str());
+                if (previousSsid.length() > 0 && previousSsid != roamTarget.ssid) {
+                    // Back to where we came from, gap still running
+                    WiFi.disconnect();
+                    begin(previousSsid, previousPassword);
+                    previousSsid = "";
+                    fallback = true;
+                    setRoamState(ROAM_HANDOFF);
+                } else {
+                    fallback = false;
+                    startScan();
+                    setRoamState(ROAM_RECOVERING);
+                }
+            }
+            break;
+            
+        case ROAM_RECOVERING:
+            if (connected) {
+                // The driver's own reconnect got there first
+                finishHandoff();
+                break;
+            }
+            pollScan();
+            if (!isScanning()) {
+                if (pickCandidate(-127)) {
+                    previousSsid = "";
+                    startHandoff(gapStartMs);
+                } else if (millis() - roamStateMs > WIFI_ROAM_HANDOFF_TIMEOUT_MS) {
+                    startScan();
+                    setRoamState(ROAM_RECOVERING);
+                }
+            }
+            break;
+    }
+}
+
+bool WiFiMgr::isRoaming() {
+    return roamState != ROAM_IDLE;
+}
+
+void WiFiMgr::setPowerMode(PowerMode mode) {
+    if (mode != powerMode) {
+        accountPower();
+        if (mode == POWER_REST) {
+            powerStats.restPeriods++;
+        }
+        powerMode = mode;
+    }
+    
+    // Scans and handoffs need the radio awake whatever the audio does
+    wifi_ps_type_t ps = WIFI_PS_MIN_MODEM;
+    if (roamState != ROAM_IDLE || mode == POWER_BURST) {
+        ps = WIFI_PS_NONE;
+    } else if (mode == POWER_REST) {
+        ps = WIFI_PS_MAX_MODEM;
+    }
+    if (ps != powerSave && WiFi.status() == WL_CONNECTED) {
+        WiFi.setSleep(ps);
+        powerSave = ps;
+    }
+}
+
+WiFiMgr::PowerStats WiFiMgr::getPowerStats() {
+    accountPower();
+    return powerStats;
+}
+
+uint32_t WiFiMgr::getEstimatedRadioMa() {
+    PowerStats stats = getPowerStats();
+    uint64_t total = (uint64_t)stats.idleMs + stats.burstMs + stats.restMs;
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t charge = (uint64_t)stats.idleMs * WIFI_RADIO_IDLE_MA + (uint64_t)stats.burstMs * WIFI_RADIO_ACTIVE_MA +
+                      (uint64_t)stats.restMs * WIFI_RADIO_SLEEP_MA;
+    return charge / total;
+}
+
+WiFiMgr::RoamStats WiFiMgr::getRoamStats() {
+    return roamStats;
+}
+
 bool WiFiMgr::isConnected() {
     return WiFi.status() == WL_CONNECTED;
 }
@@ -79,6 +402,197 @@ int WiFiMgr::getRSSI() {
     return WiFi.RSSI();
 }
 
+uint32_t WiFiMgr::getConnectMs() {
+    return connectMs;
+}
+
+bool WiFiMgr::wasFastConnect() {
+    return fastConnect;
+}
+
 void WiFiMgr::disconnect() {
     WiFi.disconnect();
 }
+
+void WiFiMgr::sampleRssi() {
+    if (millis() - lastSampleMs < WIFI_ROAM_SAMPLE_MS) {
+        return;
+    }
+    lastSampleMs = millis();
+    
+    rssiSamples[rssiPos] = WiFi.RSSI();
+    rssiPos = (rssiPos + 1) % WIFI_ROAM_SAMPLES;
+    if (rssiCount < WIFI_ROAM_SAMPLES) {
+        rssiCount++;
+    }
+}
+
+int WiFiMgr::averageRssi() {
+    if (rssiCount == 0) {
+        return WiFi.RSSI();
+    }
+    int sum = 0;
+    for (uint8_t i = 0; i < rssiCount; i++) {
+        sum += rssiSamples[i];
+    }
+    return sum / rssiCount;
+}
+
+int WiFiMgr::rssiTrend() {
+    // Newer half of the window against the older half
+    if (rssiCount < WIFI_ROAM_SAMPLES) {
+        return 0;
+    }
+    int half = WIFI_ROAM_SAMPLES / 2;
+    int older = 0;
+    int newer = 0;
+    for (int i = 0; i < half; i++) {
+        older += rssiSamples[(rssiPos + i) % WIFI_ROAM_SAMPLES];
+        newer += rssiSamples[(rssiPos + half + i) % WIFI_ROAM_SAMPLES];
+    }
+    return (newer - older) / half;
+}
+
+const SavedNetwork* WiFiMgr::findSaved(const String& ssid) {
+    for (const auto& network : saved) {
+        if (network.ssid == ssid) {
+            return &network;
+        }
+    }
+    return nullptr;
+}
+
+bool WiFiMgr::pickCandidate(int minRssi) {
+    // Highest priority wins, then signal; the AP we are on is no candidate
+    const WiFiNetwork* best = nullptr;
+    const SavedNetwork* bestSaved = nullptr;
+    const uint8_t* current = WiFi.status() == WL_CONNECTED ? WiFi.BSSID() : nullptr;
+    for (const auto& network : networks) {
+        const SavedNetwork* match = findSaved(network.ssid);
+        if (!match || network.rssi < minRssi) {
+            continue;
+        }
+        if (current && memcmp(current, network.bssid, sizeof(network.bssid)) == 0) {
+            continue;
+        }
+        if (!best || match->priority > bestSaved->priority ||
+            (match->priority == bestSaved->priority && network.rssi > best->rssi)) {
+            best = &network;
+            bestSaved = match;
+        }
+    }
+    if (!best) {
+        return false;
+    }
+    
+    roamTarget = *best;
+    roamPassword = bestSaved->password;
+    return true;
+}
+
+void WiFiMgr::startHandoff(uint32_t gapStart) {
+    Serial.printf("WiFi: Handing off to %s (%d dBm, channel %d)\n",
+                  roamTarget.ssid.c_str(), roamTarget.rssi, roamTarget.channel);
+    if (roamState != ROAM_RECOVERING) {
+        previousSsid = ssid;
+        previousPassword = password;
+    }
+    gapStartMs = gapStart;
+    fallback = false;
+    
+    // Straight to the AP the scan found; a new network needs DHCP
+    ssid = roamTarget.ssid;
+    password = roamPassword;
+    beginMs = millis();
+    connectMs = 0;
+    fastAttempt = false;
+    fastConnect = false;
+    WiFi.disconnect();
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    WiFi.begin(ssid.c_str(), password.c_str(), roamTarget.channel, roamTarget.bssid);
+    setRoamState(ROAM_HANDOFF);
+}
+
+void WiFiMgr::finishHandoff() {
+    // The way back after a failed handoff already counted as a failure;
+    // its gap is still time off the air
+    uint32_t gap = millis() - gapStartMs;
+    if (!fallback) {
+        roamStats.handoffs++;
+    }
+    fallback = false;
+    roamStats.lastGapMs = gap;
+    roamStats.maxGapMs = max(roamStats.maxGapMs, gap);
+    roamStats.totalGapMs += gap;
+    connectMs = millis() - beginMs;
+    ssid = WiFi.SSID();
+    saveHints();
+    
+    Serial.printf("WiFi: On %s after a %u ms gap (%u handoffs, max %u ms)\n",
+                  ssid.c_str(), gap, roamStats.handoffs, roamStats.maxGapMs);
+    rssiCount = 0;
+    setRoamState(ROAM_IDLE);
+}
+
+void WiFiMgr::setRoamState(RoamState state) {
+    roamState = state;
+    roamStateMs = millis();
+}
+
+void WiFiMgr::accountPower() {
+    uint32_t now = millis();
+    uint32_t elapsed = now - powerModeMs;
+    powerModeMs = now;
+    switch (powerMode) {
+        case POWER_IDLE:
+            powerStats.idleMs += elapsed;
+            break;
+        case POWER_BURST:
+            powerStats.burstMs += elapsed;
+            break;
+        case POWER_REST:
+            powerStats.restMs += elapsed;
+            break;
+    }
+}
+
+bool WiFiMgr::openHints() {
+    if (!hintsOpen) {
+        hintsOpen = hints.begin(WIFI_HINT_NAMESPACE, false);
+    }
+    return hintsOpen;
+}
+
+void WiFiMgr::saveHints() {
+    if (!openHints()) {
+        return;
+    }
+    
+    // Written only when they change, so a normal boot does not touch flash
+    uint8_t stored[6];
+    const uint8_t* bssid = WiFi.BSSID();
+    if (hints.getString(KEY_WIFI_HINT_SSID, "") != ssid) {
+        hints.putString(KEY_WIFI_HINT_SSID, ssid);
+    }
+    if (bssid && (hints.getBytes(KEY_WIFI_HINT_BSSID, stored, sizeof(stored)) != sizeof(stored) ||
+                  memcmp(stored, bssid, sizeof(stored)) != 0)) {
+        hints.putBytes(KEY_WIFI_HINT_BSSID, bssid, sizeof(stored));
+    }
+    if (hints.getUChar(KEY_WIFI_HINT_CHANNEL, 0) != WiFi.channel()) {
+        hints.putUChar(KEY_WIFI_HINT_CHANNEL, WiFi.channel());
+    }
+    
+    uint32_t ip = WiFi.localIP();
+    if (hints.getUInt(KEY_WIFI_HINT_IP, 0) != ip) {
+        hints.putUInt(KEY_WIFI_HINT_IP, ip);
+        hints.putUInt(KEY_WIFI_HINT_GATEWAY, (uint32_t)WiFi.gatewayIP());
+        hints.putUInt(KEY_WIFI_HINT_SUBNET, (uint32_t)WiFi.subnetMask());
+        hints.putUInt(KEY_WIFI_HINT_DNS, (uint32_t)WiFi.dnsIP());
+    }
+}
+
+void WiFiMgr::forgetHints() {
+    if (openHints()) {
+        hints.clear();
+    }
+}
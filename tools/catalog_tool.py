@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Read and write the on-flash channel catalog (see include/channel_catalog.h).
+
+    catalog_tool.py dump catalog.bin           # catalog -> JSON on stdout
+    catalog_tool.py write channels.json out.bin
+    catalog_tool.py verify catalog.bin
+
+The JSON side is either a list of channels or the server's
+{"channels": [...]} response, so a captured /api/channels body can be
+turned into a catalog and uploaded to LittleFS for testing. Optional
+"etag" and "lastModified" keys next to "channels" hold the HTTP
+validators used for the conditional refresh.
+"""
+
+import json
+import struct
+import sys
+import zlib
+
+MAGIC = b"SXMC"
+VERSION = 2
+HEADER = struct.Struct("<4sHHII")
+FIELDS = ("id", "name", "number", "genre", "logoUrl", "streamUrl")
+
+
+def read_catalog(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < HEADER.size:
+        raise ValueError("file too short")
+    magic, version, _, count, crc = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise ValueError("bad magic %r" % magic)
+    if not 1 <= version <= VERSION:
+        raise ValueError("unsupported version %d" % version)
+
+    payload = data[HEADER.size:]
+    if zlib.crc32(payload) != crc:
+        raise ValueError("CRC mismatch")
+
+    pos = 0
+
+    def read_string():
+        nonlocal pos
+        if pos >= len(payload):
+            raise ValueError("truncated record")
+        length = payload[pos]
+        value = payload[pos + 1:pos + 1 + length]
+        if len(value) != length:
+            raise ValueError("truncated field")
+        pos += 1 + length
+        return value.decode("utf-8", "replace")
+
+    catalog = {"etag": "", "lastModified": ""}
+    if version >= 2:
+        catalog["etag"] = read_string()
+        catalog["lastModified"] = read_string()
+
+    catalog["channels"] = [{field: read_string() for field in FIELDS} for _ in range(count)]
+    return catalog
+
+
+def pack_string(payload, value):
+    raw = str(value if value is not None else "").encode("utf-8")[:255]
+    payload.append(len(raw))
+    payload += raw
+
+
+def write_catalog(path, channels, etag="", last_modified=""):
+    payload = bytearray()
+    pack_string(payload, etag)
+    pack_string(payload, last_modified)
+    for channel in channels:
+        for field in FIELDS:
+            # Same fallbacks as the device's channel list parser
+            value = channel.get(field)
+            if value is None and field == "number":
+                value = channel.get("channelNumber")
+            if value is None and field == "logoUrl":
+                value = channel.get("logo")
+            pack_string(payload, value)
+
+    with open(path, "wb") as f:
+        f.write(HEADER.pack(MAGIC, VERSION, 0, len(channels), zlib.crc32(payload)))
+        f.write(payload)
+
+
+def main(argv):
+    if len(argv) == 3 and argv[1] == "dump":
+        json.dump(read_catalog(argv[2]), sys.stdout, indent=2, ensure_ascii=False)
+        print()
+    elif len(argv) == 3 and argv[1] == "verify":
+        print("%s: %d channels" % (argv[2], len(read_catalog(argv[2])["channels"])))
+    elif len(argv) == 4 and argv[1] == "write":
+        with open(argv[2]) as f:
+            doc = json.load(f)
+        if isinstance(doc, dict):
+            channels = doc["channels"]
+            write_catalog(argv[3], channels, doc.get("etag", ""), doc.get("lastModified", ""))
+        else:
+            channels = doc
+            write_catalog(argv[3], channels)
+        print("%s: wrote %d channels" % (argv[3], len(channels)))
+    else:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
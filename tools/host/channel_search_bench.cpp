@@ -0,0 +1,168 @@
+// ChannelSearchIndex on the host: every query checked against a plain
+// word-by-word match over the same items, then build time and query
+// latency for line-ups of a few sizes plus the internet radio stations.
+//
+//     channel_search_bench [queries per measurement]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "channel_search.h"
+#include "config.h"
+#include "radio_stations.h"
+#include "synthetic_channels.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+// What a user types on the way to a few channels, one key at a time
+const char* const QUERIES[] = {
+    "r", "ro", "roc", "rock", "classic r", "classic rock", "1", "10", "101", "hits 2",
+    "jazz", "coffee house", "news", "hip", "hip-hop", "zz", "country legends", "metal heavy"};
+const size_t QUERY_COUNT = sizeof(QUERIES) / sizeof(QUERIES[0]);
+
+static std::vector<std::string> words(const char* text) {
+    std::vector<std::string> out;
+    std::string word;
+    for (const char* p = text;; p++) {
+        char c = *p;
+        if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (uint8_t)c >= 0x80) {
+            word += (char)tolower(c);
+        } else {
+            if (!word.empty()) {
+                out.push_back(word);
+            }
+            word.clear();
+            if (!c) {
+                return out;
+            }
+        }
+    }
+}
+
+// The reference: every query word prefixes some word of the item
+static bool matches(const std::vector<std::string>& query, const std::vector<std::string>& item) {
+    for (const std::string& q : query) {
+        bool found = false;
+        for (const std::string& w : item) {
+            found = found || w.compare(0, q.size(), q) == 0;
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return !query.empty();
+}
+
+static void checkLineUp(size_t count) {
+    ChannelStore store;
+    std::vector<std::vector<std::string>> items;
+    for (size_t i = 0; i < count; i++) {
+        SXMChannel ch = synthetic::channel(i);
+        store.add(ch);
+        std::vector<std::string> item = words(ch.name.c_str());
+        for (const std::string& w : words(ch.genre.c_str())) {
+            item.push_back(w);
+        }
+        item.push_back(ch.number.c_str());
+        items.push_back(item);
+    }
+    for (int i = 0; i < INTERNET_RADIO_STATION_COUNT; i++) {
+        std::vector<std::string> item = words(INTERNET_RADIO_STATIONS[i].name);
+        for (const std::string& w : words(INTERNET_RADIO_STATIONS[i].genre)) {
+            item.push_back(w);
+        }
+        items.push_back(item);
+    }
+
+    ChannelSearchIndex index;
+    index.build(store);
+    CHECK(index.getChannelCount() == count);
+
+    std::vector<uint16_t> results;
+    for (size_t q = 0; q < QUERY_COUNT; q++) {
+        std::vector<uint16_t> expected;
+        std::vector<std::string> query = words(QUERIES[q]);
+        for (size_t i = 0; i < items.size(); i++) {
+            if (matches(query, items[i])) {
+                expected.push_back(i);
+            }
+        }
+        size_t total = index.search(QUERIES[q], results, 0xFFFF);
+        CHECK(total == expected.size());
+        CHECK(results == expected);
+
+        // Capped results are the first of the same list
+        total = index.search(QUERIES[q], results, SEARCH_VISIBLE_RESULTS);
+        CHECK(total == expected.size());
+        CHECK(results.size() == min(expected.size(), (size_t)SEARCH_VISIBLE_RESULTS));
+        CHECK(std::equal(results.begin(), results.end(), expected.begin()));
+    }
+
+    CHECK(index.search("", results, 10) == 0 && results.empty());
+    CHECK(index.search("  -- ", results, 10) == 0);
+}
+
+static void measure(size_t count, size_t rounds) {
+    ChannelStore store;
+    for (size_t i = 0; i < count; i++) {
+        store.add(synthetic::channel(i));
+    }
+
+    ChannelSearchIndex index;
+    auto start = std::chrono::steady_clock::now();
+    index.build(store);
+    double buildUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    // As the UI calls it: only the visible rows are wanted
+    std::vector<uint16_t> results;
+    std::vector<double> samples;
+    size_t hits = 0;
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t q = 0; q < QUERY_COUNT; q++) {
+            auto one = std::chrono::steady_clock::now();
+            hits += index.search(QUERIES[q], results, SEARCH_VISIBLE_RESULTS);
+            samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - one).count());
+        }
+    }
+    double sum = 0;
+    for (double us : samples) {
+        sum += us;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    printf("%8zu %8zu %8zu %10.0f %10.2f %10.2f %10zu\n", count + INTERNET_RADIO_STATION_COUNT, index.getTokenCount(),
+           index.getMemoryUsage(), buildUs, sum / samples.size(), samples[samples.size() * 99 / 100], hits / rounds);
+}
+
+int main(int argc, char** argv) {
+    size_t rounds = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+    Serial.enabled = false;
+
+    for (size_t count : {0, 10, 380, 1000}) {
+        checkLineUp(count);
+    }
+
+    printf("%8s %8s %8s %10s %10s %10s %10s\n", "items", "tokens", "bytes", "build us", "mean us", "p99 us",
+           "matches");
+    for (size_t count : {100, 380, 1000, 4000}) {
+        measure(count, rounds);
+    }
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("channel_search_bench: all checks passed\n");
+    return 0;
+}
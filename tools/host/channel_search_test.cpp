@@ -0,0 +1,90 @@
+// ChannelSearchIndex across a channel list refresh, built with
+// AddressSanitizer: the refreshed line-up arrives in the request's store,
+// SXMClient::apply() replaces its own store with it and the request, with
+// whichever store it is left holding, is freed. The index built before the
+// refresh has to keep reading live memory when nothing changed, and a
+// rebuild has to pick up the new line-up when something did.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "channel_search.h"
+#include "synthetic_channels.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+const size_t COUNT = 380;
+
+static void fill(ChannelStore& store, size_t first) {
+    for (size_t i = first; i < first + COUNT; i++) {
+        store.add(synthetic::channel(i));
+    }
+}
+
+// What the request leaves behind, as apply() does with it
+static bool refresh(ChannelStore& channels, size_t first) {
+    ChannelStore incoming;
+    fill(incoming, first);
+    return channels.replace(incoming);
+}
+
+static void testUnchanged() {
+    ChannelStore channels;
+    fill(channels, 0);
+    ChannelSearchIndex index;
+    index.build(channels);
+
+    std::vector<uint16_t> before;
+    size_t total = index.search("classic rock", before, 0xFFFF);
+    CHECK(total > 0);
+
+    // Same line-up under a new ETag: the index is not rebuilt
+    CHECK(!refresh(channels, 0));
+    std::vector<uint16_t> after;
+    CHECK(index.search("classic rock", after, 0xFFFF) == total);
+    CHECK(after == before);
+    CHECK(index.search("1", after, 0xFFFF) > 0);
+}
+
+static void testChanged() {
+    ChannelStore channels;
+    fill(channels, 0);
+    ChannelSearchIndex index;
+    index.build(channels);
+
+    // A new line-up: the old arena goes with the request, so rebuild
+    CHECK(refresh(channels, 1000));
+    CHECK(strcmp(channels[0].id(), synthetic::channel(1000).id.c_str()) == 0);
+    index.build(channels);
+
+    std::vector<uint16_t> results;
+    String name = channels[7].name();
+    CHECK(index.search(name, results, 0xFFFF) > 0);
+    CHECK(std::find(results.begin(), results.end(), 7) != results.end());
+    for (uint16_t item : results) {
+        CHECK(index.isStation(item) || item < channels.size());
+    }
+}
+
+int main() {
+    Serial.enabled = false;
+
+    testUnchanged();
+    testChanged();
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("channel_search: all checks passed\n");
+    return 0;
+}
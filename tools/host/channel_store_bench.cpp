@@ -0,0 +1,89 @@
+// ChannelStore lookups by id and by number against a linear scan over
+// per-channel Strings, which is what SXMClient did before the indexes.
+//
+//     channel_store_bench [lookups]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "channel_store.h"
+#include "synthetic_channels.h"
+
+static volatile size_t sink;
+
+template <typename F>
+static double nsPerCall(size_t calls, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; i++) {
+        sink = sink + f(i);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+int main(int argc, char** argv) {
+    size_t lookups = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+    int failures = 0;
+
+    printf("%8s %12s %12s %12s %12s\n", "channels", "id ns", "id miss ns", "number ns", "linear ns");
+    for (size_t count : {10, 100, 1000, 10000}) {
+        ChannelStore store;
+        std::vector<SXMChannel> list;
+        std::vector<String> ids;
+        for (size_t i = 0; i < count; i++) {
+            SXMChannel ch = synthetic::channel(i);
+            store.add(ch);
+            ids.push_back(ch.id);
+            list.push_back(ch);
+        }
+        store.shrinkToFit();
+
+        // Ids looked up in a scattered order, so the tables are not walked in step
+        std::vector<uint32_t> order(lookups < 4096 ? lookups : 4096);
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = synthetic::mix(i * 7919 + 1) % count;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (store.findById(ids[i].c_str()).getIndex() != i || store.findByNumber(i + 1).getIndex() != i) {
+                printf("FAIL: lookup of channel %zu at %zu channels\n", i, count);
+                failures++;
+                break;
+            }
+        }
+        if (store.findById("no-such-channel") || store.findByNumber(count + 1)) {
+            printf("FAIL: lookup of a missing channel matched at %zu channels\n", count);
+            failures++;
+        }
+
+        double byId = nsPerCall(lookups, [&](size_t i) {
+            return store.findById(ids[order[i % order.size()]].c_str()).getIndex();
+        });
+        double miss = nsPerCall(lookups, [&](size_t) {
+            return (size_t)(bool)store.findById("no-such-channel");
+        });
+        double byNumber = nsPerCall(lookups, [&](size_t i) {
+            return store.findByNumber(order[i % order.size()] + 1).getIndex();
+        });
+
+        // The old path: compare Strings until the id matches
+        size_t linearCalls = max((size_t)1, lookups / max((size_t)1, count / 10));
+        double linear = nsPerCall(linearCalls, [&](size_t i) {
+            const String& id = ids[order[i % order.size()]];
+            for (size_t j = 0; j < list.size(); j++) {
+                if (list[j].id == id) {
+                    return j;
+                }
+            }
+            return (size_t)0;
+        });
+
+        printf("%8zu %12.1f %12.1f %12.1f %12.1f\n", count, byId, miss, byNumber, linear);
+    }
+
+    if (failures) {
+        return 1;
+    }
+    printf("channel_store_bench: all checks passed\n");
+    return 0;
+}
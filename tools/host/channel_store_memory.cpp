@@ -0,0 +1,73 @@
+// Bytes per channel held by ChannelStore for synthetic line-ups, next to
+// the text those channels carry. "grown" is the store as add() leaves it,
+// "fitted" after shrinkToFit(), which is what a fetch or a catalog load
+// hands to SXMClient.
+//
+//     channel_store_memory [channels...]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "channel_store.h"
+#include "synthetic_channels.h"
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes = {10, 100, 500, 1000, 2000};
+    if (argc > 1) {
+        sizes.clear();
+        for (int i = 1; i < argc; i++) {
+            sizes.push_back(strtoul(argv[i], nullptr, 10));
+        }
+    }
+
+    int failures = 0;
+    printf("%8s %12s %12s %12s %12s %7s\n", "channels", "grown B/ch", "fitted B/ch", "text B/ch", "overhead", "genres");
+    for (size_t count : sizes) {
+        ChannelStore store;
+        ChannelStore copy;
+        for (size_t i = 0; i < count; i++) {
+            SXMChannel ch = synthetic::channel(i);
+            if (!store.add(ch) || !copy.add(ch)) {
+                printf("FAIL: out of memory at %zu channels\n", i);
+                return 1;
+            }
+        }
+        double grown = (double)store.getMemoryUsage() / count;
+        store.shrinkToFit();
+        double fitted = (double)store.getMemoryUsage() / count;
+
+        // Every field reads back as it went in, and lookups still work
+        for (size_t i = 0; i < count; i++) {
+            SXMChannel ch = synthetic::channel(i);
+            ChannelStore::Channel view = store[i];
+            if (ch.id != view.id() || ch.name != view.name() || ch.genre != view.genre() ||
+                ch.logoUrl != view.logoUrl() || (size_t)view.number() != i + 1 ||
+                store.findById(view.id()).getIndex() != i || store.findByNumber(i + 1).getIndex() != i) {
+                printf("FAIL: channel %zu reads back wrong\n", i);
+                failures++;
+                break;
+            }
+        }
+        if (!store.equals(copy)) {
+            printf("FAIL: identical stores compare unequal at %zu channels\n", count);
+            failures++;
+        }
+
+        // Adding after shrinking grows again
+        store.add(synthetic::channel(count));
+        if (store.size() != count + 1 || strcmp(store[count].id(), synthetic::channel(count).id.c_str()) != 0) {
+            printf("FAIL: add after shrinkToFit at %zu channels\n", count);
+            failures++;
+        }
+
+        double text = (double)synthetic::textBytes(count) / count;
+        printf("%8zu %12.1f %12.1f %12.1f %12.1f %7zu\n", count, grown, fitted, text, fitted - text,
+               copy.getGenreCount());
+    }
+
+    if (failures) {
+        return 1;
+    }
+    printf("channel_store_memory: all checks passed\n");
+    return 0;
+}
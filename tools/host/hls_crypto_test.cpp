@@ -0,0 +1,235 @@
+// SegmentDecryptor on the host against mbedtls 2.28: the NIST SP 800-38A
+// CBC-AES128 vectors, PKCS#7 padding for every tail length, ciphertext
+// arriving in pieces of every size, bad keys and truncated segments, then
+// decrypt throughput. HlsKeyCache is checked against a canned HTTPClient.
+//
+//     hls_crypto_test [megabytes]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "hls_crypto.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+// NIST SP 800-38A, F.2.1 and F.2.2
+static const uint8_t NIST_KEY[16] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                                     0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+static const uint8_t NIST_IV[16] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+static const uint8_t NIST_PLAIN[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10};
+static const uint8_t NIST_CIPHER[64] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+    0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+    0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7};
+
+// CBC-encrypt plain with PKCS#7 padding, the way the packager does
+static std::vector<uint8_t> encrypt(const uint8_t key[16], const uint8_t iv[16], const std::vector<uint8_t>& plain) {
+    std::vector<uint8_t> data = plain;
+    uint8_t pad = 16 - plain.size() % 16;
+    data.insert(data.end(), pad, pad);
+
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, key, 128);
+    uint8_t chain[16];
+    memcpy(chain, iv, 16);
+    mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, data.size(), chain, data.data(), data.data());
+    mbedtls_aes_free(&aes);
+    return data;
+}
+
+// Feed the ciphertext through update() in pieces of the given sizes, as
+// the fetcher does off the socket, and collect the plaintext; returns
+// finish()'s result
+static int decrypt(SegmentDecryptor& decryptor, const std::vector<uint8_t>& cipher, size_t step,
+                   std::vector<uint8_t>& plain) {
+    std::vector<uint8_t> buf(SegmentDecryptor::HEADROOM + 4096 + 15);
+    plain.clear();
+    size_t pos = 0;
+    size_t len = step;
+    while (pos < cipher.size()) {
+        size_t n = min(min(len, cipher.size() - pos), (size_t)4096);
+        memcpy(buf.data() + SegmentDecryptor::HEADROOM, cipher.data() + pos, n);
+        size_t out = decryptor.update(buf.data(), n);
+        CHECK(out <= n + 15);
+        plain.insert(plain.end(), buf.begin(), buf.begin() + out);
+        pos += n;
+        len = len * 5 % 61 + 1;  // Uneven, so pieces end inside blocks
+    }
+    uint8_t tail[16];
+    int n = decryptor.finish(tail);
+    if (n > 0) {
+        plain.insert(plain.end(), tail, tail + n);
+    }
+    return n;
+}
+
+static void testNist() {
+    // The vectors carry no padding: the first three blocks come out as
+    // they are decrypted, and the fourth is held and rejected as padding
+    SegmentDecryptor decryptor;
+    decryptor.begin(NIST_KEY, NIST_IV);
+    std::vector<uint8_t> cipher(NIST_CIPHER, NIST_CIPHER + 64);
+    std::vector<uint8_t> plain;
+    CHECK(decrypt(decryptor, cipher, 64, plain) == -1);
+    CHECK(plain.size() == 48);
+    CHECK(memcmp(plain.data(), NIST_PLAIN, 48) == 0);
+
+    // With a padding block after them, all four come out
+    std::vector<uint8_t> padded = encrypt(NIST_KEY, NIST_IV, std::vector<uint8_t>(NIST_PLAIN, NIST_PLAIN + 64));
+    CHECK(padded.size() == 80);
+    CHECK(memcmp(padded.data(), NIST_CIPHER, 64) == 0);
+    for (size_t step = 1; step <= 80; step++) {
+        decryptor.begin(NIST_KEY, NIST_IV);
+        CHECK(decrypt(decryptor, padded, step, plain) == 0);
+        CHECK(plain.size() == 64 && memcmp(plain.data(), NIST_PLAIN, 64) == 0);
+    }
+}
+
+static void testPadding() {
+    uint8_t key[16];
+    uint8_t iv[16];
+    for (int i = 0; i < 16; i++) {
+        key[i] = i * 17 + 3;
+        iv[i] = 255 - i;
+    }
+
+    // Every tail length, including a whole padding block, and one
+    // decryptor reused across segments as the fetcher's slots are
+    SegmentDecryptor decryptor;
+    for (size_t len = 0; len <= 100; len++) {
+        std::vector<uint8_t> text(len);
+        for (size_t i = 0; i < len; i++) {
+            text[i] = (uint8_t)(i * 31 + len);
+        }
+        std::vector<uint8_t> cipher = encrypt(key, iv, text);
+        for (size_t step : {1, 7, 16, 33, 200}) {
+            decryptor.begin(key, iv);
+            std::vector<uint8_t> plain;
+            CHECK(decrypt(decryptor, cipher, step, plain) == (int)(len % 16));
+            CHECK(plain == text);
+        }
+    }
+}
+
+static void testRejects() {
+    uint8_t key[16] = {1};
+    uint8_t iv[16] = {2};
+    std::vector<uint8_t> text(40, 'x');
+    std::vector<uint8_t> cipher = encrypt(key, iv, text);
+    std::vector<uint8_t> plain;
+    SegmentDecryptor decryptor;
+
+    // A truncated segment: a partial block, or no block at all
+    std::vector<uint8_t> cut(cipher.begin(), cipher.end() - 5);
+    decryptor.begin(key, iv);
+    CHECK(decrypt(decryptor, cut, 16, plain) == -1);
+    decryptor.begin(key, iv);
+    CHECK(decrypt(decryptor, std::vector<uint8_t>(), 16, plain) == -1);
+
+    // The wrong key garbles the padding
+    uint8_t wrong[16] = {9};
+    decryptor.begin(wrong, iv);
+    CHECK(decrypt(decryptor, cipher, 16, plain) == -1);
+
+    // The wrong IV only garbles the first block, which holds no padding
+    uint8_t wrongIv[16] = {3};
+    decryptor.begin(key, wrongIv);
+    CHECK(decrypt(decryptor, cipher, 16, plain) == 8);
+    CHECK(plain.size() == 40 && std::equal(plain.begin() + 16, plain.end(), text.begin() + 16));
+}
+
+static void testKeyCache() {
+    std::string key(16, 'k');
+    HTTPClient::respond("http://host/keys/1", HTTP_CODE_OK, key);
+    HTTPClient::respond("http://host/keys/short", HTTP_CODE_OK, "short");
+    HTTPClient::respond("http://host/keys/gone", HTTP_CODE_NOT_FOUND, "");
+
+    // Fetched once, then served from the cache
+    HlsKeyCache cache;
+    size_t before = HTTPClient::getRequests();
+    const uint8_t* got = cache.get("http://host/keys/1");
+    CHECK(got && memcmp(got, key.data(), 16) == 0);
+    CHECK(cache.get("http://host/keys/1") == got);
+    CHECK(HTTPClient::getRequests() == before + 1);
+
+    CHECK(!cache.get("http://host/keys/short"));
+    CHECK(cache.getLastError().indexOf("5 bytes") >= 0);
+    CHECK(!cache.get("http://host/keys/gone"));
+    CHECK(cache.getLastError().indexOf("HTTP 404") >= 0);
+    CHECK(!cache.get("not a url"));
+
+    // Past HLS_KEY_CACHE_MAX the least recently used key goes
+    for (int i = 0; i < HLS_KEY_CACHE_MAX; i++) {
+        String uri = "http://host/keys/r" + String(i);
+        HTTPClient::respond(uri, HTTP_CODE_OK, std::string(16, 'a' + i));
+        delay(2);
+        CHECK(cache.get(uri));
+    }
+    before = HTTPClient::getRequests();
+    CHECK(cache.get("http://host/keys/r" + String(HLS_KEY_CACHE_MAX - 1)));
+    CHECK(HTTPClient::getRequests() == before);
+    CHECK(cache.get("http://host/keys/1"));
+    CHECK(HTTPClient::getRequests() == before + 1);
+}
+
+static void testThroughput(size_t total) {
+    uint8_t key[16] = {0x42};
+    uint8_t iv[16] = {0x24};
+    std::vector<uint8_t> cipher = encrypt(key, iv, std::vector<uint8_t>(1 << 20, 0x5a));
+
+    // 1 MB segments read in the fetcher's largest pieces
+    SegmentDecryptor decryptor;
+    std::vector<uint8_t> buf(SegmentDecryptor::HEADROOM + 4096 + 15);
+    size_t done = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (done < total) {
+        decryptor.begin(key, iv);
+        for (size_t pos = 0; pos < cipher.size(); pos += 4096) {
+            size_t n = min((size_t)4096, cipher.size() - pos);
+            memcpy(buf.data() + SegmentDecryptor::HEADROOM, cipher.data() + pos, n);
+            decryptor.update(buf.data(), n);
+        }
+        uint8_t tail[16];
+        CHECK(decryptor.finish(tail) == 0);
+        done += cipher.size();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("throughput: %zu MB in 4 KB reads, %.0f MB/s with copies, %.0f MB/s in update() by its own count\n",
+           done >> 20, (done / 1048576.0) / seconds, (double)decryptor.getBytes() / decryptor.getMicros());
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? strtoul(argv[1], nullptr, 10) : 64;
+    Serial.enabled = false;
+
+    testNist();
+    testPadding();
+    testRejects();
+    testKeyCache();
+    testThroughput(megabytes << 20);
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("hls_crypto: all checks passed\n");
+    return 0;
+}
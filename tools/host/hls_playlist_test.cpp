@@ -0,0 +1,117 @@
+// HlsPlaylist on the host: live join, sliding refreshes, and an encoder
+// restart that sends the media sequence back.
+
+#include <cstdio>
+#include <vector>
+#include "config.h"
+#include "hls_playlist.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+// A live media playlist of count segments from first, named by sequence
+static String livePlaylist(uint32_t first, uint32_t count) {
+    String text = "#EXTM3U\n#EXT-X-TARGETDURATION:10\n#EXT-X-MEDIA-SEQUENCE:" + String((unsigned long)first) + "\n";
+    for (uint32_t i = 0; i < count; i++) {
+        text += "#EXTINF:10.0,\nseg" + String((unsigned long)(first + i)) + ".aac\n";
+    }
+    return text;
+}
+
+static void load(HlsPlaylist& playlist, const String& text) {
+    playlist.begin("http://host/live/index.m3u8?token=1");
+    // Uneven chunks, as off a socket
+    size_t pos = 0;
+    size_t step = 7;
+    while (pos < text.length()) {
+        size_t n = min(step, (size_t)text.length() - pos);
+        playlist.feed(text.c_str() + pos, n);
+        pos += n;
+        step = step * 3 % 41 + 1;
+    }
+    playlist.end();
+}
+
+// Sequences queued by the last load, drained
+static std::vector<uint32_t> drain(HlsPlaylist& playlist) {
+    std::vector<uint32_t> sequences;
+    HlsSegment segment;
+    while (playlist.nextSegment(segment)) {
+        sequences.push_back(segment.sequence);
+        CHECK(segment.uri == "http://host/live/seg" + String((unsigned long)segment.sequence) + ".aac");
+    }
+    return sequences;
+}
+
+static bool same(const std::vector<uint32_t>& a, std::initializer_list<uint32_t> b) {
+    return a == std::vector<uint32_t>(b);
+}
+
+static void testLiveJoinAndSlide() {
+    HlsPlaylist playlist;
+    load(playlist, livePlaylist(100, 6));
+    CHECK(same(drain(playlist), {103, 104, 105}));  // Near the live edge
+
+    load(playlist, livePlaylist(100, 6));
+    CHECK(drain(playlist).empty());  // Nothing new
+
+    load(playlist, livePlaylist(102, 6));
+    CHECK(same(drain(playlist), {106, 107}));
+
+    // A shorter window that still moves forward is not a restart
+    load(playlist, livePlaylist(105, 4));
+    CHECK(same(drain(playlist), {108}));
+}
+
+static void testSequenceRestart() {
+    HlsPlaylist playlist;
+    load(playlist, livePlaylist(5000, 6));
+    CHECK(same(drain(playlist), {5003, 5004, 5005}));
+
+    // Encoder restart: numbering starts over with segments still queued
+    load(playlist, livePlaylist(5003, 6));
+    CHECK(playlist.queuedCount() == 3);
+    load(playlist, livePlaylist(0, 6));
+    CHECK(same(drain(playlist), {3, 4, 5}));
+
+    load(playlist, livePlaylist(1, 6));
+    CHECK(same(drain(playlist), {6}));
+
+    // A playlist that only lags a refresh behind is not a restart
+    load(playlist, livePlaylist(0, 6));
+    CHECK(drain(playlist).empty());
+    load(playlist, livePlaylist(2, 6));
+    CHECK(same(drain(playlist), {7}));
+}
+
+static void testSequenceIv() {
+    HlsPlaylist playlist;
+    load(playlist,
+         "#EXTM3U\n#EXT-X-MEDIA-SEQUENCE:258\n#EXT-X-KEY:METHOD=AES-128,URI=\"/keys/1\"\n#EXTINF:10,\na.aac\n"
+         "#EXT-X-ENDLIST\n");
+    HlsSegment segment;
+    CHECK(playlist.nextSegment(segment));
+    CHECK(segment.keyUri == "http://host/keys/1");
+    CHECK(segment.iv[14] == 1 && segment.iv[15] == 2);  // 258, big-endian
+}
+
+int main() {
+    Serial.enabled = false;
+    testLiveJoinAndSlide();
+    testSequenceRestart();
+    testSequenceIv();
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("hls_playlist: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+// HttpBodyStream on the host: Content-Length, close-delimited and chunked
+// bodies (with extensions and trailers), arriving in pieces of every size.
+
+#include <cstdio>
+#include <string>
+#include "http_body_stream.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+static std::string payload(size_t len) {
+    std::string text;
+    for (size_t i = 0; i < len; i++) {
+        text += (char)('a' + i % 26);
+    }
+    return text;
+}
+
+static std::string chunk(const std::string& data, const char* extension = "") {
+    char size[32];
+    snprintf(size, sizeof(size), "%zX%s\r\n", data.size(), extension);
+    return size + data + "\r\n";
+}
+
+// Read the whole body with readAvailable() in reads of at most max bytes
+static std::string readAll(HttpBodyStream& body, size_t max) {
+    std::string out;
+    uint8_t buffer[512];
+    for (int idle = 0; !body.isComplete() && idle < 1000;) {
+        int n = body.readAvailable(buffer, min(max, sizeof(buffer)));
+        if (n > 0) {
+            out.append((const char*)buffer, n);
+            idle = 0;
+        } else {
+            idle++;
+        }
+    }
+    return out;
+}
+
+static void testContentLength() {
+    std::string body = payload(1000);
+    for (size_t step : {1, 7, 100, 5000}) {
+        WiFiClient client;
+        client.load(body + "NEXT RESPONSE", step, false);  // Kept alive
+        HttpBodyStream stream;
+        stream.begin(&client, body.size(), false);
+        CHECK(readAll(stream, 333) == body);
+        CHECK(stream.isComplete());
+        CHECK(stream.getBytesRead() == body.size());
+        CHECK(client.peek() == 'N');  // Stops at the end of the body
+    }
+}
+
+static void testCloseDelimited() {
+    std::string body = payload(777);
+    WiFiClient client;
+    client.load(body, 50);
+    HttpBodyStream stream;
+    stream.begin(&client, -1, false);
+    CHECK(readAll(stream, 64) == body);
+    CHECK(stream.isComplete());
+}
+
+static void testChunked() {
+    std::string a = payload(300);
+    std::string b = payload(17);
+    std::string c = payload(4096);
+    std::string wire = chunk(a) + chunk(b, ";name=value") + chunk(c) + "0\r\nX-Trailer: 1\r\n\r\nNEXT";
+    std::string expected = a + b + c;
+
+    // Every arrival size from a byte at a time up, and reads that end
+    // inside chunk headers as well as inside data
+    for (size_t step = 1; step <= 64; step++) {
+        WiFiClient client;
+        client.load(wire, step, false);
+        HttpBodyStream stream;
+        stream.begin(&client, -1, true);
+        std::string out = readAll(stream, 1 + step * 5 % 97);
+        CHECK(out == expected);
+        CHECK(stream.isComplete());
+        CHECK(client.peek() == 'N');
+    }
+}
+
+static void testChunkedCharacters() {
+    // The channel list parser reads a byte at a time through peek/read
+    std::string wire = chunk("{\"channels\"") + chunk(": []}") + "0\r\n\r\n";
+    WiFiClient client;
+    client.load(wire, 3, false);
+    HttpBodyStream stream;
+    stream.begin(&client, -1, true);
+    std::string out;
+    for (int idle = 0; !stream.isComplete() && idle < 1000;) {
+        int c = stream.peek();
+        if (c < 0) {
+            idle++;
+            continue;
+        }
+        CHECK(stream.read() == c);
+        out += (char)c;
+    }
+    CHECK(out == "{\"channels\": []}");
+}
+
+static void testTruncated() {
+    // A connection that closes mid-body ends it rather than waiting
+    std::string wire = chunk(payload(100)) + "40\r\nshort";
+    WiFiClient client;
+    client.load(wire, 16);
+    HttpBodyStream stream;
+    stream.begin(&client, -1, true);
+    std::string out = readAll(stream, 64);
+    CHECK(out.size() == 105);
+    CHECK(stream.isComplete());
+
+    WiFiClient fixed;
+    fixed.load(payload(10), 4);
+    HttpBodyStream sized;
+    sized.begin(&fixed, 20, false);
+    CHECK(readAll(sized, 64).size() == 10);
+    CHECK(sized.isComplete());
+}
+
+int main() {
+    testContentLength();
+    testCloseDelimited();
+    testChunked();
+    testChunkedCharacters();
+    testTruncated();
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("http_body_stream: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,276 @@
+// ListView on the host, drawing into memory through shim/TFT_eSPI.h:
+// the row buffer path against drawing rows straight through a viewport,
+// pixel for pixel at scroll positions on and between row edges; row
+// buffers rendered once per item; taps, clamping and a fling. Then frame
+// times for both paths while the list scrolls.
+//
+//     list_view_test [frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include "config.h"
+#include "list_view.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+// As UIManager lays out the channel list
+const int16_t LIST_X = 10;
+const int16_t LIST_Y = 40;
+const int16_t LIST_W = SCREEN_WIDTH - 20;
+const int16_t LIST_H = 160;
+const int16_t ROW_H = 40;
+const uint16_t UNTOUCHED = 0x1234;
+
+static String label(size_t index) {
+    return String((unsigned)(index + 1)) + " - Channel " + String((unsigned)(index * 7919 % 1000));
+}
+
+static TouchEvent touch(TouchEvent::Type type, uint16_t x, uint16_t y, int16_t dy, uint32_t timeMs) {
+    return TouchEvent{type, x, y, x, y, 0, dy, timeMs};
+}
+
+// Drag the list to scroll offset target and let go without a fling
+static void scrollTo(ListView& list, int32_t target) {
+    uint16_t x = LIST_X + LIST_W / 2;
+    uint16_t y = LIST_Y + LIST_H / 2;
+    list.handleTouch(touch(TouchEvent::PRESS, x, y, 0, 0));
+    while (list.getScroll() != target) {
+        int32_t step = constrain(target - list.getScroll(), -1000, 1000);
+        int32_t before = list.getScroll();
+        list.handleTouch(touch(TouchEvent::DRAG, x, y, -step, 1));
+        if (list.getScroll() == before) {
+            break;  // Clamped
+        }
+    }
+    list.handleTouch(touch(TouchEvent::RELEASE, x, y, 0, 1000));
+}
+
+static void fill(TFT_eSprite& canvas, uint16_t color) {
+    canvas.fillRect(0, 0, canvas.width(), canvas.height(), color);
+}
+
+// The list's rectangle matches, and nothing outside it was drawn
+static bool sameList(TFT_eSprite& a, TFT_eSprite& b) {
+    for (int16_t y = 0; y < a.height(); y++) {
+        for (int16_t x = 0; x < a.width(); x++) {
+            bool inside = x >= LIST_X && x < LIST_X + LIST_W && y >= LIST_Y && y < LIST_Y + LIST_H;
+            if (inside ? a.readPixel(x, y) != b.readPixel(x, y)
+                       : a.readPixel(x, y) != UNTOUCHED || b.readPixel(x, y) != UNTOUCHED) {
+                printf("  differ at %d,%d: %04x %04x\n", x, y, a.readPixel(x, y), b.readPixel(x, y));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void testBuffersMatchDirect(TFT_eSPI& panel, TextCache& cache) {
+    ListView buffered(LIST_X, LIST_Y, LIST_W, LIST_H, ROW_H);
+    ListView direct(LIST_X, LIST_Y, LIST_W, LIST_H, ROW_H);
+    buffered.begin(&panel, true, &cache);
+    direct.begin(&panel, false, &cache);
+    TFT_eSprite a(&panel);
+    TFT_eSprite b(&panel);
+    a.createSprite(SCREEN_WIDTH, SCREEN_HEIGHT);
+    b.createSprite(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    for (size_t count : {0, 2, 4, 5, 1000}) {
+        buffered.setItems(count, label);
+        direct.setItems(count, label);
+        buffered.setSelected(3);
+        direct.setSelected(3);
+
+        // On row edges, a pixel either side, down and back up again
+        for (int32_t target : {0, 1, 39, 40, 41, 79, 100, 1234, 39839, 39840, 500, 3, 0}) {
+            scrollTo(buffered, target);
+            scrollTo(direct, target);
+            CHECK(buffered.getScroll() == direct.getScroll());
+            CHECK(buffered.getScroll() == min(target, max((int32_t)0, (int32_t)count * ROW_H - LIST_H)));
+
+            fill(a, UNTOUCHED);
+            fill(b, UNTOUCHED);
+            buffered.draw(&a, &a);
+            direct.draw(&b, nullptr);
+            if (!sameList(a, b)) {
+                printf("FAIL: %zu items at scroll %d\n", count, target);
+                failures++;
+            }
+        }
+    }
+
+    ListView::Stats stats = buffered.getStats();
+    CHECK(stats.rowsReused > 0);
+}
+
+static void testRowsRenderedOnce(TFT_eSPI& panel, TextCache& cache) {
+    ListView list(LIST_X, LIST_Y, LIST_W, LIST_H, ROW_H);
+    list.begin(&panel, true, &cache);
+    TFT_eSprite canvas(&panel);
+    canvas.createSprite(SCREEN_WIDTH, SCREEN_HEIGHT);
+    list.setItems(1000, label);
+
+    // A pixel at a time down the list: every item is rendered as it comes
+    // on and copied from its buffer after that
+    std::set<int32_t> seen;
+    for (int32_t scroll = 0; scroll <= 800; scroll++) {
+        scrollTo(list, scroll);
+        list.draw(&canvas, &canvas);
+        for (int32_t item = scroll / ROW_H; item * ROW_H < scroll + LIST_H; item++) {
+            seen.insert(item);
+        }
+    }
+    CHECK(list.getStats().rowsRendered == seen.size());
+
+    // Selecting a visible row renders that row again, and no other; the
+    // row it leaves still has its unselected buffer
+    uint32_t before = list.getStats().rowsRendered;
+    list.setSelected(22);
+    list.draw(&canvas, &canvas);
+    CHECK(list.getStats().rowsRendered == before + 1);
+    list.setSelected(21);
+    list.draw(&canvas, &canvas);
+    CHECK(list.getStats().rowsRendered == before + 2);
+
+    // New items: every visible row again
+    before = list.getStats().rowsRendered;
+    list.setItems(1000, label);
+    list.draw(&canvas, &canvas);
+    CHECK(list.getStats().rowsRendered == before + 4);  // 800 is on a row edge
+}
+
+static void testTapsAndClamping(TFT_eSPI& panel, TextCache& cache) {
+    ListView list(LIST_X, LIST_Y, LIST_W, LIST_H, ROW_H);
+    list.begin(&panel, true, &cache);
+    uint16_t x = LIST_X + 20;
+
+    auto tap = [&](uint16_t y) {
+        list.handleTouch(touch(TouchEvent::PRESS, x, y, 0, 0));
+        return list.handleTouch(touch(TouchEvent::TAP, x, y, 0, 50));
+    };
+
+    // Shorter than the list: no scrolling, taps past the end miss
+    list.setItems(3, label);
+    CHECK(list.getContentHeight() == 120);
+    scrollTo(list, 200);
+    CHECK(list.getScroll() == 0);
+    CHECK(tap(LIST_Y + 5) == 0);
+    CHECK(tap(LIST_Y + 2 * ROW_H + 39) == 2);
+    CHECK(tap(LIST_Y + 3 * ROW_H + 1) == -1);
+    CHECK(tap(LIST_Y - 1) == -1);
+    CHECK(tap(LIST_Y + LIST_H) == -1);
+
+    list.setItems(1000, label);
+    scrollTo(list, 1010);
+    CHECK(tap(LIST_Y) == 25);
+    CHECK(tap(LIST_Y + 30) == 26);
+
+    // scrollToItem shows the item at the nearer edge; fewer items clamp
+    list.scrollToItem(999);
+    CHECK(list.getScroll() == 1000 * ROW_H - LIST_H);
+    list.scrollToItem(997);
+    CHECK(list.getScroll() == 1000 * ROW_H - LIST_H);
+    list.scrollToItem(990);
+    CHECK(list.getScroll() == 990 * ROW_H);
+    list.scrollToItem(10);
+    CHECK(list.getScroll() == 10 * ROW_H);
+    list.scrollToItem(999);
+    list.setItems(10, label);
+    CHECK(list.getScroll() == 10 * ROW_H - LIST_H);
+    list.setItems(0, label);
+    CHECK(list.getScroll() == 0);
+}
+
+static void testFling(TFT_eSPI& panel, TextCache& cache) {
+    ListView list(LIST_X, LIST_Y, LIST_W, LIST_H, ROW_H);
+    list.begin(&panel, true, &cache);
+    list.setItems(1000, label);
+    uint16_t x = LIST_X + 20;
+    uint16_t y = LIST_Y + 100;
+
+    // 20 px every 10 ms upward, then let go while moving
+    list.handleTouch(touch(TouchEvent::PRESS, x, y, 0, 0));
+    for (uint32_t t = 10; t <= 50; t += 10) {
+        list.handleTouch(touch(TouchEvent::DRAG, x, y, -20, t));
+    }
+    CHECK(list.getScroll() == 100);
+    list.handleTouch(touch(TouchEvent::RELEASE, x, y, 0, 55));
+    CHECK(list.isMoving());
+
+    // Coasts on, slowing, and comes to rest on its own
+    uint32_t start = millis();
+    int32_t last = list.getScroll();
+    bool forward = true;
+    while (list.isMoving() && millis() - start < 5000) {
+        delay(16);
+        list.update();
+        forward = forward && list.getScroll() >= last;
+        last = list.getScroll();
+    }
+    CHECK(!list.isMoving());
+    CHECK(forward);
+    CHECK(list.getScroll() > 300);  // 2 px/ms decaying over 325 ms
+
+    // Touching a coasting list stops it, and that tap selects nothing
+    list.handleTouch(touch(TouchEvent::PRESS, x, y, 0, 0));
+    list.handleTouch(touch(TouchEvent::DRAG, x, y, -40, 10));
+    list.handleTouch(touch(TouchEvent::RELEASE, x, y, 0, 12));
+    CHECK(list.isMoving());
+    list.handleTouch(touch(TouchEvent::PRESS, x, y, 0, 20));
+    CHECK(list.handleTouch(touch(TouchEvent::TAP, x, y, 0, 30)) == -1);
+    CHECK(!list.isMoving());
+}
+
+// Scrolling 2 px a frame, as a slow fling does near its end
+static void measure(TFT_eSPI& panel, TextCache& cache, bool buffers, size_t frames) {
+    ListView list(LIST_X, LIST_Y, LIST_W, LIST_H, ROW_H);
+    list.begin(&panel, buffers, &cache);
+    TFT_eSprite canvas(&panel);
+    canvas.createSprite(SCREEN_WIDTH, SCREEN_HEIGHT);
+    list.setItems(1000, label);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames; i++) {
+        scrollTo(list, (int32_t)(i * 2 % 30000));
+        list.draw(&canvas, buffers ? &canvas : nullptr);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    ListView::Stats stats = list.getStats();
+    printf("%-12s %10.1f %10u %10u\n", buffers ? "row buffers" : "direct", us, stats.rowsRendered,
+           stats.rowsReused);
+}
+
+int main(int argc, char** argv) {
+    size_t frames = argc > 1 ? strtoul(argv[1], nullptr, 10) : 3000;
+    Serial.enabled = false;
+
+    TFT_eSPI panel(SCREEN_WIDTH, SCREEN_HEIGHT);
+    TextCache cache;
+    cache.begin(&panel);
+
+    testBuffersMatchDirect(panel, cache);
+    testRowsRenderedOnce(panel, cache);
+    testTapsAndClamping(panel, cache);
+    testFling(panel, cache);
+
+    printf("%-12s %10s %10s %10s\n", "path", "us/frame", "rendered", "reused");
+    measure(panel, cache, true, frames);
+    measure(panel, cache, false, frames);
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("list_view: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,192 @@
+// RingBuffer on the host: wrap, full and empty by hand, then a producer
+// and a consumer thread checking every byte that goes through.
+//
+//     ring_buffer_test [megabytes]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "ring_buffer.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+static void testCapacity() {
+    std::vector<uint8_t> storage(1000);
+    RingBuffer ring;
+    ring.attach(storage.data(), storage.size());
+    CHECK(ring.capacity() == 512);  // Rounded down to a power of two
+
+    ring.attach(storage.data(), 512);
+    CHECK(ring.capacity() == 512);
+
+    ring.attach(nullptr, 512);
+    CHECK(ring.capacity() == 0);
+    uint8_t byte = 1;
+    CHECK(ring.write(&byte, 1) == 0);
+    CHECK(ring.read(&byte, 1) == 0);
+}
+
+static void testEmptyAndFull() {
+    std::vector<uint8_t> storage(64);
+    RingBuffer ring;
+    ring.attach(storage.data(), storage.size());
+
+    uint8_t out[80];
+    CHECK(ring.available() == 0);
+    CHECK(ring.space() == 64);
+    CHECK(ring.read(out, sizeof(out)) == 0);
+    CHECK(ring.discard(10) == 0);
+
+    uint8_t in[80];
+    for (int i = 0; i < 80; i++) {
+        in[i] = i;
+    }
+    CHECK(ring.write(in, 80) == 64);  // Only what fits
+    CHECK(ring.available() == 64);
+    CHECK(ring.space() == 0);
+    CHECK(ring.write(in, 1) == 0);
+
+    CHECK(ring.read(out, 80) == 64);
+    for (int i = 0; i < 64; i++) {
+        CHECK(out[i] == i);
+    }
+    CHECK(ring.available() == 0);
+    CHECK(ring.space() == 64);
+}
+
+static void testWrap() {
+    std::vector<uint8_t> storage(64);
+    RingBuffer ring;
+    ring.attach(storage.data(), storage.size());
+
+    // Every start offset, and every length up to full, across the end
+    uint8_t in[64];
+    uint8_t out[64];
+    uint8_t next = 0;
+    for (int start = 0; start < 64; start++) {
+        for (size_t len = 1; len <= 64; len++) {
+            ring.clear();
+            uint8_t pad[64] = {0};
+            CHECK(ring.write(pad, start) == (size_t)start);
+            CHECK(ring.discard(start) == (size_t)start);
+
+            for (size_t i = 0; i < len; i++) {
+                in[i] = next++;
+            }
+            CHECK(ring.write(in, len) == len);
+            CHECK(ring.available() == len);
+            CHECK(ring.space() == 64 - len);
+            CHECK(ring.read(out, len) == len);
+            CHECK(memcmp(in, out, len) == 0);
+            CHECK(ring.available() == 0);
+        }
+    }
+}
+
+static void testDiscardAndClear() {
+    std::vector<uint8_t> storage(16);
+    RingBuffer ring;
+    ring.attach(storage.data(), storage.size());
+
+    uint8_t in[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    ring.write(in, 12);
+    CHECK(ring.discard(5) == 5);
+    uint8_t out;
+    CHECK(ring.read(&out, 1) == 1 && out == 6);
+    CHECK(ring.discard(100) == 6);  // Only what is there
+    CHECK(ring.available() == 0);
+
+    ring.write(in, 12);
+    ring.clear();
+    CHECK(ring.available() == 0);
+    CHECK(ring.space() == 16);
+    CHECK(ring.write(in, 12) == 12);
+    CHECK(ring.read(&out, 1) == 1 && out == 1);
+}
+
+// Uneven chunk sizes on both sides, so the two threads meet at every
+// offset; every byte is a running counter the consumer checks
+static void testThreads(size_t total) {
+    std::vector<uint8_t> storage(4096);
+    RingBuffer ring;
+    ring.attach(storage.data(), storage.size());
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        uint8_t chunk[1500];
+        size_t sent = 0;
+        uint32_t seed = 1;
+        while (sent < total) {
+            seed = seed * 1103515245u + 12345u;
+            size_t len = 1 + (seed >> 16) % sizeof(chunk);
+            if (len > total - sent) {
+                len = total - sent;
+            }
+            for (size_t i = 0; i < len; i++) {
+                chunk[i] = (uint8_t)((sent + i) % 251);
+            }
+            size_t done = 0;
+            while (done < len) {
+                size_t n = ring.write(chunk + done, len - done);
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+                done += n;
+            }
+            sent += len;
+        }
+    });
+
+    uint8_t chunk[1100];
+    size_t received = 0;
+    size_t bad = 0;
+    uint32_t seed = 7;
+    while (received < total) {
+        seed = seed * 1103515245u + 12345u;
+        size_t n = ring.read(chunk, 1 + (seed >> 16) % sizeof(chunk));
+        if (n == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (chunk[i] != (uint8_t)((received + i) % 251)) {
+                bad++;
+            }
+        }
+        received += n;
+    }
+    producer.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    CHECK(bad == 0);
+    CHECK(ring.available() == 0);
+    printf("threads: %zu MB through a %zu byte ring, %zu bad bytes, %.0f MB/s\n", total >> 20, ring.capacity(), bad,
+           (total / 1048576.0) / seconds);
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? strtoul(argv[1], nullptr, 10) : 64;
+
+    testCapacity();
+    testEmptyAndFull();
+    testWrap();
+    testDiscardAndClear();
+    testThreads(megabytes << 20);
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("ring_buffer: all checks passed\n");
+    return 0;
+}
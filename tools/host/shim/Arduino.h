@@ -0,0 +1,213 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Just enough of the Arduino core for firmware sources that only use
+// String, timing and Serial. Host builds only: see tools/host.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using std::max;
+using std::min;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline uint32_t micros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+inline uint32_t millis() {
+    return micros() / 1000;
+}
+
+inline void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline bool psramFound() {
+    return true;
+}
+
+class String {
+public:
+    String() {}
+    String(const char* s) : s(s ? s : "") {}
+    String(const std::string& s) : s(s) {}
+    String(char c) : s(1, c) {}
+    String(int value) : s(std::to_string(value)) {}
+    String(unsigned int value) : s(std::to_string(value)) {}
+    String(long value) : s(std::to_string(value)) {}
+    String(unsigned long value) : s(std::to_string(value)) {}
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.size(); }
+    bool reserve(unsigned int size) {
+        s.reserve(size);
+        return true;
+    }
+    bool isEmpty() const { return s.empty(); }
+
+    char operator[](unsigned int index) const { return index < s.size() ? s[index] : 0; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+
+    String& operator+=(const String& other) {
+        s += other.s;
+        return *this;
+    }
+    String& operator+=(const char* other) {
+        s += other;
+        return *this;
+    }
+    String& operator+=(char c) {
+        s += c;
+        return *this;
+    }
+    bool concat(const String& other) {
+        s += other.s;
+        return true;
+    }
+
+    bool equals(const String& other) const { return s == other.s; }
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return found(s.find(c, from)); }
+    int indexOf(const String& str, unsigned int from = 0) const { return found(s.find(str.s, from)); }
+    int lastIndexOf(char c) const { return found(s.rfind(c)); }
+
+    String substring(unsigned int from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) {
+            std::swap(from, to);
+        }
+        return from < s.size() ? String(s.substr(from, to - from)) : String();
+    }
+
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+
+    void trim() {
+        size_t first = s.find_first_not_of(" \t\r\n");
+        size_t last = s.find_last_not_of(" \t\r\n");
+        s = first == std::string::npos ? "" : s.substr(first, last - first + 1);
+    }
+    void toLowerCase() {
+        for (auto& c : s) {
+            c = tolower((unsigned char)c);
+        }
+    }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend bool operator==(const String& a, const String& b) { return a.s == b.s; }
+    friend bool operator!=(const String& a, const String& b) { return a.s != b.s; }
+    friend bool operator<(const String& a, const String& b) { return a.s < b.s; }
+
+private:
+    std::string s;
+
+    static int found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+};
+
+class Stream {
+public:
+    virtual ~Stream() {}
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (n < size && write(buffer[n])) {
+            n++;
+        }
+        return n;
+    }
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+
+    size_t readBytes(uint8_t* buffer, size_t length) {
+        size_t n = 0;
+        while (n < length) {
+            int c = timedRead();
+            if (c < 0) {
+                break;
+            }
+            buffer[n++] = (uint8_t)c;
+        }
+        return n;
+    }
+
+    bool find(const char* target) {
+        size_t len = strlen(target);
+        size_t matched = 0;
+        while (matched < len) {
+            int c = timedRead();
+            if (c < 0) {
+                return false;
+            }
+            matched = c == target[matched] ? matched + 1 : (c == target[0] ? 1 : 0);
+        }
+        return true;
+    }
+
+protected:
+    unsigned long _timeout = 1000;
+
+    int timedRead() {
+        uint32_t start = millis();
+        do {
+            int c = read();
+            if (c >= 0) {
+                return c;
+            }
+        } while (millis() - start < _timeout);
+        return -1;
+    }
+};
+
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    int printf(const char* format, ...) {
+        if (!enabled) {
+            return 0;
+        }
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        return n;
+    }
+    void print(const String& text) {
+        if (enabled) {
+            fputs(text.c_str(), stdout);
+        }
+    }
+    void println(const String& text = String()) {
+        if (enabled) {
+            puts(text.c_str());
+        }
+    }
+
+    // Benchmarks turn the firmware's own logging off while they time it
+    bool enabled = true;
+};
+
+inline HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
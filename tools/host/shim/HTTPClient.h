@@ -0,0 +1,53 @@
+#ifndef HOST_HTTP_CLIENT_H
+#define HOST_HTTP_CLIENT_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include "WiFiClient.h"
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_NOT_FOUND 404
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+
+// An HTTPClient that answers from responses the test sets up, shared by
+// every instance; any other URL is refused. getRequests() counts the GETs.
+class HTTPClient {
+public:
+    HTTPClient() : size(-1) {}
+
+    static void respond(const String& url, int code, const std::string& body) {
+        responses[url.c_str()] = {code, body};
+    }
+    static size_t getRequests() { return requests; }
+
+    void setReuse(bool) {}
+    void setTimeout(uint16_t) {}
+    bool begin(const String& url) {
+        this->url = url.c_str();
+        return url.startsWith("http://") || url.startsWith("https://");
+    }
+    int GET() {
+        requests++;
+        auto it = responses.find(url);
+        if (it == responses.end()) {
+            size = -1;
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        client.load(it->second.second, SIZE_MAX, false);
+        size = (int)it->second.second.size();
+        return it->second.first;
+    }
+    int getSize() { return size; }
+    WiFiClient* getStreamPtr() { return &client; }
+    void end() {}
+
+private:
+    inline static std::map<std::string, std::pair<int, std::string>> responses;
+    inline static size_t requests = 0;
+    std::string url;
+    WiFiClient client;
+    int size;
+};
+
+#endif // HOST_HTTP_CLIENT_H
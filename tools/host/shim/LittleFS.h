@@ -0,0 +1,55 @@
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+// A filesystem with nothing on it, so every open fails, until setRoot()
+// points it at a host directory standing in for the data/ image
+
+#include <Arduino.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+class File {
+public:
+    File() {}
+    explicit File(FILE* f) : file(f, fclose) {}
+
+    explicit operator bool() const { return (bool)file; }
+    size_t size() {
+        if (!file) {
+            return 0;
+        }
+        long at = ftell(file.get());
+        fseek(file.get(), 0, SEEK_END);
+        long end = ftell(file.get());
+        fseek(file.get(), at, SEEK_SET);
+        return end;
+    }
+    size_t read(uint8_t* buf, size_t len) { return file ? fread(buf, 1, len, file.get()) : 0; }
+    void close() { file.reset(); }
+
+private:
+    std::shared_ptr<FILE> file;
+};
+
+class HostLittleFS {
+public:
+    void setRoot(const char* dir) { root = dir ? dir : ""; }
+
+    bool begin(bool = false) { return true; }
+    bool exists(const char* path) { return (bool)open(path); }
+    File open(const char* path, const char* mode = "r") {
+        if (root.empty()) {
+            return File();
+        }
+        FILE* f = fopen((root + path).c_str(), mode[0] == 'r' ? "rb" : "wb");
+        return f ? File(f) : File();
+    }
+
+private:
+    std::string root;
+};
+
+inline HostLittleFS LittleFS;
+
+#endif // HOST_LITTLEFS_H
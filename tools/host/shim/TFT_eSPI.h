@@ -0,0 +1,287 @@
+#ifndef HOST_TFT_ESPI_H
+#define HOST_TFT_ESPI_H
+
+// TFT_eSPI and TFT_eSprite drawing into RGB565 memory instead of a panel,
+// for checking what the UI puts where. Text is a stand-in 6x8 cell per
+// character, scaled by the text size, with a pattern taken from the
+// character, so different strings give different pixels. With a .vlw font
+// loaded, glyphs are alpha-blended from it as the library does. Clipping
+// follows the library: to the viewport when one is set, and always to the
+// surface.
+
+#include <Arduino.h>
+#include <algorithm>
+#include <vector>
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define MC_DATUM 4
+#define MR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+
+#define PSRAM_ENABLE 3
+
+class TFT_eSPI {
+public:
+    struct Stats {
+        uint32_t pixels;  // Written by fills, images and text
+        uint32_t calls;
+    };
+
+    TFT_eSPI(int16_t w = 320, int16_t h = 240) : _width(w), _height(h), stats{0, 0} {
+        pixels.assign((size_t)w * h, 0);
+        resetViewport();
+    }
+    virtual ~TFT_eSPI() {}
+
+    int16_t width() { return _width; }
+    int16_t height() { return _height; }
+
+    void setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum = true) {
+        originX = vpDatum ? x : 0;
+        originY = vpDatum ? y : 0;
+        clipLeft = max(x, (int32_t)0);
+        clipTop = max(y, (int32_t)0);
+        clipRight = min(x + w, (int32_t)_width);
+        clipBottom = min(y + h, (int32_t)_height);
+    }
+    void resetViewport() {
+        originX = originY = 0;
+        clipLeft = clipTop = 0;
+        clipRight = _width;
+        clipBottom = _height;
+    }
+
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+        stats.calls++;
+        for (int32_t py = y; py < y + h; py++) {
+            for (int32_t px = x; px < x + w; px++) {
+                plot(px, py, color);
+            }
+        }
+    }
+
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+        stats.calls++;
+        for (int32_t py = y; py < y + h; py++) {
+            for (int32_t px = x; px < x + w; px++) {
+                // Corners outside the radius stay as they were
+                int32_t cx = px < x + r ? x + r - px : (px >= x + w - r ? px - (x + w - r - 1) : 0);
+                int32_t cy = py < y + r ? y + r - py : (py >= y + h - r ? py - (y + h - r - 1) : 0);
+                if (cx * cx + cy * cy <= r * r) {
+                    plot(px, py, color);
+                }
+            }
+        }
+    }
+
+    // Clipped, then a copy per line, as a 16-bit sprite does it
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data) {
+        stats.calls++;
+        int32_t left = max(x + originX, clipLeft);
+        int32_t top = max(y + originY, clipTop);
+        int32_t right = min(x + originX + w, clipRight);
+        int32_t bottom = min(y + originY + h, clipBottom);
+        for (int32_t py = top; py < bottom; py++) {
+            const uint16_t* src = data + (py - y - originY) * w + (left - x - originX);
+            std::copy(src, src + (right - left), &pixels[py * _width + left]);
+        }
+        if (right > left && bottom > top) {
+            stats.pixels += (right - left) * (bottom - top);
+        }
+    }
+
+    void setTextColor(uint16_t fg) { textFg = textBg = fg; }
+    void setTextColor(uint16_t fg, uint16_t bg) {
+        textFg = fg;
+        textBg = bg;
+    }
+    void setTextSize(uint8_t size) { textSize = max((uint8_t)1, size); }
+    void setTextDatum(uint8_t datum) { textDatum = datum; }
+    void setTextFont(uint8_t) {}
+    void setTextWrap(bool, bool = false) {}
+    void loadFont(const uint8_t* data) {
+        // Big-endian header, then a 28-byte record per glyph, then bitmaps
+        auto word = [&](size_t at) {
+            const uint8_t* p = data + at;
+            return (int32_t)((uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]);
+        };
+        size_t count = word(0);
+        maxAscent = word(16);
+        maxDescent = word(20);
+        const uint8_t* bitmap = data + 24 + count * 28;
+        glyphs.clear();
+        for (size_t i = 0; i < count; i++) {
+            size_t at = 24 + i * 28;
+            Glyph g{(uint32_t)word(at), (int16_t)word(at + 4), (int16_t)word(at + 8), (int16_t)word(at + 12),
+                    (int16_t)word(at + 16), (int16_t)word(at + 20), bitmap};
+            bitmap += g.height * g.width;
+            maxAscent = max(maxAscent, (int32_t)g.dY);
+            maxDescent = max(maxDescent, (int32_t)(g.height - g.dY));
+            glyphs.push_back(g);
+        }
+    }
+    void unloadFont() { glyphs.clear(); }
+
+    int16_t textWidth(const String& text) {
+        if (glyphs.empty()) {
+            return text.length() * 6 * textSize;
+        }
+        int16_t w = 0;
+        for (size_t i = 0; i < text.length(); i++) {
+            const Glyph* g = glyph(text[i]);
+            // The last glyph counts its ink if that reaches past its advance
+            bool last = i + 1 == text.length();
+            w += !g ? fontHeight() / 4 : (last && g->dX + g->width > g->xAdvance ? g->dX + g->width : g->xAdvance);
+        }
+        return w;
+    }
+    int16_t fontHeight() { return glyphs.empty() ? 8 * textSize : maxAscent + maxDescent; }
+
+    int16_t drawString(const String& text, int32_t x, int32_t y) {
+        stats.calls++;
+        int32_t w = textWidth(text);
+        int32_t h = fontHeight();
+        uint8_t across = textDatum % 3;
+        uint8_t down = min(textDatum / 3, 2);
+        x -= across == 1 ? w / 2 : (across == 2 ? w : 0);
+        y -= down == 1 ? h / 2 : (down == 2 ? h : 0);
+
+        if (!glyphs.empty()) {
+            drawGlyphs(text, x, y);
+            return w;
+        }
+        for (size_t i = 0; i < text.length(); i++) {
+            uint32_t bits = (uint8_t)text[i] * 2654435761u;
+            for (int32_t py = 0; py < h; py++) {
+                for (int32_t px = 0; px < 6 * textSize; px++) {
+                    bool on = (bits >> ((py / textSize) * 6 + px / textSize) % 32) & 1;
+                    if (on || textBg != textFg) {
+                        plot(x + i * 6 * textSize + px, y + py, on ? textFg : textBg);
+                    }
+                }
+            }
+        }
+        return w;
+    }
+
+    uint16_t readPixel(int32_t x, int32_t y) {
+        return x >= 0 && y >= 0 && x < _width && y < _height ? pixels[y * _width + x] : 0;
+    }
+    Stats getStats() { return stats; }
+
+protected:
+    int16_t _width;
+    int16_t _height;
+    std::vector<uint16_t> pixels;
+    Stats stats;
+
+    void resize(int16_t w, int16_t h) {
+        _width = w;
+        _height = h;
+        pixels.assign((size_t)w * h, 0);
+        resetViewport();
+    }
+
+private:
+    int32_t originX, originY;
+    int32_t clipLeft, clipTop, clipRight, clipBottom;
+    uint16_t textFg = 0xFFFF;
+    uint16_t textBg = 0xFFFF;
+    uint8_t textSize = 1;
+    uint8_t textDatum = TL_DATUM;
+
+    struct Glyph {
+        uint32_t code;
+        int16_t height;
+        int16_t width;
+        int16_t xAdvance;
+        int16_t dY;  // Top above the baseline
+        int16_t dX;
+        const uint8_t* bitmap;
+    };
+    std::vector<Glyph> glyphs;
+    int32_t maxAscent = 0;
+    int32_t maxDescent = 0;
+
+    const Glyph* glyph(char c) {
+        for (const Glyph& g : glyphs) {
+            if (g.code == (uint8_t)c) {
+                return &g;
+            }
+        }
+        return nullptr;
+    }
+
+    // The library's blend, on 6-bit channels
+    static uint16_t alphaBlend(uint8_t alpha, uint16_t fg, uint16_t bg) {
+        uint16_t fgR = ((fg >> 10) & 0x3E) + 1, fgG = ((fg >> 4) & 0x7E) + 1, fgB = ((fg << 1) & 0x3E) + 1;
+        uint16_t bgR = ((bg >> 10) & 0x3E) + 1, bgG = ((bg >> 4) & 0x7E) + 1, bgB = ((bg << 1) & 0x3E) + 1;
+        uint16_t r = (fgR * alpha + bgR * (255 - alpha)) >> 9;
+        uint16_t g = (fgG * alpha + bgG * (255 - alpha)) >> 9;
+        uint16_t b = (fgB * alpha + bgB * (255 - alpha)) >> 9;
+        return (r << 11) | (g << 5) | b;
+    }
+
+    // Glyph ink only; edges blend into the text background, or into what
+    // is already there when it matches the foreground
+    void drawGlyphs(const String& text, int32_t x, int32_t y) {
+        for (size_t i = 0; i < text.length(); i++) {
+            const Glyph* g = glyph(text[i]);
+            if (!g) {
+                x += fontHeight() / 4;
+                continue;
+            }
+            int32_t left = x + g->dX;
+            int32_t top = y + maxAscent - g->dY;
+            for (int32_t py = 0; py < g->height; py++) {
+                for (int32_t px = 0; px < g->width; px++) {
+                    uint8_t alpha = g->bitmap[py * g->width + px];
+                    if (alpha == 0xFF) {
+                        plot(left + px, top + py, textFg);
+                    } else if (alpha) {
+                        uint16_t bg = textBg != textFg ? textBg : readPixel(left + px + originX, top + py + originY);
+                        plot(left + px, top + py, alphaBlend(alpha, textFg, bg));
+                    }
+                }
+            }
+            x += g->xAdvance;
+        }
+    }
+
+    void plot(int32_t x, int32_t y, uint32_t color) {
+        x += originX;
+        y += originY;
+        if (x >= clipLeft && x < clipRight && y >= clipTop && y < clipBottom) {
+            pixels[y * _width + x] = (uint16_t)color;
+            stats.pixels++;
+        }
+    }
+};
+
+class TFT_eSprite : public TFT_eSPI {
+public:
+    explicit TFT_eSprite(TFT_eSPI*) : TFT_eSPI(0, 0), created(false) {}
+
+    void setAttribute(uint8_t, uint8_t) {}
+    void* setColorDepth(int8_t) { return nullptr; }
+    void* createSprite(int16_t w, int16_t h) {
+        resize(w, h);
+        created = true;
+        return pixels.data();
+    }
+    void deleteSprite() {
+        resize(0, 0);
+        created = false;
+    }
+    void* getPointer() { return created ? pixels.data() : nullptr; }
+
+private:
+    bool created;
+};
+
+#endif // HOST_TFT_ESPI_H
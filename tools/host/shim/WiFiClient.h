@@ -0,0 +1,44 @@
+#ifndef HOST_WIFI_CLIENT_H
+#define HOST_WIFI_CLIENT_H
+
+#include <Arduino.h>
+#include <string>
+
+// A connection that replays a response from memory. At most `step` bytes
+// are available at a time, so readers see the body arrive in pieces, and
+// the peer closes once everything has been read.
+class WiFiClient : public Stream {
+public:
+    WiFiClient() : pos(0), step(SIZE_MAX), open(false) {}
+
+    void load(const std::string& bytes, size_t step = SIZE_MAX, bool closeAtEnd = true) {
+        data = bytes;
+        pos = 0;
+        this->step = step;
+        open = true;
+        this->closeAtEnd = closeAtEnd;
+    }
+
+    int available() override { return (int)min(step, data.size() - pos); }
+    int read() override { return pos < data.size() ? (uint8_t)data[pos++] : -1; }
+    int read(uint8_t* buffer, size_t size) {
+        size_t n = min(size, (size_t)available());
+        memcpy(buffer, data.data() + pos, n);
+        pos += n;
+        return (int)n;
+    }
+    int peek() override { return pos < data.size() ? (uint8_t)data[pos] : -1; }
+    size_t write(uint8_t) override { return 0; }
+
+    uint8_t connected() { return open && (pos < data.size() || !closeAtEnd); }
+    void stop() { open = false; }
+
+private:
+    std::string data;
+    size_t pos;
+    size_t step;
+    bool open;
+    bool closeAtEnd = true;
+};
+
+#endif // HOST_WIFI_CLIENT_H
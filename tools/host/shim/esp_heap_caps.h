@@ -0,0 +1,19 @@
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <cstdint>
+#include <cstdlib>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+inline void* heap_caps_malloc(size_t size, uint32_t) {
+    return malloc(size);
+}
+
+inline void* heap_caps_realloc(void* ptr, size_t size, uint32_t) {
+    return realloc(ptr, size);
+}
+
+#endif // HOST_ESP_HEAP_CAPS_H
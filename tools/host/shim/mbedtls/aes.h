@@ -0,0 +1,31 @@
+#ifndef HOST_MBEDTLS_AES_H
+#define HOST_MBEDTLS_AES_H
+
+// The part of mbedtls 2.28's aes.h the firmware uses, for hosts that have
+// the library (libmbedcrypto.so.7, the ESP-IDF 4.4 version) but not its
+// headers. The context layout is 2.28's.
+
+#include <cstddef>
+#include <cstdint>
+
+#define MBEDTLS_AES_ENCRYPT 1
+#define MBEDTLS_AES_DECRYPT 0
+
+extern "C" {
+
+typedef struct mbedtls_aes_context {
+    int nr;
+    uint32_t* rk;
+    uint32_t buf[68];
+} mbedtls_aes_context;
+
+void mbedtls_aes_init(mbedtls_aes_context* ctx);
+void mbedtls_aes_free(mbedtls_aes_context* ctx);
+int mbedtls_aes_setkey_enc(mbedtls_aes_context* ctx, const unsigned char* key, unsigned int keybits);
+int mbedtls_aes_setkey_dec(mbedtls_aes_context* ctx, const unsigned char* key, unsigned int keybits);
+int mbedtls_aes_crypt_cbc(mbedtls_aes_context* ctx, int mode, size_t length, unsigned char iv[16],
+                          const unsigned char* input, unsigned char* output);
+
+}
+
+#endif // HOST_MBEDTLS_AES_H
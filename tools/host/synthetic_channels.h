@@ -0,0 +1,79 @@
+#ifndef HOST_SYNTHETIC_CHANNELS_H
+#define HOST_SYNTHETIC_CHANNELS_H
+
+// Deterministic line-ups shaped like the server's channel list: two or
+// three word names from a shared vocabulary, a few dozen genres, ids
+// derived from the name and long logo URLs. Stream URLs are empty, as
+// they are until a channel is played in server mode.
+
+#include <cstdio>
+#include "channel_store.h"
+
+namespace synthetic {
+
+const char* const WORDS[] = {
+    "Hits", "Classic", "Vinyl", "Highway", "Octane", "Pulse", "Soul", "Town", "Coffee", "House",
+    "Watercolors", "Nation", "Radio", "Rock", "Jazz", "Blues", "Country", "Legends", "Underground", "Garage",
+    "Lithium", "Alt", "Boulevard", "Spectrum", "Deep", "Tracks", "Yacht", "Rocks", "Hair", "Bridge",
+    "Outlaw", "Prime", "Bluegrass", "Junction", "Love", "Velvet", "Symphony", "Hall", "Opera", "Pops",
+    "Comedy", "Central", "Laugh", "Factory", "Sports", "Talk", "Fan", "Zone", "News", "Channel",
+    "Electric", "Area", "Chill", "Diplo", "Revolution", "Loud", "Heavy", "Turbo", "Liquid", "Metal",
+    "Reggae", "Rhythm", "Gospel", "Praise"};
+const size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+const char* const GENRES[] = {
+    "Pop", "Rock", "Hip-Hop/R&B", "Dance/Electronic", "Country", "Christian", "Jazz/Standards",
+    "Classical", "Latin", "Comedy", "Sports", "News/Public Radio", "Politics", "Entertainment",
+    "Howard Stern", "Religion", "Kids", "Canadian", "Traffic/Weather", "Decades", "Metal",
+    "Folk/Americana", "Blues", "Soul", "Reggae", "World", "Holiday", "Family", "Talk", "Podcasts"};
+const size_t GENRE_COUNT = sizeof(GENRES) / sizeof(GENRES[0]);
+
+inline uint32_t mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    return x ^ (x >> 16);
+}
+
+// Channel i of a line-up; numbers run from 1 and ids are unique
+inline SXMChannel channel(size_t i) {
+    uint32_t h = mix(i + 1);
+    SXMChannel ch;
+    ch.name = String(WORDS[h % WORD_COUNT]) + " " + WORDS[(h >> 8) % WORD_COUNT];
+    if ((h >> 16) % 3 == 0) {
+        ch.name += String(" ") + WORDS[(h >> 20) % WORD_COUNT];
+    }
+
+    char id[48];
+    snprintf(id, sizeof(id), "%s%u", WORDS[h % WORD_COUNT], (unsigned)(i + 1));
+    for (char* p = id; *p; p++) {
+        *p = tolower(*p);
+    }
+    ch.id = id;
+
+    ch.number = String((unsigned)(i + 1));
+    ch.genre = GENRES[(h >> 4) % GENRE_COUNT];
+
+    char logo[96];
+    snprintf(logo, sizeof(logo), "https://pri.art.prod.streaming.siriusxm.com/images/chan/%08x%04x.png",
+             (unsigned)h, (unsigned)(i & 0xFFFF));
+    ch.logoUrl = logo;
+    return ch;
+}
+
+// Sum of the strings a line-up of count channels carries, NULs included
+inline size_t textBytes(size_t count) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        SXMChannel ch = channel(i);
+        for (const String* field : {&ch.id, &ch.name, &ch.number, &ch.genre, &ch.logoUrl, &ch.streamUrl}) {
+            bytes += field->length() + 1;
+        }
+    }
+    return bytes;
+}
+
+}  // namespace synthetic
+
+#endif // HOST_SYNTHETIC_CHANNELS_H
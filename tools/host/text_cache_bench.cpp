@@ -0,0 +1,210 @@
+// TextCache on the host, drawing into memory through shim/TFT_eSPI.h:
+// cached strings against drawString straight into the frame, pixel for
+// pixel at every datum, then frame times for the search screen's text
+// (header, query, result rows and the keyboard) both ways. Once with the
+// built-in font, once with the fonts in data/fonts, which the shim blends
+// glyph by glyph as TFT_eSPI does.
+//
+// Host times only show the ratio; on the device the periodic UI log line
+// gives the average time per hit and per miss.
+//
+//     text_cache_bench [frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <LittleFS.h>
+#include <vector>
+#include "config.h"
+#include "text_cache.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+struct Text {
+    String text;
+    int16_t x;
+    int16_t y;
+    uint8_t size;
+    uint8_t datum;
+    uint16_t fg;
+    uint16_t bg;
+};
+
+// As UIManager lays out the search screen
+static std::vector<Text> searchScreen() {
+    std::vector<Text> texts;
+    texts.push_back({"Search", SCREEN_WIDTH / 2, 15, 2, MC_DATUM, COLOR_WHITE, COLOR_PRIMARY});
+    texts.push_back({"classic", 16, 47, 2, ML_DATUM, COLOR_WHITE, COLOR_DARKGRAY});
+    const char* results[] = {"25 - Classic Rewind", "26 - Classic Vinyl", "76 - Symphony Hall", "34 - Lithium"};
+    for (int i = 0; i < 4; i++) {
+        texts.push_back({results[i], 20, (int16_t)(64 + i * 26 + 13), 2, ML_DATUM, COLOR_WHITE, COLOR_DARKGRAY});
+    }
+    texts.push_back({"+12 more", SCREEN_WIDTH - 12, 164, 1, MR_DATUM, COLOR_LIGHTGRAY, COLOR_BG});
+
+    const char* rows[] = {"1234567890", "qwertyuiop", "asdfghjkl", "zxcvbnm"};
+    for (int row = 0; row < 4; row++) {
+        int len = strlen(rows[row]);
+        int startX = (SCREEN_WIDTH - len * 28) / 2;
+        for (int col = 0; col < len; col++) {
+            char c[2] = {rows[row][col], '\0'};
+            texts.push_back({c, (int16_t)(startX + col * 28 + 13), (int16_t)(170 + row * 24 + 11), 1, MC_DATUM,
+                             COLOR_WHITE, COLOR_DARKGRAY});
+        }
+    }
+    texts.push_back({"SPACE", 160, 277, 1, MC_DATUM, COLOR_WHITE, COLOR_DARKGRAY});
+    texts.push_back({"<-", 40, 277, 1, MC_DATUM, COLOR_WHITE, COLOR_RED});
+    return texts;
+}
+
+// What TextCache::draw does without a cache, on the background it blends into
+static void drawDirect(TFT_eSPI* target, const Text& t) {
+    target->setTextColor(t.fg, t.bg);
+    target->setTextSize(t.size);
+    target->setTextDatum(t.datum);
+    target->drawString(t.text, t.x, t.y);
+}
+
+static bool same(TFT_eSprite& a, TFT_eSprite& b) {
+    for (int16_t y = 0; y < a.height(); y++) {
+        for (int16_t x = 0; x < a.width(); x++) {
+            if (a.readPixel(x, y) != b.readPixel(x, y)) {
+                printf("  differ at %d,%d: %04x %04x\n", x, y, a.readPixel(x, y), b.readPixel(x, y));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Frames to draw into directly, one per text size with its font loaded
+struct DirectFrames {
+    std::vector<uint8_t> fonts[3];
+    TFT_eSprite* frames[3];
+
+    DirectFrames(TFT_eSPI& panel, bool smooth) {
+        const char* paths[] = {UI_FONT_SMALL_PATH, UI_FONT_MEDIUM_PATH, UI_FONT_LARGE_PATH};
+        for (int i = 0; i < 3; i++) {
+            frames[i] = new TFT_eSprite(&panel);
+            frames[i]->createSprite(SCREEN_WIDTH, SCREEN_HEIGHT);
+            File file = LittleFS.open(paths[i]);
+            if (smooth && file) {
+                fonts[i].resize(file.size());
+                file.read(fonts[i].data(), fonts[i].size());
+                frames[i]->loadFont(fonts[i].data());
+            }
+        }
+    }
+    ~DirectFrames() {
+        for (TFT_eSprite* frame : frames) {
+            delete frame;
+        }
+    }
+    TFT_eSprite& operator[](uint8_t size) { return *frames[size - 1]; }
+};
+
+static void testMatchesDirect(TFT_eSPI& panel, TextCache& cache, DirectFrames& direct) {
+    TFT_eSprite a(&panel);
+    a.createSprite(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    // Every datum and size, near the edges too, drawn twice: the second
+    // time from the cache
+    for (uint8_t datum = TL_DATUM; datum <= BR_DATUM; datum++) {
+        for (uint8_t size = 1; size <= 3; size++) {
+            for (int16_t x : {0, 3, SCREEN_WIDTH / 2, SCREEN_WIDTH - 2}) {
+                Text t{"Hits 42", x, (int16_t)(SCREEN_HEIGHT / 2), size, datum, COLOR_WHITE, COLOR_DARKGRAY};
+                TFT_eSprite& b = direct[size];
+                for (int pass = 0; pass < 2; pass++) {
+                    // On its own background, as the UI draws text
+                    a.fillRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, t.bg);
+                    b.fillRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, t.bg);
+                    cache.draw(&panel, &a, t.text, t.x, t.y, t.size, t.datum, t.fg, t.bg);
+                    drawDirect(&b, t);
+                    if (!same(a, b)) {
+                        printf("FAIL: datum %u size %u x %d pass %d\n", datum, size, x, pass);
+                        failures++;
+                    }
+                }
+            }
+        }
+    }
+
+    // Another color pair is another string
+    TextCache::Stats before = cache.getStats();
+    cache.draw(&panel, &a, "Hits 42", 0, 0, 1, TL_DATUM, COLOR_WHITE, COLOR_RED);
+    cache.draw(&panel, &a, "Hits 42", 0, 0, 1, TL_DATUM, COLOR_WHITE, COLOR_RED);
+    TextCache::Stats after = cache.getStats();
+    CHECK(after.misses == before.misses + 1);
+    CHECK(after.hits == before.hits + 1);
+}
+
+static double measure(TFT_eSPI& panel, TextCache* cache, DirectFrames& direct, const std::vector<Text>& texts,
+                      size_t frames) {
+    TFT_eSprite canvas(&panel);
+    canvas.createSprite(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames; i++) {
+        for (const Text& t : texts) {
+            if (cache) {
+                cache->draw(&panel, &canvas, t.text, t.x, t.y, t.size, t.datum, t.fg, t.bg);
+            } else {
+                drawDirect(&direct[t.size], t);
+            }
+        }
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+static void run(TFT_eSPI& panel, bool smooth, size_t frames) {
+    LittleFS.setRoot(smooth ? DATA_DIR : nullptr);
+    DirectFrames direct(panel, smooth);
+
+    TextCache check;
+    check.begin(&panel);
+    for (uint8_t size = 1; size <= 3; size++) {
+        CHECK(check.hasSmoothFont(size) == smooth);
+    }
+    testMatchesDirect(panel, check, direct);
+
+    std::vector<Text> texts = searchScreen();
+    TextCache cache;
+    cache.begin(&panel);
+    double cached = measure(panel, &cache, direct, texts, frames);
+    double uncached = measure(panel, nullptr, direct, texts, frames);
+
+    // Every string is rasterized on the first frame only
+    TextCache::Stats stats = cache.getStats();
+    CHECK(stats.misses == texts.size());
+    CHECK(stats.hits == texts.size() * (frames - 1));
+    CHECK(stats.evictions == 0);
+
+    printf("%-9s %10.1f %10.1f %8.1fx %10.2f %10.2f %8u\n", smooth ? "smooth" : "built-in", uncached, cached,
+           uncached / cached, stats.hits ? (double)stats.hitUs / stats.hits : 0.0,
+           stats.misses ? (double)stats.renderUs / stats.misses : 0.0, stats.bytes / 1024);
+}
+
+int main(int argc, char** argv) {
+    size_t frames = argc > 1 ? strtoul(argv[1], nullptr, 10) : 5000;
+    Serial.enabled = false;
+
+    TFT_eSPI panel(SCREEN_WIDTH, SCREEN_HEIGHT);
+    printf("%zu strings a frame, us per frame drawn directly and from the cache\n", searchScreen().size());
+    printf("%-9s %10s %10s %9s %10s %10s %8s\n", "font", "direct", "cached", "speed-up", "us/hit", "us/miss", "KB");
+    run(panel, false, frames);
+    run(panel, true, frames);
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("text_cache: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""Make the UI's anti-aliased fonts (see include/text_cache.h).
+
+    make_fonts.py [font.ttf] [outdir]    # default DejaVuSans.ttf, data/fonts
+    make_fonts.py verify file.vlw ...
+
+Writes small.vlw, medium.vlw and large.vlw in the TFT_eSPI smooth font
+format, ASCII only, the same files the library's Create_font Processing
+sketch makes. Upload them with `pio run -t uploadfs`. Needs Pillow.
+"""
+
+import os
+import struct
+import sys
+
+# File name, pixel size: line heights close to the built-in font at text
+# sizes 1-3 (8, 16 and 24 px), so the layout does not move
+FONTS = (("small.vlw", 11), ("medium.vlw", 17), ("large.vlw", 24))
+MAX_HEIGHT = 32  # UI_TEXT_MAX_HEIGHT in config.h
+FIRST, LAST = 0x20, 0x7E
+DEFAULT_TTF = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf"
+
+HEADER = struct.Struct(">6i")
+GLYPH = struct.Struct(">7i")
+VERSION = 11
+
+
+def make_font(ttf, pixels):
+    from PIL import Image, ImageDraw, ImageFont
+
+    font = ImageFont.truetype(ttf, pixels)
+    ascent, descent = font.getmetrics()
+    glyphs = []
+    bitmaps = bytearray()
+    for code in range(FIRST, LAST + 1):
+        ch = chr(code)
+        left, top, right, bottom = font.getbbox(ch, anchor="ls")
+        width, height = right - left, bottom - top
+        if code == 0x20 or width <= 0 or height <= 0:
+            left = top = width = height = 0
+        else:
+            image = Image.new("L", (width, height), 0)
+            ImageDraw.Draw(image).text((-left, -top), ch, font=font, fill=255, anchor="ls")
+            bitmaps += image.tobytes()
+        # unicode, height, width, xAdvance, dY (top above the baseline), dX
+        glyphs.append((code, height, width, round(font.getlength(ch)), -top, left, 0))
+
+    data = bytearray(HEADER.pack(len(glyphs), VERSION, pixels, 0, ascent, descent))
+    for glyph in glyphs:
+        data += GLYPH.pack(*glyph)
+    return bytes(data + bitmaps)
+
+
+def read_font(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < HEADER.size:
+        raise ValueError("file too short")
+    count = HEADER.unpack_from(data)[0]
+    glyphs = [GLYPH.unpack_from(data, HEADER.size + i * GLYPH.size) for i in range(count)]
+    bitmap_bytes = sum(height * width for _, height, width, *_ in glyphs)
+    if len(data) != HEADER.size + count * GLYPH.size + bitmap_bytes:
+        raise ValueError("size does not match the glyph table")
+
+    # TFT_eSPI takes the line height from the glyphs, not the header
+    max_ascent = max(dy for _, _, _, _, dy, _, _ in glyphs)
+    max_descent = max(height - dy for _, height, _, _, dy, _, _ in glyphs)
+    return count, max_ascent + max_descent
+
+
+def main(argv):
+    if len(argv) >= 3 and argv[1] == "verify":
+        ok = True
+        for path in argv[2:]:
+            count, height = read_font(path)
+            fits = height <= MAX_HEIGHT
+            ok = ok and fits
+            print("%s: %d glyphs, %d px line%s" % (path, count, height, "" if fits else " (too tall)"))
+        return 0 if ok else 1
+    if len(argv) > 3 or (len(argv) > 1 and argv[1].startswith("-")):
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+
+    ttf = argv[1] if len(argv) > 1 else DEFAULT_TTF
+    outdir = argv[2] if len(argv) > 2 else os.path.join(os.path.dirname(__file__), "..", "data", "fonts")
+    outdir = os.path.normpath(outdir)
+    os.makedirs(outdir, exist_ok=True)
+    for name, pixels in FONTS:
+        path = os.path.join(outdir, name)
+        with open(path, "wb") as f:
+            f.write(make_font(ttf, pixels))
+        count, height = read_font(path)
+        if height > MAX_HEIGHT:
+            print("%s: %d px line is taller than %d" % (path, height, MAX_HEIGHT), file=sys.stderr)
+            return 1
+        print("%s: %d glyphs, %d px line, %d bytes" % (path, count, height, os.path.getsize(path)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
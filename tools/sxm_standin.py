@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""Local stand-in for the m3u8XM server, for checking the radio's HTTP use.
+
+    sxm_standin.py [--port 5000] [--channels 300] [--chunked] [--ttl 1800]
+                   [--stream-url URL] [--idle 30] [--delay-ms 0]
+
+Serves the endpoints SXMClient uses in server mode (USE_SXM_SERVER true):
+GET /api/health, POST /api/login, GET /api/channels (ETag/304, gzip or
+deflate when asked, optionally chunked) and GET /api/stream/<id>. Point
+the radio at it by setting the SXM server to <this machine>:<port>.
+
+Every TCP connection and request is logged, and the totals are printed
+after each new connection and on Ctrl-C or SIGTERM. They should match the
+counters the radio prints every POWER_REPORT_MS:
+
+    SXM: <requests> requests over <connections> connections
+
+With keep-alive working, a channel list followed by a run of zaps to
+uncached channels shows one connection and one request per round-trip.
+
+--delay-ms holds every answer back, like a slow server, so requests from
+the radio's async workers overlap. The summary includes the most requests
+that were ever in flight at once, which should reach SXM_ASYNC_WORKERS
+and never exceed it.
+"""
+
+import argparse
+import gzip
+import hashlib
+import http.server
+import json
+import signal
+import sys
+import threading
+import time
+import zlib
+
+GENRES = ("Pop", "Rock", "Country", "Hip-Hop", "Dance", "Jazz", "Classical", "Talk", "Sports", "Comedy")
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.connections = 0
+        self.requests = 0
+        self.in_flight = 0
+        self.peak = 0
+
+    def connected(self):
+        with self.lock:
+            self.connections += 1
+            return self.connections
+
+    def requested(self):
+        with self.lock:
+            self.requests += 1
+            self.in_flight += 1
+            self.peak = max(self.peak, self.in_flight)
+            return self.in_flight
+
+    def answered(self):
+        with self.lock:
+            self.in_flight -= 1
+
+    def summary(self):
+        with self.lock:
+            per = self.requests / self.connections if self.connections else 0
+            return "%d requests over %d connections (%.1f per connection), at most %d in flight" % (
+                self.requests, self.connections, per, self.peak)
+
+
+def channel_list(count):
+    channels = []
+    for i in range(1, count + 1):
+        channels.append({
+            "id": "ch%d" % i,
+            "name": "Channel %d %s" % (i, GENRES[i % len(GENRES)]),
+            "number": str(i),
+            "genre": GENRES[i % len(GENRES)],
+            "logoUrl": "http://logos.invalid/%d.png" % i,
+        })
+    return json.dumps({"channels": channels}).encode("utf-8")
+
+
+def make_handler(options, stats):
+    body = channel_list(options.channels)
+    etag = '"%s"' % hashlib.sha1(body).hexdigest()[:16]
+
+    class Handler(http.server.BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"  # Keep-alive unless the client says close
+        timeout = options.idle
+
+        def setup(self):
+            super().setup()
+            self.connection_number = stats.connected()
+            self.requests_here = 0
+            self.log_message("connection %d opened; %s", self.connection_number, stats.summary())
+
+        def finish(self):
+            self.log_message("connection %d closed after %d requests", self.connection_number, self.requests_here)
+            super().finish()
+
+        def log_request(self, code="-", size="-"):
+            self.log_message("conn %d req %d: %s -> %s (%d in flight)", self.connection_number, self.requests_here,
+                             self.requestline, code, self.in_flight)
+
+        def handle_one_request(self):
+            self.in_flight = 0
+            try:
+                super().handle_one_request()
+            finally:
+                if self.in_flight:
+                    stats.answered()
+
+        def count(self):
+            self.requests_here += 1
+            self.in_flight = stats.requested()
+            if options.delay_ms:
+                time.sleep(options.delay_ms / 1000.0)
+
+        def send_json(self, doc, status=200):
+            payload = json.dumps(doc).encode("utf-8")
+            self.send_response(status)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(payload)))
+            self.end_headers()
+            self.wfile.write(payload)
+
+        def do_POST(self):
+            self.count()
+            length = int(self.headers.get("Content-Length", 0))
+            self.rfile.read(length)
+            if self.path == "/api/login":
+                self.send_json({"success": True})
+            else:
+                self.send_json({"error": "not found"}, 404)
+
+        def do_GET(self):
+            self.count()
+            if self.path == "/api/health":
+                self.send_json({"status": "ok", "service": "sxm-standin"})
+            elif self.path == "/api/channels":
+                self.send_channels()
+            elif self.path.startswith("/api/stream/"):
+                channel = self.path[len("/api/stream/"):]
+                self.send_json({"streamUrl": options.stream_url.replace("{id}", channel), "expiresIn": options.ttl})
+            else:
+                self.send_json({"error": "not found"}, 404)
+
+        def send_channels(self):
+            if self.headers.get("If-None-Match") == etag:
+                self.send_response(304)
+                self.send_header("ETag", etag)
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+
+            payload = body
+            accept = self.headers.get("Accept-Encoding", "")
+            encoding = None
+            if "gzip" in accept:
+                payload, encoding = gzip.compress(body), "gzip"
+            elif "deflate" in accept:
+                payload, encoding = zlib.compress(body), "deflate"
+
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("ETag", etag)
+            if encoding:
+                self.send_header("Content-Encoding", encoding)
+            if options.chunked:
+                self.send_header("Transfer-Encoding", "chunked")
+                self.end_headers()
+                for start in range(0, len(payload), 1000):
+                    chunk = payload[start:start + 1000]
+                    self.wfile.write(b"%x\r\n%s\r\n" % (len(chunk), chunk))
+                self.wfile.write(b"0\r\n\r\n")
+            else:
+                self.send_header("Content-Length", str(len(payload)))
+                self.end_headers()
+                self.wfile.write(payload)
+
+    return Handler
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--port", type=int, default=5000)
+    parser.add_argument("--channels", type=int, default=300, help="synthetic channels in the list")
+    parser.add_argument("--chunked", action="store_true", help="send the channel list chunked")
+    parser.add_argument("--ttl", type=int, default=1800, help="expiresIn for stream URLs, seconds")
+    parser.add_argument("--stream-url", default="http://streams.invalid/{id}.m3u8",
+                        help="stream URL handed out, {id} is the channel id")
+    parser.add_argument("--idle", type=float, default=30, help="close connections idle this long, seconds")
+    parser.add_argument("--delay-ms", type=int, default=0, help="hold every answer back this long")
+    options = parser.parse_args(argv[1:])
+
+    stats = Stats()
+    server = http.server.ThreadingHTTPServer(("", options.port), make_handler(options, stats))
+    server.daemon_threads = True
+
+    def stop(signum, frame):
+        raise KeyboardInterrupt
+
+    signal.signal(signal.SIGTERM, stop)
+    signal.signal(signal.SIGINT, stop)
+    print("sxm_standin: listening on port %d, %d channels" % (options.port, options.channels), file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    server.server_close()
+    print("sxm_standin: %s" % stats.summary(), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""Local HTTPS stand-in that counts full and resumed TLS handshakes.
+
+    tls_standin.py [--port 8443] [--host 127.0.0.1] [--cert cert.pem --key key.pem]
+                   [--no-tickets] [--tls13] [--body-bytes 16384] [--idle 30]
+
+Every accepted connection completes a handshake and is logged as "full" or
+"resumed", with running totals. The totals are printed again on Ctrl-C or
+SIGTERM. They should match the lines TlsResumingClient prints:
+
+    TLS: <host>:<port> resumed handshake in <ms> ms
+
+Any GET is answered over HTTP/1.1 keep-alive: /api/health with JSON, and
+anything else with --body-bytes of audio/aac filler. A stream URL of
+https://<this machine>:8443/live.aac can then be zapped to and away from.
+
+Without --cert and --key a self-signed certificate for --host is made with
+the openssl command, so the radio has to connect with setInsecure() or
+with that certificate as its CA. The server speaks TLS 1.2 only unless
+--tls13 is given, because mbedtls 2.28 on the ESP32 stops at 1.2.
+--no-tickets turns off session tickets, so resumption has to go through
+session IDs.
+
+Check the server itself with openssl:
+
+    openssl s_client -connect 127.0.0.1:8443 -reconnect -tls1_2 < /dev/null
+
+That is one full handshake followed by five resumed ones.
+"""
+
+import argparse
+import http.server
+import os
+import signal
+import ssl
+import subprocess
+import sys
+import tempfile
+import threading
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.full = 0
+        self.resumed = 0
+        self.failed = 0
+
+    def handshake(self, resumed):
+        with self.lock:
+            if resumed:
+                self.resumed += 1
+            else:
+                self.full += 1
+
+    def failure(self):
+        with self.lock:
+            self.failed += 1
+
+    def summary(self):
+        with self.lock:
+            return "%d full, %d resumed, %d failed handshakes" % (self.full, self.resumed, self.failed)
+
+
+def self_signed(host, directory):
+    cert = os.path.join(directory, "cert.pem")
+    key = os.path.join(directory, "key.pem")
+    subprocess.run(["openssl", "req", "-x509", "-newkey", "ec", "-pkeyopt", "ec_paramgen_curve:prime256v1",
+                    "-nodes", "-days", "30", "-subj", "/CN=%s" % host, "-addext", "subjectAltName=%s:%s" % (
+                        "IP" if host.replace(".", "").isdigit() else "DNS", host),
+                    "-keyout", key, "-out", cert],
+                   check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return cert, key
+
+
+def make_context(options, cert, key):
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.load_cert_chain(cert, key)
+    context.minimum_version = ssl.TLSVersion.TLSv1_2
+    if not options.tls13:
+        context.maximum_version = ssl.TLSVersion.TLSv1_2
+    if options.no_tickets:
+        context.options |= ssl.OP_NO_TICKET
+    # The radio's stop() closes the socket without a close_notify. OpenSSL
+    # 3 treats that as a fatal error and drops the session from its cache,
+    # which would leave only tickets to resume; nginx sets this as well
+    context.options |= getattr(ssl, "OP_IGNORE_UNEXPECTED_EOF", 0)
+    return context
+
+
+def make_handler(options):
+    filler = bytes(options.body_bytes)
+
+    class Handler(http.server.BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+        timeout = options.idle
+
+        def do_GET(self):
+            if self.path == "/api/health":
+                payload, kind = b'{"status": "ok", "service": "tls-standin"}', "application/json"
+            else:
+                payload, kind = filler, "audio/aac"
+            self.send_response(200)
+            self.send_header("Content-Type", kind)
+            self.send_header("Content-Length", str(len(payload)))
+            self.end_headers()
+            self.wfile.write(payload)
+
+        def log_message(self, format, *args):
+            pass  # Handshakes are what this logs
+
+    return Handler
+
+
+class TlsServer(http.server.ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, address, handler, context, stats):
+        super().__init__(address, handler)
+        self.context = context
+        self.stats = stats
+
+    def process_request_thread(self, request, client_address):
+        # The handshake runs on the connection's thread so a slow client
+        # does not hold up accept()
+        try:
+            request.settimeout(10)
+            tls = self.context.wrap_socket(request, server_side=True)
+        except (ssl.SSLError, OSError) as error:
+            self.stats.failure()
+            print("%s: handshake failed: %s; %s" % (client_address[0], error, self.stats.summary()),
+                  file=sys.stderr)
+            request.close()
+            return
+        resumed = tls.session_reused
+        self.stats.handshake(resumed)
+        print("%s: %s handshake, %s, %s; %s" % (client_address[0], "resumed" if resumed else "full",
+                                                 tls.version(), tls.cipher()[0], self.stats.summary()),
+              file=sys.stderr)
+        tls.settimeout(None)
+        super().process_request_thread(tls, client_address)
+
+    def shutdown_request(self, request):
+        # OpenSSL also drops a session whose connection is freed before
+        # this side sent its close_notify
+        if isinstance(request, ssl.SSLSocket):
+            try:
+                request.settimeout(1)
+                request.unwrap()
+            except (ssl.SSLError, OSError):
+                pass
+        super().shutdown_request(request)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--host", default="127.0.0.1", help="name or address for the self-signed certificate")
+    parser.add_argument("--cert", help="PEM certificate chain (default: self-signed)")
+    parser.add_argument("--key", help="PEM private key for --cert")
+    parser.add_argument("--no-tickets", action="store_true", help="resume through session IDs only")
+    parser.add_argument("--tls13", action="store_true", help="allow TLS 1.3 as well")
+    parser.add_argument("--body-bytes", type=int, default=16384, help="size of the filler answer")
+    parser.add_argument("--idle", type=float, default=30, help="close connections idle this long, seconds")
+    options = parser.parse_args(argv[1:])
+
+    with tempfile.TemporaryDirectory() as directory:
+        if options.cert and options.key:
+            cert, key = options.cert, options.key
+        else:
+            cert, key = self_signed(options.host, directory)
+
+        stats = Stats()
+        server = TlsServer(("", options.port), make_handler(options), make_context(options, cert, key), stats)
+
+        def stop(signum, frame):
+            raise KeyboardInterrupt
+
+        signal.signal(signal.SIGTERM, stop)
+        signal.signal(signal.SIGINT, stop)
+        print("tls_standin: listening on port %d, tickets %s" % (options.port, "off" if options.no_tickets else "on"),
+              file=sys.stderr)
+        try:
+            server.serve_forever()
+        except KeyboardInterrupt:
+            pass
+        server.server_close()
+    print("tls_standin: %s" % stats.summary(), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))